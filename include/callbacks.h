@@ -93,6 +93,11 @@ std::unique_ptr<KernelCfgInstrumenter>
 makeCfgInstrumenter(const std::string& name,
                     std::vector<hip::BasicBlock>& blocks);
 
+std::unique_ptr<KernelCfgInstrumenter>
+makeCfgInstrumenter(const std::string& name,
+                    std::vector<hip::BasicBlock>& blocks,
+                    std::unique_ptr<hip::InstrGenerator> instr_gen);
+
 std::unique_ptr<clang::ast_matchers::MatchFinder::MatchCallback>
 makeCudaCallInstrumenter(const std::string& kernel,
                          const std::string& output_file);
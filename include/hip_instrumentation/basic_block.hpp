@@ -10,6 +10,7 @@
 
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace hip {
@@ -88,9 +89,48 @@ struct BasicBlock {
      */
     uint32_t floating_st;
 
+    /** \brief Ids of the instrumented blocks which may execute next, the
+     * non-instrumented blocks of the CFG being skipped. Sorted, and ends with
+     * \ref exit_block if the kernel may return after the block. Empty if the
+     * database predates the CFG information
+     */
+    std::vector<uint32_t> successors;
+
+    /** \brief Successor id standing for the exit of the kernel. Out of the
+     * range of the block ids, so analyses indexing the blocks by successor
+     * have to check the bounds
+     */
+    static constexpr uint32_t exit_block = 0xffffffffu;
+
     // These are allocated as pointers as to reduce the memory footprint on the
     // device
     std::unique_ptr<std::string> begin_loc, end_loc;
 };
 
+/** \struct DeviceBlockInfo
+ * \brief Trivially copyable subset of a \ref BasicBlock, used by the device
+ * reductions. Stored in a table indexed by the block id
+ */
+struct DeviceBlockInfo {
+    uint32_t flops;
+    uint32_t floating_ld;
+    uint32_t floating_st;
+    uint32_t flags;
+
+    /** \brief Flag set if the block is present in the database
+     */
+    static constexpr uint32_t present = 1u;
+
+    /** \fn table
+     * \brief Returns the table of a kernel with bb_count basic blocks. Blocks
+     * missing from the database are zeroed, and ids out of range are ignored
+     */
+    static std::vector<DeviceBlockInfo>
+    table(const std::vector<BasicBlock>& blocks, uint32_t bb_count);
+
+    bool operator==(const DeviceBlockInfo& other) const = default;
+};
+
+static_assert(std::is_trivially_copyable_v<DeviceBlockInfo>);
+
 } // namespace hip
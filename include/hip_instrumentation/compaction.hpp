@@ -0,0 +1,44 @@
+/** \file compaction.hpp
+ * \brief Sparse representation of the instrumentation counters
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hip {
+
+/** \struct SparseCounters
+ * \brief List of non-zero counters, stored as a structure of arrays. Indices
+ * are sorted in ascending order
+ */
+struct SparseCounters {
+    /** \brief Index of the counter in the dense array
+     */
+    std::vector<uint32_t> indices;
+
+    /** \brief Counter value
+     */
+    std::vector<uint8_t> counts;
+
+    size_t size() const { return indices.size(); }
+};
+
+/** \fn compactCounters
+ * \brief Host reference implementation of the on-device compaction : returns
+ * the list of non-zero counters
+ */
+SparseCounters compactCounters(const uint8_t* counters, size_t size);
+
+/** \fn expandCounters
+ * \brief Writes the sparse counters to the dense array output, of size size.
+ * The dense array is zeroed beforehand
+ */
+void expandCounters(const SparseCounters& sparse, uint8_t* output,
+                    size_t size);
+
+} // namespace hip
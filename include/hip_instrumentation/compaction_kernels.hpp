@@ -0,0 +1,179 @@
+/** \file compaction_kernels.hpp
+ * \brief GPU stream compaction of the instrumentation counters (prefix-sum +
+ * scatter), see \ref hip::compactCounters for the host reference
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include "hip/hip_runtime.h"
+
+namespace hip {
+
+namespace compaction {
+
+constexpr unsigned int threads_per_block = 256u;
+
+/** \brief Each thread processes a 16-bytes chunk of counters
+ */
+constexpr unsigned int items_per_thread = 16u;
+
+/** \brief Number of counters processed by a block
+ */
+constexpr unsigned int tile_size = threads_per_block * items_per_thread;
+
+/** \brief Threads used for the (single-block) scan of the tile counts
+ */
+constexpr unsigned int scan_threads = 1024u;
+
+/** \fn loadChunk
+ * \brief Loads the chunk of counters of the thread, using a single 16-bytes
+ * load if possible. Out of bounds counters are set to zero
+ */
+__device__ inline void loadChunk(const uint8_t* counters, uint32_t size,
+                                 uint32_t begin,
+                                 uint8_t (&chunk)[items_per_thread]) {
+    if (begin + items_per_thread <= size) {
+        auto vec = *reinterpret_cast<const uint4*>(&counters[begin]);
+        *reinterpret_cast<uint4*>(chunk) = vec;
+    } else {
+        for (auto i = 0u; i < items_per_thread; ++i) {
+            chunk[i] = (begin + i < size) ? counters[begin + i] : 0u;
+        }
+    }
+}
+
+/** \fn blockExclusiveScan
+ * \brief Block-wide exclusive prefix sum (Hillis-Steele). scratch must hold
+ * 2 * blockDim.x elements. Returns the exclusive prefix of the calling thread,
+ * and the block total in total
+ */
+__device__ inline uint32_t blockExclusiveScan(uint32_t value,
+                                              uint32_t* scratch,
+                                              uint32_t& total) {
+    auto tid = threadIdx.x;
+    auto in = 0u, out = blockDim.x;
+
+    scratch[tid] = value;
+    __syncthreads();
+
+    for (auto offset = 1u; offset < blockDim.x; offset <<= 1) {
+        auto sum = scratch[in + tid];
+        if (tid >= offset) {
+            sum += scratch[in + tid - offset];
+        }
+
+        scratch[out + tid] = sum;
+        __syncthreads();
+
+        auto tmp = in;
+        in = out;
+        out = tmp;
+    }
+
+    auto inclusive = scratch[in + tid];
+    total = scratch[in + blockDim.x - 1];
+    __syncthreads();
+
+    return inclusive - value;
+}
+
+/** \fn countNonZero
+ * \brief Phase 1 : count the non-zero counters of each tile
+ *
+ * \param tile_counts Output array of size gridDim.x
+ */
+__global__ void countNonZero(const uint8_t* counters, uint32_t size,
+                             uint32_t* tile_counts) {
+    __shared__ uint32_t scratch[2 * threads_per_block];
+
+    alignas(16) uint8_t chunk[items_per_thread];
+    loadChunk(counters, size,
+              blockIdx.x * tile_size + threadIdx.x * items_per_thread, chunk);
+
+    uint32_t count = 0u;
+#pragma unroll
+    for (auto i = 0u; i < items_per_thread; ++i) {
+        count += chunk[i] != 0u;
+    }
+
+    uint32_t total;
+    blockExclusiveScan(count, scratch, total);
+
+    if (threadIdx.x == 0) {
+        tile_counts[blockIdx.x] = total;
+    }
+}
+
+/** \fn scanTiles
+ * \brief Phase 2 : in-place exclusive scan of the tile counts, launched with a
+ * single block of scan_threads threads. The total number of non-zero counters
+ * is written to total
+ */
+__global__ void scanTiles(uint32_t* tile_counts, uint32_t nb_tiles,
+                          uint32_t* total) {
+    __shared__ uint32_t scratch[2 * scan_threads];
+
+    uint32_t carry = 0u;
+
+    for (auto base = 0u; base < nb_tiles; base += blockDim.x) {
+        auto i = base + threadIdx.x;
+        auto value = (i < nb_tiles) ? tile_counts[i] : 0u;
+
+        uint32_t sum;
+        auto prefix = blockExclusiveScan(value, scratch, sum);
+
+        if (i < nb_tiles) {
+            tile_counts[i] = carry + prefix;
+        }
+
+        carry += sum;
+    }
+
+    if (threadIdx.x == 0) {
+        *total = carry;
+    }
+}
+
+/** \fn scatterNonZero
+ * \brief Phase 3 : write the non-zero counters to the output arrays, in the
+ * order of the dense array
+ *
+ * \param tile_offsets Exclusive scan of the tile counts (see \ref scanTiles)
+ * \param indices Output indices, of size total
+ * \param counts Output values, of size total
+ */
+__global__ void scatterNonZero(const uint8_t* counters, uint32_t size,
+                               const uint32_t* tile_offsets, uint32_t* indices,
+                               uint8_t* counts) {
+    __shared__ uint32_t scratch[2 * threads_per_block];
+
+    auto begin = blockIdx.x * tile_size + threadIdx.x * items_per_thread;
+
+    alignas(16) uint8_t chunk[items_per_thread];
+    loadChunk(counters, size, begin, chunk);
+
+    uint32_t count = 0u;
+#pragma unroll
+    for (auto i = 0u; i < items_per_thread; ++i) {
+        count += chunk[i] != 0u;
+    }
+
+    uint32_t total;
+    auto offset =
+        tile_offsets[blockIdx.x] + blockExclusiveScan(count, scratch, total);
+
+#pragma unroll
+    for (auto i = 0u; i < items_per_thread; ++i) {
+        if (chunk[i] != 0u) {
+            indices[offset] = begin + i;
+            counts[offset] = chunk[i];
+            ++offset;
+        }
+    }
+}
+
+} // namespace compaction
+
+} // namespace hip
@@ -0,0 +1,113 @@
+/** \file counter_monitor.hpp
+ * \brief Host-side live sampling of instrumentation counters during a kernel
+ * execution
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hip {
+
+/** \struct ProgressSnapshot
+ * \brief Per-basic block totals sampled at a given time during the kernel
+ * execution
+ */
+struct ProgressSnapshot {
+    /** \brief Time elapsed since the monitor was started, in microseconds
+     */
+    uint64_t elapsed;
+
+    /** \brief Per basic-block execution count, summed over every thread. This
+     * is a lower bound of the real value while the kernel runs, as it only
+     * flushes its counters periodically. The remainders are flushed when the
+     * threads commit, so the final snapshot is exact
+     */
+    std::vector<uint64_t> totals;
+};
+
+/** \class CounterMonitor
+ * \brief Polls a host-visible buffer of per-basic block totals, which is
+ * periodically updated by the instrumented kernel. Sampling is performed by a
+ * dedicated thread at a fixed interval
+ */
+class CounterMonitor {
+  public:
+    using live_counter_t = unsigned long long;
+
+    /** ctor
+     * \param bb_count Number of instrumented basic blocks
+     * \param interval Sampling interval
+     */
+    CounterMonitor(unsigned int bb_count, std::chrono::microseconds interval);
+
+    // The buffer is owned by the monitor, delete copy constructor
+    CounterMonitor(const CounterMonitor&) = delete;
+    CounterMonitor& operator=(const CounterMonitor&) = delete;
+
+    /** dtor
+     * \brief Stops the sampling thread (if needed) and frees the buffer
+     */
+    ~CounterMonitor();
+
+    /** \fn start
+     * \brief Resets the counters and starts the sampling thread
+     */
+    void start();
+
+    /** \fn stop
+     * \brief Stops the sampling thread, after recording a final snapshot. The
+     * kernel has to be completed for the final snapshot to be exact
+     */
+    void stop();
+
+    /** \fn devicePtr
+     * \brief Device-side pointer to the live counters, to be passed to the
+     * instrumented kernel
+     */
+    live_counter_t* devicePtr() const { return device_ptr; }
+
+    /** \fn snapshots
+     * \brief Returns a copy of the snapshots recorded so far. Safe to call
+     * while the sampling thread is running
+     */
+    std::vector<ProgressSnapshot> snapshots() const;
+
+    /** \fn latest
+     * \brief Returns the last snapshot taken, or an empty one if none was
+     * recorded
+     */
+    ProgressSnapshot latest() const;
+
+  private:
+    /** \fn sample
+     * \brief Read the live counters and append a snapshot
+     */
+    void sample();
+
+    void run();
+
+    unsigned int bb_count;
+    std::chrono::microseconds interval;
+
+    /** \brief Host-visible (mapped, coherent) memory, and its device alias
+     */
+    live_counter_t* host_ptr = nullptr;
+    live_counter_t* device_ptr = nullptr;
+
+    std::chrono::steady_clock::time_point t0;
+
+    std::atomic<bool> running = false;
+    std::thread sampler;
+
+    mutable std::mutex snapshots_mutex;
+    std::vector<ProgressSnapshot> history;
+};
+
+} // namespace hip
@@ -0,0 +1,45 @@
+/** \file coverage.hpp
+ * \brief One-bit coverage traces : whether a thread executed a basic block,
+ * packed as one 64-bit word per (wavefront, basic block)
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hip {
+
+/** \fn coverageFromCounters
+ * \brief Host reference : computes the coverage bitmasks from the per-thread
+ * counters, laid out as [block][wave][basic block]
+ */
+std::vector<uint64_t> coverageFromCounters(const uint8_t* counters,
+                                           uint32_t total_blocks,
+                                           uint32_t threads_per_block,
+                                           uint32_t bb_count,
+                                           uint32_t wave_size = 64u);
+
+/** \fn activeLanes
+ * \brief Number of lanes which executed each basic block, per wavefront (i.e.
+ * popcount of each word)
+ */
+std::vector<uint8_t> activeLanes(const std::vector<uint64_t>& coverage);
+
+/** \fn threadsPerBlock
+ * \brief Number of threads which executed each basic block, over the whole
+ * kernel
+ */
+std::vector<uint64_t> threadsPerBlock(const std::vector<uint64_t>& coverage,
+                                      uint32_t bb_count);
+
+/** \fn blocksPerWave
+ * \brief Number of basic blocks executed by at least one lane, per wavefront
+ */
+std::vector<uint32_t> blocksPerWave(const std::vector<uint64_t>& coverage,
+                                    uint32_t bb_count);
+
+} // namespace hip
@@ -0,0 +1,65 @@
+/** \file cpu_reductions.hpp
+ * \brief Host reductions of the instrumentation data, for offline traces on
+ * hosts without a GPU. Their results are identical to the GPU reductions (see
+ * reduction_kernels.hpp)
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "basic_block.hpp"
+
+namespace hip {
+
+/** \struct BlockUsage
+ * \brief Total execution count and floating point operations of a basic block
+ */
+struct BlockUsage {
+    uint64_t count;
+    uint64_t flops;
+
+    bool operator==(const BlockUsage& other) const {
+        return count == other.count && flops == other.flops;
+    }
+};
+
+namespace cpu {
+
+/** \fn reduceCounts
+ * \brief Sums the counters of every basic block. The trace is split in tasks
+ * distributed to a pool of threads, see \ref hip::parallelFor. Each task sums
+ * rows of a multiple of bb_count counters in 16-bit accumulators (a widening
+ * byte sum, vectorized by the compiler), periodically flushed to 32-bit
+ * accumulators before they can overflow
+ *
+ * \param counters Instrumentation data, [block][thread][bblock]
+ * \param size Number of counters
+ * \param bb_count Number of basic blocks
+ * \param threads Number of threads, all hardware threads if 0
+ *
+ * \returns A vector of size bb_count
+ */
+std::vector<uint64_t> reduceCounts(const uint8_t* counters, size_t size,
+                                   uint32_t bb_count,
+                                   unsigned int threads = 0u);
+
+/** \fn reduceBlockUsage
+ * \brief Execution count and flops of every basic block, see \ref
+ * reduceCounts
+ *
+ * \param blocks_info Blocks in their normalized form, \ref
+ * hip::BasicBlock::normalized
+ */
+std::vector<BlockUsage>
+reduceBlockUsage(const uint8_t* counters, size_t size,
+                 const std::vector<BasicBlock>& blocks_info, uint32_t bb_count,
+                 unsigned int threads = 0u);
+
+} // namespace cpu
+
+} // namespace hip
@@ -0,0 +1,143 @@
+/** \file divergence.hpp
+ * \brief Wavefront divergence analysis of the per-thread counters
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hip {
+
+/** \struct BlockDivergence
+ * \brief Divergence of a basic block, over all the wavefronts which executed
+ * it (at least one active lane)
+ */
+struct BlockDivergence {
+    /** \brief Wavefronts in which at least one lane executed the block
+     */
+    uint64_t executed_waves = 0u;
+
+    /** \brief Executing wavefronts in which the lanes have different counts
+     */
+    uint64_t divergent_waves = 0u;
+
+    /** \brief Times the block was issued : a wavefront executes the block as
+     * many times as its most active lane (sum of the per-wave maximums)
+     */
+    uint64_t issued = 0u;
+
+    /** \brief Sum of the per-lane counts
+     */
+    uint64_t lane_executions = 0u;
+
+    /** \brief Lane slots of the issued executions, issued * lanes per wave
+     */
+    uint64_t lane_slots = 0u;
+
+    /** \brief Lanes with a non-zero count, in the executing wavefronts
+     */
+    uint64_t active_lanes = 0u;
+
+    /** \brief Lanes of the executing wavefronts
+     */
+    uint64_t lanes = 0u;
+
+    /** \brief Sum of the number of distinct lane counts (zero included) per
+     * executing wavefront
+     */
+    uint64_t distinct_counts = 0u;
+
+    /** \fn efficiency
+     * \brief Fraction of the issued lane slots doing useful work
+     */
+    double efficiency() const {
+        return lane_slots ? static_cast<double>(lane_executions) / lane_slots
+                          : 1.;
+    }
+
+    /** \fn activeFraction
+     * \brief Fraction of the lanes which executed the block at least once
+     */
+    double activeFraction() const {
+        return lanes ? static_cast<double>(active_lanes) / lanes : 1.;
+    }
+
+    /** \fn wastedSlots
+     * \brief Serialization cost : lane slots spent on inactive lanes
+     */
+    uint64_t wastedSlots() const { return lane_slots - lane_executions; }
+
+    void merge(const BlockDivergence& other);
+};
+
+/** \struct WaveDivergence
+ * \brief Divergence of a wavefront, over all basic blocks
+ */
+struct WaveDivergence {
+    uint32_t workgroup;
+    uint32_t wave;
+    uint32_t lanes;
+
+    /** \brief Number of distinct per-lane counter vectors (control paths)
+     */
+    uint32_t distinct_vectors;
+
+    uint64_t issued;
+    uint64_t lane_executions;
+    uint64_t lane_slots;
+
+    double efficiency() const {
+        return lane_slots ? static_cast<double>(lane_executions) / lane_slots
+                          : 1.;
+    }
+
+    uint64_t wastedSlots() const { return lane_slots - lane_executions; }
+};
+
+/** \struct DivergenceReport
+ * \brief Result of \ref analyzeDivergence
+ */
+struct DivergenceReport {
+    /** \brief Per basic block divergence, indexed by block id
+     */
+    std::vector<BlockDivergence> blocks;
+
+    /** \brief Per wavefront divergence, [workgroup][wave]
+     */
+    std::vector<WaveDivergence> waves;
+
+    /** \brief Whole kernel
+     */
+    BlockDivergence total;
+
+    /** \fn worstBlocks
+     * \brief Ids of the (at most) n basic blocks wasting the most lane slots,
+     * worst first
+     */
+    std::vector<uint32_t> worstBlocks(size_t n) const;
+
+    /** \fn worstWaves
+     * \brief Indices in waves of the (at most) n wavefronts wasting the most
+     * lane slots, worst first
+     */
+    std::vector<size_t> worstWaves(size_t n) const;
+};
+
+/** \fn analyzeDivergence
+ * \brief Groups the threads of each workgroup in wavefronts and computes
+ * their divergence. Workgroups are processed in parallel
+ *
+ * \param counters Counters, [block][thread][bblock]
+ * \param threads Number of host threads, all hardware threads if 0
+ */
+DivergenceReport analyzeDivergence(const uint8_t* counters,
+                                   uint32_t total_blocks,
+                                   uint32_t threads_per_block,
+                                   uint32_t bb_count, uint32_t wave_size = 64u,
+                                   unsigned int threads = 0u);
+
+} // namespace hip
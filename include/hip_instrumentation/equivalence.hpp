@@ -0,0 +1,122 @@
+/** \file equivalence.hpp
+ * \brief Thread equivalence classes : threads with identical counter vectors
+ * followed the same control path. Threads are grouped in classes per
+ * wavefront and per workgroup
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hip {
+
+/** \struct EquivalenceStats
+ * \brief Equivalence classes over a set of groups of threads (wavefronts or
+ * workgroups)
+ */
+struct EquivalenceStats {
+    /** \brief Number of groups per number of classes, the last bucket holds
+     * the groups with at least as many classes
+     */
+    std::array<uint64_t, 65> histogram{};
+
+    uint64_t groups = 0u;
+    uint64_t threads = 0u;
+
+    /** \brief Sum of the number of classes of the groups
+     */
+    uint64_t classes = 0u;
+
+    /** \brief Largest number of classes in a group
+     */
+    uint32_t max_classes = 0u;
+
+    /** \brief Sum of the size of the largest class of every group
+     */
+    uint64_t majority_threads = 0u;
+
+    /** \brief Per basic block, number of groups in which its count differs
+     * between classes
+     */
+    std::vector<uint64_t> distinguishing;
+
+    double meanClasses() const {
+        return groups ? static_cast<double>(classes) / groups : 0.;
+    }
+
+    double meanClassSize() const {
+        return classes ? static_cast<double>(threads) / classes : 0.;
+    }
+
+    /** \fn majorityFraction
+     * \brief Fraction of the threads following the most common path of their
+     * group
+     */
+    double majorityFraction() const {
+        return threads ? static_cast<double>(majority_threads) / threads : 1.;
+    }
+
+    /** \fn uniformGroups
+     * \brief Groups whose threads all followed the same path
+     */
+    uint64_t uniformGroups() const { return histogram[1]; }
+
+    void merge(const EquivalenceStats& other);
+};
+
+/** \struct EquivalenceReport
+ * \brief Result of \ref analyzeEquivalence
+ */
+struct EquivalenceReport {
+    EquivalenceStats waves;
+    EquivalenceStats workgroups;
+
+    /** \brief Number of classes of every workgroup
+     */
+    std::vector<uint32_t> workgroup_classes;
+
+    /** \fn worstWorkgroups
+     * \brief Indices of the (at most) n workgroups with the most classes,
+     * worst first
+     */
+    std::vector<uint32_t> worstWorkgroups(size_t n) const;
+
+    /** \fn distinguishingBlocks
+     * \brief The (at most) n basic blocks splitting the most wavefronts in
+     * several classes, worst first
+     */
+    std::vector<uint32_t> distinguishingBlocks(size_t n) const;
+};
+
+/** \fn hashThreads
+ * \brief Hashes the counter vectors of consecutive threads, identical to \ref
+ * hashCounters. The counters of a batch of 64 threads are transposed to
+ * [bblock][lane], so the compiler vectorizes the hash across the lanes
+ *
+ * \param hashes Output, of size threads
+ */
+void hashThreads(const uint8_t* counters, uint32_t threads, uint32_t bb_count,
+                 uint32_t* hashes);
+
+/** \fn analyzeEquivalence
+ * \brief Groups the threads of every wavefront and every workgroup in
+ * equivalence classes. The workgroups are processed in parallel, and the
+ * classes are found with an open-addressing hash table of the counter vectors
+ * (the vectors are compared on hash collisions)
+ *
+ * \param counters Counters, [block][thread][bblock]
+ * \param threads Number of host threads, all hardware threads if 0
+ */
+EquivalenceReport analyzeEquivalence(const uint8_t* counters,
+                                     uint32_t total_blocks,
+                                     uint32_t threads_per_block,
+                                     uint32_t bb_count,
+                                     uint32_t wave_size = 64u,
+                                     unsigned int threads = 0u);
+
+} // namespace hip
@@ -0,0 +1,86 @@
+/** \file flamegraph.hpp
+ * \brief Folded stacks of the basic blocks of a kernel, for the standard
+ * flamegraph scripts (e.g. flamegraph.pl, inferno, speedscope)
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "basic_block.hpp"
+
+namespace hip {
+
+/** \enum FlameWeight
+ * \brief Weight of a basic block in the flamegraph, its execution count times
+ * its static cost
+ */
+enum class FlameWeight {
+    /** \brief Executions of the block
+     */
+    Executions,
+
+    /** \brief Floating point operations
+     */
+    Flops,
+
+    /** \brief Floating point bytes loaded and stored
+     */
+    Bytes
+};
+
+/** \struct FoldedStack
+ * \brief A stack, root first, and its weight
+ */
+struct FoldedStack {
+    std::vector<std::string> frames;
+    uint64_t weight;
+
+    /** \fn line
+     * \brief Folded representation, "frame;frame;... weight"
+     */
+    std::string line() const;
+};
+
+/** \fn foldStacks
+ * \brief One stack per basic block with a non-zero weight :
+ * kernel;[enclosing loops;]file:first-last;bb_<id>
+ *
+ * \param counts Execution count of every basic block, see \ref
+ * cpu::reduceCounts
+ * \param blocks Blocks of the database
+ * \param loops Add a frame for each enclosing loop of the block, outermost
+ * first, see \ref findLoops. Requires the CFG information of the database
+ */
+std::vector<FoldedStack>
+foldStacks(const std::string& kernel, const std::vector<uint64_t>& counts,
+           const std::vector<BasicBlock>& blocks,
+           FlameWeight weight = FlameWeight::Executions, bool loops = false);
+
+/** \fn foldStacks
+ * \brief Folded stacks of a trace, whose counters are reduced in a single
+ * parallel pass
+ *
+ * \param counters Instrumentation data, [block][thread][bblock]
+ * \param size Number of counters
+ * \param threads Number of threads, all hardware threads if 0
+ */
+std::vector<FoldedStack>
+foldStacks(const std::string& kernel, const uint8_t* counters, size_t size,
+           uint32_t bb_count, const std::vector<BasicBlock>& blocks,
+           FlameWeight weight = FlameWeight::Executions, bool loops = false,
+           unsigned int threads = 0u);
+
+/** \fn writeFoldedStacks
+ * \brief Writes the stacks, one per line
+ */
+void writeFoldedStacks(std::ostream& out,
+                       const std::vector<FoldedStack>& stacks);
+
+} // namespace hip
@@ -79,6 +79,11 @@ struct GpuInfo {
      */
     std::string json() const;
 
+    /** \fn fromJson
+     * \brief Load from a json file (see \ref json)
+     */
+    static GpuInfo fromJson(const std::string& filename);
+
     /** \fn benchmark
      * \brief Performs a full benchmark
      */
@@ -0,0 +1,117 @@
+/** \file heatmap.hpp
+ * \brief Heatmap of the counters of a trace, (workgroup or thread) x basic
+ * block, downsampled to a bounded image while the trace is streamed
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "streaming.hpp"
+
+namespace hip {
+
+/** \struct Image
+ * \brief 8-bit RGB image, row-major
+ */
+struct Image {
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> rgb;
+
+    /** \fn writePpm
+     * \brief Writes the image as a binary PPM (P6)
+     */
+    void writePpm(const std::string& filename) const;
+
+    /** \fn writePng
+     * \brief Writes the image as an uncompressed PNG (stored deflate blocks),
+     * to avoid depending on zlib
+     */
+    void writePng(const std::string& filename) const;
+
+    /** \fn write
+     * \brief Writes a PPM if the filename ends with .ppm, a PNG otherwise
+     */
+    void write(const std::string& filename) const;
+};
+
+/** \class HeatmapReducer
+ * \brief Accumulates the counters in a grid of at most max_rows x max_columns
+ * cells. Each row of the heatmap is a tile of consecutive workgroups (or
+ * threads), each column a range of basic blocks. The memory usage only
+ * depends on the size of the grid
+ */
+class HeatmapReducer : public ChunkReducer {
+  public:
+    /** \enum Rows
+     * \brief What the rows of the heatmap stand for. A workgroup cell holds
+     * the sum over the threads of the workgroup
+     */
+    enum class Rows { Workgroups, Threads };
+
+    /** ctor
+     * \param threads Number of host threads, all hardware threads if 0
+     */
+    HeatmapReducer(uint32_t total_blocks, uint32_t threads_per_block,
+                   uint32_t bb_count, Rows rows = Rows::Workgroups,
+                   uint32_t max_rows = 1024u, uint32_t max_columns = 1024u,
+                   unsigned int threads = 0u);
+
+    /** \fn reduce
+     * \brief Accumulates the chunk, in parallel over the rows of the heatmap
+     */
+    void reduce(const TraceChunk& chunk) override;
+
+    uint32_t rows() const { return height; }
+    uint32_t columns() const { return width; }
+
+    /** \fn cell
+     * \brief Mean value of the trace cells of a heatmap cell
+     */
+    double cell(uint32_t row, uint32_t column) const;
+
+    /** \fn image
+     * \brief Renders the heatmap, each cell being cell_width x cell_height
+     * pixels. Values are normalized to the largest cell, on a logarithmic
+     * scale if log_scale
+     */
+    Image image(bool log_scale = true, uint32_t cell_width = 1u,
+                uint32_t cell_height = 1u) const;
+
+  private:
+    /** \fn sourceBegin
+     * \brief First trace row (or basic block) of a heatmap row (or column)
+     */
+    static uint64_t sourceBegin(uint32_t cell, uint64_t sources,
+                                uint32_t cells) {
+        return (cell * sources + cells - 1) / cells;
+    }
+
+    uint32_t threads_per_block;
+    uint32_t bb_count;
+    Rows row_kind;
+    unsigned int threads;
+
+    /** \brief Number of trace rows, workgroups or threads
+     */
+    uint64_t source_rows;
+
+    uint32_t height;
+    uint32_t width;
+
+    /** \brief Heatmap column of every basic block
+     */
+    std::vector<uint32_t> column_of;
+
+    /** \brief Sums of the counters, [row][column]
+     */
+    std::vector<uint64_t> sums;
+};
+
+} // namespace hip
@@ -8,10 +8,21 @@
 
 #include "hip/hip_runtime.h"
 
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include "basic_block.hpp"
+#include "compaction.hpp"
+#include "cpu_reductions.hpp"
+#include "coverage.hpp"
+#include "counter_monitor.hpp"
 #include "hip_utils.hpp"
+#include "signatures.hpp"
 
 namespace hip {
 
@@ -21,12 +32,19 @@ namespace hip {
  */
 struct KernelInfo {
     KernelInfo(const std::string& _name, unsigned int bblocks, dim3 blcks,
-               dim3 t_p_blcks)
+               dim3 t_p_blcks, unsigned int wave = default_wave_size)
         : name(_name), basic_blocks(bblocks), blocks(blcks),
           threads_per_blocks(t_p_blcks),
           total_blocks(blcks.x * blcks.y * blcks.z),
           total_threads_per_blocks(t_p_blcks.x * t_p_blcks.y * t_p_blcks.z),
-          instr_size(basic_blocks * total_blocks * total_threads_per_blocks) {}
+          instr_size(basic_blocks * total_blocks * total_threads_per_blocks),
+          wave_size(wave),
+          waves_per_block((total_threads_per_blocks + wave - 1) / wave),
+          coverage_size(basic_blocks * total_blocks * waves_per_block) {}
+
+    /** \brief Default wavefront size (GCN & CDNA)
+     */
+    static constexpr unsigned int default_wave_size = 64u;
 
     const std::string name;
     const dim3 blocks, threads_per_blocks;
@@ -36,6 +54,16 @@ struct KernelInfo {
     const uint32_t total_threads_per_blocks;
     const uint32_t instr_size;
 
+    /** \brief Wavefront geometry
+     */
+    const uint32_t wave_size;
+    const uint32_t waves_per_block;
+
+    /** \brief Number of 64-bit words in coverage mode (one per wavefront and
+     * basic block)
+     */
+    const uint32_t coverage_size;
+
     /** \fn dump
      * \brief Prints on the screen the data held by the struct
      */
@@ -49,6 +77,29 @@ struct KernelInfo {
     static KernelInfo fromJson(const std::string& filename);
 };
 
+template <typename... Metrics> struct BlockMetrics;
+class SummaryWriter;
+
+/** \struct SignatureBuffers
+ * \brief Device buffers for the signature instrumentation mode, in addition
+ * to the counters (which hold the per-workgroup dictionaries)
+ */
+struct SignatureBuffers {
+    /** \brief Number of unique signatures per workgroup
+     */
+    uint32_t* counts;
+
+    /** \brief Per-thread signature index
+     */
+    signature_index_t* indices;
+};
+
+/** \fn getRoctracerStamp
+ * \brief Returns the current roctracer timestamp, in the rocprofiler realtime
+ * clock domain
+ */
+uint64_t getRoctracerStamp();
+
 /** \class Instrumenter
  * \brief Instrumentation instance, holding host-side counters. It can either be
  * used for instrumentation or post-mortem analysis ( see \ref loadCsv and \ref
@@ -62,6 +113,10 @@ class Instrumenter {
      */
     Instrumenter(KernelInfo& kernel_info);
 
+    /** \brief dtor. Frees the buffers allocated by \ref allocDevice
+     */
+    ~Instrumenter();
+
     // ----- Device data collection ----- //
 
     /** \fn dumpBin
@@ -81,12 +136,133 @@ class Instrumenter {
      */
     void fromDevice(void* device_ptr);
 
+    /** \fn fromDeviceSparse
+     * \brief Compacts the counters on the device and fetches back only the
+     * non-zero values. The dense counters are expanded lazily, on the first
+     * call to \ref data
+     */
+    void fromDeviceSparse(void* device_ptr);
+
+    /** \fn toDeviceSignatures
+     * \brief Allocates the additional buffers required by the signature
+     * instrumentation mode
+     */
+    SignatureBuffers toDeviceSignatures();
+
+    /** \fn toDeviceCoverage
+     * \brief Allocates and zeroes the coverage bitmasks on the device, one
+     * 64-bit word per (wavefront, basic block)
+     */
+    uint64_t* toDeviceCoverage();
+
+    /** \fn fromDeviceCoverage
+     * \brief Fetches back the coverage bitmasks
+     */
+    void fromDeviceCoverage(const uint64_t* device_ptr);
+
+    /** \fn fromDeviceSignatures
+     * \brief Fetches back the deduplicated counters (unique signatures and
+     * per-thread indices) and reconstructs the full counters, both on the host
+     * and in device_ptr so that device-side reductions remain valid. Frees the
+     * signature buffers
+     */
+    void fromDeviceSignatures(void* device_ptr, SignatureBuffers buffers);
+
+    // ----- Graph-safe instrumentation ----- //
+
+    /** \fn allocDevice
+     * \brief Allocates the device counters and a pinned host staging buffer,
+     * only once for the lifetime of the instrumenter, sized for the geometry of
+     * the kernel info (see \ref GraphInstrumenters for launches of varying
+     * geometry). Legal during a stream capture, as the allocation is performed
+     * in relaxed capture mode. Returns the device pointer
+     */
+    counter_t* allocDevice();
+
+    /** \fn recordToDevice
+     * \brief Zeroes the device counters asynchronously on stream, then stamps
+     * the launch with a host function. Recorded as memset and host nodes when
+     * the stream is being captured
+     */
+    void recordToDevice(hipStream_t stream = nullptr);
+
+    /** \fn recordFromDevice
+     * \brief Copies the device counters to the staging buffer asynchronously
+     * on stream, then to the host counters with a host function. Recorded as
+     * memcpy and host nodes when the stream is being captured
+     */
+    void recordFromDevice(hipStream_t stream = nullptr);
+
+    /** \fn fetchStaging
+     * \brief Copies the staging buffer to the host counters, and records the
+     * launch on the timeline and in the online statistics and summary store
+     * (reduced on the host). Called by the host function enqueued by \ref
+     * recordFromDevice
+     */
+    void fetchStaging();
+
+    // ----- Live monitoring ----- //
+
+    /** \fn startMonitor
+     * \brief Allocates a host-visible buffer of per-basic block totals and
+     * starts sampling it at a fixed interval. Returns the device pointer to be
+     * passed to a kernel instrumented in live mode
+     */
+    CounterMonitor::live_counter_t*
+    startMonitor(std::chrono::microseconds interval);
+
+    /** \fn stopMonitor
+     * \brief Stops sampling the live counters. To be called once the kernel
+     * has completed
+     */
+    void stopMonitor();
+
+    /** \fn snapshots
+     * \brief Progress snapshots recorded by the live monitor. Can be called
+     * while the kernel is still running
+     */
+    std::vector<ProgressSnapshot> snapshots() const;
+
     // ----- Save & load data ----- //
 
     /** \fn data
      * \brief Const ref to the host counters
      */
-    const std::vector<counter_t>& data() const { return host_counters; }
+    const std::vector<counter_t>& data() const;
+
+    /** \fn sparseData
+     * \brief Non-zero counters, only valid after a call to \ref
+     * fromDeviceSparse or after loading a sparse trace
+     */
+    const SparseCounters& sparseData() const { return sparse_counters; }
+
+    /** \fn signatures
+     * \brief Per-workgroup control-path signatures, only valid after a call
+     * to \ref fromDeviceSignatures or after loading a signature trace
+     */
+    const SignatureTrace& signatures() const { return signature_trace; }
+
+    /** \fn coverage
+     * \brief Coverage bitmasks, laid out as [block][wave][basic block]. Only
+     * valid in coverage mode
+     */
+    const std::vector<uint64_t>& coverage() const { return host_coverage; }
+
+    /** \fn kernelStamps
+     * \brief Roctracer stamps (ns) taken right before the launch (\ref
+     * toDevice) and after the completion (\ref fromDevice) of the kernel. They
+     * are saved in the traces
+     */
+    std::pair<uint64_t, uint64_t> kernelStamps() const {
+        return {stamp_begin, stamp_end};
+    }
+
+    /** \fn appendSummary
+     * \brief Appends the per-basic block totals of the last launch to a
+     * summary store (see summary_store.hpp). Launches are also recorded
+     * automatically to \ref summary_env_var, if set
+     */
+    void appendSummary(SummaryWriter& store) const;
 
     /** \fn dumpCsv
      * \brief Dump the data in a csv format. If no filename is given, it is
@@ -100,18 +276,65 @@ class Instrumenter {
      */
     void dumpBin(const std::string& filename = "");
 
+    /** \fn dumpSparseBin
+     * \brief Dump the non-zero counters only, as a list of (index, count)
+     * pairs. Can be loaded back with \ref loadBin
+     */
+    void dumpSparseBin(const std::string& filename = "");
+
+    /** \fn dumpSignatures
+     * \brief Dump the deduplicated counters : per-workgroup dictionaries of
+     * unique signatures and per-thread indices. Can be loaded back with \ref
+     * loadBin
+     */
+    void dumpSignatures(const std::string& filename = "");
+
+    /** \fn dumpCoverage
+     * \brief Dump the coverage bitmasks. Can be loaded back with \ref loadBin
+     */
+    void dumpCoverage(const std::string& filename = "");
+
     /** \fn loadCsv
      * \brief Load data from a csv-formated file.
      */
     size_t loadCsv(const std::string& filename);
 
     /** \fn loadBin
-     * \brief Load data from a packed binary format (see \ref dumpBin).
+     * \brief Load data from a packed binary format (see \ref dumpBin, \ref
+     * dumpSparseBin, \ref dumpSignatures and \ref dumpCoverage).
      */
     size_t loadBin(const std::string& filename);
 
     // ----- Post-instrumentation reduce ----- //
 
+    /** \fn reduceBlockUsage
+     * \brief Compute the total execution count and floating point operations
+     * of every basic block from the host counters (e.g. a trace loaded with
+     * \ref loadBin). Reduced on the device if there is one, with the
+     * multi-threaded host engine (\ref cpu::reduceBlockUsage) otherwise
+     */
+    std::vector<BlockUsage> reduceBlockUsage() const;
+
+    /** \fn deviceBlocksInfo
+     * \brief Device copy of the block table (see \ref DeviceBlockInfo), built
+     * by \ref loadDatabase. Uploaded once per device and distinct table, and
+     * shared by all the reductions and instrumenters using the same table. The
+     * copies are never modified nor released
+     */
+    const DeviceBlockInfo* deviceBlocksInfo() const;
+
+    /** \fn reduceBlockUsage
+     * \brief Compute the total execution count and floating point operations
+     * of every basic block, on the device. See \ref cpu::reduceBlockUsage for
+     * the host equivalent
+     *
+     * \param device_ptr Pointer to the (device) instrumentation data
+     * \param stream Synchronization stream. If nullptr, synchronizes the device
+     */
+    std::vector<BlockUsage>
+    reduceBlockUsage(const counter_t* device_ptr,
+                     hipStream_t stream = nullptr) const;
+
     /** \fn reduceFlops
      * \brief Compute the number of floating point operations in the
      * instrumented kernel execution
@@ -119,22 +342,93 @@ class Instrumenter {
      * \param device_ptr Pointer to the (device) instrumentation data
      * \param stream Synchronization stream. If nullptr, synchronizes the device
      */
-    unsigned int reduceFlops(const counter_t* device_ptr,
-                             hipStream_t stream = nullptr) const;
+    uint64_t reduceFlops(const counter_t* device_ptr,
+                         hipStream_t stream = nullptr) const;
+
+    /** \fn reduce
+     * \brief Reduce the counters per basic block for every metric in a single
+     * pass, see hip::metrics. Defined in metrics_kernels.hpp, which contains
+     * device code. The set of every metric is instantiated in the library
+     *
+     * \param device_ptr Pointer to the (device) instrumentation data
+     * \param stream Synchronization stream. If nullptr, synchronizes the device
+     */
+    template <typename... Metrics>
+    std::vector<BlockMetrics<Metrics...>>
+    reduce(const counter_t* device_ptr, hipStream_t stream = nullptr) const;
 
   private:
+    enum class TraceFormat { Dense, Sparse, Signatures, Coverage };
+
     /** \fn parseHeader
-     * \brief Validate header from binary trace
+     * \brief Validate header from binary trace. For sparse and signature
+     * traces, entries is set to the number of non-zero counters or unique
+     * signatures
      */
-    bool parseHeader(const std::string& header);
+    bool parseHeader(const std::string& header, TraceFormat& format,
+                     size_t& entries);
 
     std::string autoFilenamePrefix() const;
 
-    std::vector<counter_t> host_counters;
+    /** \fn traceUpload
+     * \brief Records the allocation of the device buffers, from begin to the
+     * launch, on the timeline (see \ref TimelineWriter::global)
+     */
+    void traceUpload(const char* name, uint64_t begin) const;
+
+    /** \fn traceLaunch
+     * \brief Records the kernel execution and the transfer back of the
+     * instrumentation data, which just completed, on the timeline
+     */
+    void traceLaunch(const char* transfer) const;
+
+    /** \fn launchTotals
+     * \brief Per-basic block totals of the last launch. Reduced on the device
+     * if device_ptr is not null and the block database is loaded, on the host
+     * otherwise
+     */
+    std::vector<uint64_t> launchTotals(const counter_t* device_ptr) const;
+
+    /** \fn recordLaunch
+     * \brief Accounts for the launch which just completed in the online
+     * statistics (\ref stats_env_var) and the summary store of the kernel
+     * (\ref summary_env_var), if enabled
+     */
+    void recordLaunch(const counter_t* device_ptr) const;
+
+    /** \fn expandSparse
+     * \brief Writes the sparse counters to the dense host counters
+     */
+    void expandSparse() const;
+
+    /** \brief Dense counters. Mutable as they might be lazily expanded from the
+     * sparse counters
+     */
+    mutable std::vector<counter_t> host_counters;
+    mutable bool dense_up_to_date = true;
+
+    SparseCounters sparse_counters;
+    SignatureTrace signature_trace;
+    std::vector<uint64_t> host_coverage;
+
     KernelInfo kernel_info;
 
     std::vector<hip::BasicBlock> blocks;
 
+    /** \brief Block table of the database, for the device reductions
+     */
+    std::vector<DeviceBlockInfo> block_table;
+
+    /** \brief Buffers owned by the instrumenter, for graph-safe mode
+     */
+    counter_t* graph_device_counters = nullptr;
+    counter_t* graph_staging = nullptr;
+
+    /** \brief Live counters sampler, only allocated in live mode
+     */
+    std::unique_ptr<CounterMonitor> monitor;
+    uint64_t monitor_begin = 0u;
+
     /** \brief std::chrono stamp for quick identification
      */
     uint64_t stamp;
@@ -145,4 +439,35 @@ class Instrumenter {
     uint64_t stamp_end;
 };
 
+/** \class GraphInstrumenters
+ * \brief Graph-safe instrumenters of a launch site, one per launch geometry :
+ * the buffers of an instrumenter are sized once for its geometry, and have to
+ * outlive the graphs in which they were captured. Every graph and replay of
+ * the same site and geometry shares the same counters, concurrent replays
+ * therefore race on them
+ */
+class GraphInstrumenters {
+  public:
+    /** \brief ctor
+     */
+    GraphInstrumenters(const std::string& kernel_name, unsigned int bblocks)
+        : name(kernel_name), basic_blocks(bblocks) {}
+
+    /** \fn get
+     * \brief Instrumenter of the launch geometry, created on the first launch
+     * with this geometry
+     */
+    Instrumenter& get(dim3 blocks, dim3 threads);
+
+  private:
+    using geometry_t = std::tuple<uint32_t, uint32_t, uint32_t, uint32_t,
+                                  uint32_t, uint32_t>;
+
+    const std::string name;
+    const unsigned int basic_blocks;
+
+    std::mutex mutex;
+    std::map<geometry_t, std::unique_ptr<Instrumenter>> instrumenters;
+};
+
 } // namespace hip
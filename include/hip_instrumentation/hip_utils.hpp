@@ -31,4 +31,22 @@ inline std::unique_ptr<hipDeviceProp_t> init(int device = 0) {
     return properties;
 }
 
+/** \fn hasDevice
+ * \brief Returns true if at least one device is available
+ */
+inline bool hasDevice() {
+    int count = 0;
+    return hipGetDeviceCount(&count) == hipSuccess && count > 0;
+}
+
+/** \fn waveSize
+ * \brief Wavefront size (warpSize) of the current device
+ */
+inline unsigned int waveSize() {
+    int device, size;
+    check(hipGetDevice(&device));
+    check(hipDeviceGetAttribute(&size, hipDeviceAttributeWarpSize, device));
+    return static_cast<unsigned int>(size);
+}
+
 } // namespace hip
@@ -0,0 +1,67 @@
+/** \file intensity.hpp
+ * \brief Arithmetic intensity of a kernel from its dynamic basic block counts
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "basic_block.hpp"
+
+namespace hip {
+
+/** \struct BlockIntensity
+ * \brief Dynamic floating point operations and memory traffic
+ */
+struct BlockIntensity {
+    uint64_t count = 0u;
+    uint64_t flops = 0u;
+
+    /** \brief Bytes loaded and stored for floating point data
+     */
+    uint64_t bytes = 0u;
+
+    /** \fn intensity
+     * \brief Arithmetic intensity, in FLOPs/byte. 0 if the block does not
+     * access memory
+     */
+    double intensity() const {
+        return bytes ? static_cast<double>(flops) / bytes : 0.;
+    }
+};
+
+/** \struct ArithmeticIntensity
+ * \brief Per basic block and whole kernel arithmetic intensity
+ */
+struct ArithmeticIntensity {
+    /** \brief Indexed by basic block id
+     */
+    std::vector<BlockIntensity> blocks;
+
+    BlockIntensity total;
+};
+
+/** \fn arithmeticIntensity
+ * \brief Computes the arithmetic intensity from the execution count of every
+ * basic block (e.g. \ref cpu::reduceCounts)
+ */
+ArithmeticIntensity arithmeticIntensity(const std::vector<uint64_t>& counts,
+                                        const std::vector<BasicBlock>& blocks);
+
+/** \fn arithmeticIntensity
+ * \brief Computes the arithmetic intensity of a trace. The counters are summed
+ * in a single (multi-threaded) pass over the trace
+ *
+ * \param counters Instrumentation data, [block][thread][bblock]
+ * \param threads Number of threads, all hardware threads if 0
+ */
+ArithmeticIntensity arithmeticIntensity(const uint8_t* counters, size_t size,
+                                        const std::vector<BasicBlock>& blocks,
+                                        uint32_t bb_count,
+                                        unsigned int threads = 0u);
+
+} // namespace hip
@@ -0,0 +1,178 @@
+/** \file loops.hpp
+ * \brief Loop detection in the instrumented CFG and per-thread trip count
+ * distributions
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "basic_block.hpp"
+
+namespace hip {
+
+/** \struct Loop
+ * \brief Natural loop of the instrumented CFG
+ */
+struct Loop {
+    /** \brief Block dominating the loop, target of the back edges
+     */
+    uint32_t header;
+
+    /** \brief Blocks of the loop, header included, sorted
+     */
+    std::vector<uint32_t> body;
+
+    /** \brief Sources of the back edges
+     */
+    std::vector<uint32_t> latches;
+
+    /** \brief Predecessors of the header outside of the loop
+     */
+    std::vector<uint32_t> entries;
+
+    /** \brief Nesting depth, 1 for an outermost loop
+     */
+    uint32_t depth;
+
+    /** \brief Every latch branches unconditionally to the header, so each of
+     * their executions is a back edge
+     */
+    bool unconditional_latches = false;
+};
+
+/** \fn findLoops
+ * \brief Detects the natural loops from the successors stored in the database.
+ * Loops sharing a header are merged. Blocks without predecessors are the entry
+ * points of the CFG
+ *
+ * \param blocks Blocks in their normalized form, see \ref
+ * BasicBlock::normalized
+ */
+std::vector<Loop> findLoops(const std::vector<BasicBlock>& blocks);
+
+/** \struct LoopTrips
+ * \brief Trip count distribution of a loop. The trip count of a thread is the
+ * execution count of the header divided by the number of times the thread
+ * entered the loop, rounded. With unconditional latches, the loop was entered
+ * count(header) - sum(count(latches)) times, whether or not the entries
+ * always branch to the header. Otherwise, the executions of the entries are
+ * used.
+ *
+ * The trip count is the number of header executions : when the header tests
+ * the condition (for and while loops), it runs once more to exit, and a loop
+ * of n iterations has n + 1 trips
+ */
+struct LoopTrips {
+    /** \brief Threads per trip count, for the threads which entered the loop
+     */
+    std::array<uint64_t, 256> histogram{};
+
+    /** \brief Threads which entered the loop
+     */
+    uint64_t threads = 0u;
+
+    /** \brief Sum of the per-thread trip counts
+     */
+    uint64_t iterations = 0u;
+
+    /** \brief Wavefronts in which at least a lane entered the loop
+     */
+    uint64_t waves = 0u;
+
+    /** \brief Wavefronts in which the lanes have different trip counts
+     */
+    uint64_t imbalanced_waves = 0u;
+
+    /** \brief Iterations executed by the wavefronts : as many as the lane
+     * with the most iterations (sum of the per-wave maximums)
+     */
+    uint64_t issued = 0u;
+
+    /** \brief Lane slots of the issued iterations, issued * lanes per wave
+     */
+    uint64_t lane_slots = 0u;
+
+    double meanTrips() const {
+        return threads ? static_cast<double>(iterations) / threads : 0.;
+    }
+
+    /** \fn efficiency
+     * \brief Fraction of the issued lane slots executing an iteration
+     */
+    double efficiency() const {
+        return lane_slots ? static_cast<double>(iterations) / lane_slots : 1.;
+    }
+
+    /** \fn wastedSlots
+     * \brief Lane slots idling while other lanes iterate
+     */
+    uint64_t wastedSlots() const { return lane_slots - iterations; }
+
+    /** \fn maxTrips
+     * \brief Largest per-thread trip count
+     */
+    uint32_t maxTrips() const;
+
+    void merge(const LoopTrips& other);
+};
+
+/** \struct WaveImbalance
+ * \brief Trip count imbalance of a loop in a wavefront
+ */
+struct WaveImbalance {
+    uint32_t loop;
+    uint32_t workgroup;
+    uint32_t wave;
+    uint32_t min_trips;
+    uint32_t max_trips;
+    uint32_t lanes;
+    uint64_t iterations;
+
+    uint64_t wastedSlots() const {
+        return static_cast<uint64_t>(max_trips) * lanes - iterations;
+    }
+};
+
+/** \struct LoopReport
+ * \brief Result of \ref analyzeLoops
+ */
+struct LoopReport {
+    std::vector<Loop> loops;
+
+    /** \brief Trip counts, indexed as loops
+     */
+    std::vector<LoopTrips> trips;
+
+    /** \brief Most imbalanced (loop, wavefront) pairs, worst first
+     */
+    std::vector<WaveImbalance> worst_waves;
+
+    /** \fn worstLoops
+     * \brief Indices of the (at most) n loops wasting the most lane slots,
+     * worst first
+     */
+    std::vector<size_t> worstLoops(size_t n) const;
+};
+
+/** \fn analyzeLoops
+ * \brief Detects the loops and computes the per-thread trip counts from the
+ * counters. Workgroups are processed in parallel
+ *
+ * \param counters Counters, [block][thread][bblock]
+ * \param blocks Blocks in their normalized form, with their successors
+ * \param kept_waves Number of imbalanced wavefronts to report
+ * \param threads Number of host threads, all hardware threads if 0
+ */
+LoopReport analyzeLoops(const uint8_t* counters, uint32_t total_blocks,
+                        uint32_t threads_per_block, uint32_t bb_count,
+                        const std::vector<BasicBlock>& blocks,
+                        uint32_t wave_size = 64u, size_t kept_waves = 64u,
+                        unsigned int threads = 0u);
+
+} // namespace hip
@@ -0,0 +1,193 @@
+/** \file metrics.hpp
+ * \brief Generic per-basic block reduction of the counters, with metrics as
+ * compile-time policies fused in a single pass
+ *
+ * \details A metric policy provides a value_type, an identity element, a map
+ * function (from a counter value and its basic block to a value) and an
+ * associative combine function. Any number of policies can be reduced at once
+ * with \ref hip::Instrumenter::reduce, e.g.
+ *
+ *      auto results = instr.reduce<metrics::Count, metrics::Flops>(ptr);
+ *      results[bb].get<metrics::Flops>();
+ *
+ * The reduction of every metric at once (\ref AllMetrics) is instantiated in
+ * the library. Other sets need the device code of metrics_kernels.hpp, which
+ * has to be compiled with hipcc
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include "hip/hip_runtime.h"
+
+#include <vector>
+
+#include "basic_block.hpp"
+#include "hip_instrumentation.hpp"
+
+namespace hip {
+
+namespace metrics {
+
+/** \struct Count
+ * \brief Number of executions of the basic block
+ */
+struct Count {
+    using value_type = uint64_t;
+    static constexpr value_type identity = 0u;
+
+    __host__ __device__ static value_type
+    map(uint8_t count, const hip::DeviceBlockInfo& block) {
+        return count;
+    }
+
+    __host__ __device__ static value_type combine(value_type lhs,
+                                                  value_type rhs) {
+        return lhs + rhs;
+    }
+};
+
+/** \struct Flops
+ * \brief Floating point operations
+ */
+struct Flops : public Count {
+    __host__ __device__ static value_type
+    map(uint8_t count, const hip::DeviceBlockInfo& block) {
+        return static_cast<value_type>(count) * block.flops;
+    }
+};
+
+/** \struct FloatingLoads
+ * \brief Bytes loaded for floating point data
+ */
+struct FloatingLoads : public Count {
+    __host__ __device__ static value_type
+    map(uint8_t count, const hip::DeviceBlockInfo& block) {
+        return static_cast<value_type>(count) * block.floating_ld;
+    }
+};
+
+/** \struct FloatingStores
+ * \brief Bytes stored for floating point data
+ */
+struct FloatingStores : public Count {
+    __host__ __device__ static value_type
+    map(uint8_t count, const hip::DeviceBlockInfo& block) {
+        return static_cast<value_type>(count) * block.floating_st;
+    }
+};
+
+/** \struct SumOfSquares
+ * \brief Sum of the squared per-thread counts, to compute the variance along
+ * with \ref Count
+ */
+struct SumOfSquares : public Count {
+    __host__ __device__ static value_type
+    map(uint8_t count, const hip::DeviceBlockInfo& block) {
+        return static_cast<value_type>(count) * count;
+    }
+};
+
+/** \struct Min
+ * \brief Minimum per-thread count
+ */
+struct Min {
+    using value_type = uint32_t;
+    static constexpr value_type identity = 0xffffffffu;
+
+    __host__ __device__ static value_type
+    map(uint8_t count, const hip::DeviceBlockInfo& block) {
+        return count;
+    }
+
+    __host__ __device__ static value_type combine(value_type lhs,
+                                                  value_type rhs) {
+        return lhs < rhs ? lhs : rhs;
+    }
+};
+
+/** \struct Max
+ * \brief Maximum per-thread count
+ */
+struct Max {
+    using value_type = uint32_t;
+    static constexpr value_type identity = 0u;
+
+    __host__ __device__ static value_type
+    map(uint8_t count, const hip::DeviceBlockInfo& block) {
+        return count;
+    }
+
+    __host__ __device__ static value_type combine(value_type lhs,
+                                                  value_type rhs) {
+        return lhs > rhs ? lhs : rhs;
+    }
+};
+
+} // namespace metrics
+
+/** \struct MetricValue
+ * \brief Storage for a single metric
+ */
+template <typename Metric> struct MetricValue {
+    typename Metric::value_type value;
+};
+
+/** \struct BlockMetrics
+ * \brief Reduced values of all metrics for a basic block. Trivially
+ * constructible, so it can be used in shared memory : use \ref identity to
+ * initialize it
+ */
+template <typename... Metrics> struct BlockMetrics : MetricValue<Metrics>... {
+    template <typename Metric>
+    __host__ __device__ typename Metric::value_type& get() {
+        return static_cast<MetricValue<Metric>&>(*this).value;
+    }
+
+    template <typename Metric>
+    __host__ __device__ const typename Metric::value_type& get() const {
+        return static_cast<const MetricValue<Metric>&>(*this).value;
+    }
+
+    __host__ __device__ static BlockMetrics identity() {
+        BlockMetrics ret;
+        ((ret.template get<Metrics>() = Metrics::identity), ...);
+        return ret;
+    }
+
+    /** \fn accumulate
+     * \brief Accumulate a single counter value
+     */
+    __host__ __device__ void accumulate(uint8_t count,
+                                        const hip::DeviceBlockInfo& block) {
+        ((get<Metrics>() =
+              Metrics::combine(get<Metrics>(), Metrics::map(count, block))),
+         ...);
+    }
+
+    /** \fn merge
+     * \brief Combine with a partial result
+     */
+    __host__ __device__ void merge(const BlockMetrics& other) {
+        ((get<Metrics>() = Metrics::combine(
+              get<Metrics>(), other.template get<Metrics>())),
+         ...);
+    }
+};
+
+/** \brief Every metric. The reduction of this set is instantiated in the
+ * library, and can be used from host code compiled without hipcc
+ */
+using AllMetrics =
+    BlockMetrics<metrics::Count, metrics::Flops, metrics::FloatingLoads,
+                 metrics::FloatingStores, metrics::SumOfSquares, metrics::Min,
+                 metrics::Max>;
+
+extern template std::vector<AllMetrics>
+Instrumenter::reduce<metrics::Count, metrics::Flops, metrics::FloatingLoads,
+                     metrics::FloatingStores, metrics::SumOfSquares,
+                     metrics::Min, metrics::Max>(const counter_t* device_ptr,
+                                                 hipStream_t stream) const;
+
+} // namespace hip
@@ -0,0 +1,150 @@
+/** \file metrics_kernels.hpp
+ * \brief Device code of the generic per-basic block reduction, see
+ * metrics.hpp. Has to be compiled with hipcc
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include "hip/hip_runtime.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "hip_utils.hpp"
+#include "metrics.hpp"
+
+namespace hip {
+
+namespace metrics {
+
+constexpr unsigned int threads_per_block = 256u;
+
+/** \fn gridSize
+ * \brief Number of blocks of the reduction : a few per compute unit, so the
+ * device is filled, rounded so the grid stride is a multiple of bb_count
+ */
+inline unsigned int gridSize(unsigned int bb_count) {
+    int device;
+    hipDeviceProp_t properties;
+    hip::check(hipGetDevice(&device));
+    hip::check(hipGetDeviceProperties(&properties, device));
+
+    constexpr auto blocks_per_cu = 4u;
+    auto blocks = properties.multiProcessorCount * blocks_per_cu;
+
+    auto multiple = bb_count / std::gcd(bb_count, threads_per_block);
+
+    return (blocks + multiple - 1) / multiple * multiple;
+}
+
+/** \fn reduceMetrics
+ * \brief Single-pass reduction of all metrics. The grid stride is a multiple
+ * of bb_count, so every thread always reduces the same basic block, in
+ * registers. The threads of a block reducing the same basic block are then
+ * combined in shared memory
+ *
+ * \param instr_ptr Instrumentation data pointer
+ * \param size Number of counters
+ * \param bb_count Number of basic blocks
+ * \param blocks_info Block table, see \ref Instrumenter::deviceBlocksInfo
+ * \param output Output array of size gridDim.x * min(bb_count, blockDim.x).
+ * Entry i of block b holds the partial result of basic block (b * blockDim.x +
+ * i) % bb_count
+ */
+template <typename... Metrics>
+__global__ void reduceMetrics(const uint8_t* instr_ptr, uint32_t size,
+                              uint32_t bb_count,
+                              const hip::DeviceBlockInfo* blocks_info,
+                              BlockMetrics<Metrics...>* output) {
+    using Result = BlockMetrics<Metrics...>;
+    __shared__ Result scratch[threads_per_block];
+
+    auto index = blockIdx.x * blockDim.x + threadIdx.x;
+    auto stride = blockDim.x * gridDim.x;
+    auto bb = index % bb_count;
+    const auto& block = blocks_info[bb];
+
+    // Phase 1 : accumulate in registers
+
+    auto value = Result::identity();
+    for (auto i = index; i < size; i += stride) {
+        value.accumulate(instr_ptr[i], block);
+    }
+
+    scratch[threadIdx.x] = value;
+    __syncthreads();
+
+    // Phase 2 : regroup the threads reducing the same basic block
+
+    auto outputs = bb_count < blockDim.x ? bb_count : blockDim.x;
+
+    if (threadIdx.x < outputs) {
+        for (auto t = threadIdx.x + bb_count; t < blockDim.x; t += bb_count) {
+            value.merge(scratch[t]);
+        }
+
+        output[blockIdx.x * outputs + threadIdx.x] = value;
+    }
+}
+
+} // namespace metrics
+
+template <typename... Metrics>
+std::vector<BlockMetrics<Metrics...>>
+Instrumenter::reduce(const counter_t* device_ptr, hipStream_t stream) const {
+    using Result = BlockMetrics<Metrics...>;
+
+    auto bb_count = kernel_info.basic_blocks;
+    auto num_blocks = metrics::gridSize(bb_count);
+    auto threads = metrics::threads_per_block;
+    auto outputs = std::min(bb_count, threads);
+
+    // ----- Malloc & memcopy ----- //
+
+    auto blocks_info_ptr = deviceBlocksInfo();
+
+    std::vector<Result> partials(num_blocks * outputs);
+    auto partials_size = partials.size() * sizeof(Result);
+
+    Result* partials_ptr;
+    hip::check(hipMalloc(&partials_ptr, partials_size));
+
+    // ----- Launch kernel ----- //
+
+    if (!stream) {
+        hip::check(hipDeviceSynchronize());
+    }
+
+    metrics::reduceMetrics<Metrics...><<<num_blocks, threads, 0, stream>>>(
+        device_ptr, kernel_info.instr_size, bb_count, blocks_info_ptr,
+        partials_ptr);
+
+    if (!stream) {
+        hip::check(hipDeviceSynchronize());
+    } else {
+        hip::check(hipStreamSynchronize(stream));
+    }
+
+    hip::check(hipMemcpy(partials.data(), partials_ptr, partials_size,
+                         hipMemcpyDeviceToHost));
+
+    hip::check(hipFree(partials_ptr));
+
+    // ----- Final reduction ----- //
+
+    std::vector<Result> results(bb_count, Result::identity());
+
+    for (auto b = 0u; b < num_blocks; ++b) {
+        for (auto i = 0u; i < outputs; ++i) {
+            auto bb = (b * threads + i) % bb_count;
+            results[bb].merge(partials[b * outputs + i]);
+        }
+    }
+
+    return results;
+}
+
+} // namespace hip
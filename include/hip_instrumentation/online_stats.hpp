@@ -0,0 +1,113 @@
+/** \file online_stats.hpp
+ * \brief Online statistics of the basic block counts across the launches of a
+ * kernel, without storing the traces
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hip {
+
+/** \brief Environment variable holding the output file of the statistics of
+ * the instrumented application, written at exit. No statistics are gathered
+ * if it is not set
+ */
+constexpr auto stats_env_var = "HIP_ANALYZER_STATS";
+
+/** \struct RunningStats
+ * \brief Welford's online mean and variance, along with the extrema
+ */
+struct RunningStats {
+    uint64_t n = 0u;
+    double mean = 0.;
+
+    /** \brief Sum of the squared differences to the mean
+     */
+    double m2 = 0.;
+
+    uint64_t min = std::numeric_limits<uint64_t>::max();
+    uint64_t max = 0u;
+
+    void add(uint64_t value) {
+        ++n;
+
+        auto x = static_cast<double>(value);
+        auto delta = x - mean;
+        mean += delta / n;
+        m2 += delta * (x - mean);
+
+        min = value < min ? value : min;
+        max = value > max ? value : max;
+    }
+
+    /** \fn merge
+     * \brief Combines with the statistics of another set of values (Chan et
+     * al.)
+     */
+    void merge(const RunningStats& other);
+
+    /** \fn variance
+     * \brief Sample variance, 0 with less than two values
+     */
+    double variance() const { return n > 1u ? m2 / (n - 1u) : 0.; }
+
+    double stddev() const { return std::sqrt(variance()); }
+};
+
+/** \struct KernelStats
+ * \brief Statistics of the per-basic block totals of the launches of a kernel
+ */
+struct KernelStats {
+    std::vector<RunningStats> blocks;
+
+    uint64_t launches() const { return blocks.empty() ? 0u : blocks[0].n; }
+
+    /** \fn add
+     * \brief Accounts for a launch, given its per-basic block totals
+     */
+    void add(const uint64_t* totals, size_t bb_count);
+};
+
+/** \class StatsRegistry
+ * \brief Statistics of every kernel of the process. Thread-safe
+ */
+class StatsRegistry {
+  public:
+    /** \fn add
+     * \brief Accounts for a launch of a kernel
+     */
+    void add(const std::string& kernel, const uint64_t* totals,
+             size_t bb_count);
+
+    /** \fn kernels
+     * \brief Copy of the statistics gathered so far
+     */
+    std::map<std::string, KernelStats> kernels() const;
+
+    /** \fn json
+     * \brief Statistics of all kernels, as a JSON document
+     */
+    std::string json() const;
+
+    /** \fn global
+     * \brief Process-wide registry if \ref stats_env_var is set, nullptr
+     * otherwise. Its statistics are written to the file at exit
+     */
+    static StatsRegistry* global();
+
+  private:
+    mutable std::mutex mutex;
+    std::map<std::string, KernelStats> stats;
+};
+
+} // namespace hip
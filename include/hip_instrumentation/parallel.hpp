@@ -0,0 +1,127 @@
+/** \file parallel.hpp
+ * \brief Host parallelism utilities, for the offline analysis of the traces
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace hip {
+
+/** \fn hardwareThreads
+ * \brief Number of hardware threads of the host, at least one
+ */
+inline unsigned int hardwareThreads() {
+    auto threads = std::thread::hardware_concurrency();
+    return threads ? threads : 1u;
+}
+
+/** \fn parallelFor
+ * \brief Executes func(task) for every task in [0, tasks), on up to threads
+ * threads (all hardware threads if 0), the calling thread included. Tasks are
+ * distributed dynamically. The first exception thrown by a task is rethrown
+ * in the calling thread, and the remaining tasks are skipped
+ */
+template <typename Func>
+void parallelFor(size_t tasks, Func&& func, unsigned int threads = 0u) {
+    if (threads == 0u) {
+        threads = hardwareThreads();
+    }
+
+    threads = static_cast<unsigned int>(std::min<size_t>(threads, tasks));
+
+    if (threads <= 1u) {
+        for (size_t task = 0u; task < tasks; ++task) {
+            func(task);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0u};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&]() {
+        for (auto task = next++; task < tasks; task = next++) {
+            try {
+                func(task);
+            } catch (...) {
+                std::scoped_lock lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next = tasks;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+
+    for (auto i = 1u; i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/** \fn parallelReduce
+ * \brief Splits [0, items) in a few contiguous ranges per thread, processed
+ * in parallel by func(partial, begin, end) where partial is the result of
+ * init(), private to the range. The partials are then merged with
+ * merge(partial) in the order of the ranges, so the result does not depend on
+ * the scheduling
+ *
+ * \param threads Number of threads, all hardware threads if 0
+ */
+template <typename Init, typename Func, typename Merge>
+void parallelReduce(size_t items, Init&& init, Func&& func, Merge&& merge,
+                    unsigned int threads = 0u) {
+    if (threads == 0u) {
+        threads = hardwareThreads();
+    }
+
+    if (items == 0u) {
+        return;
+    }
+
+    // A few tasks per thread to balance the load
+    auto tasks = std::min<size_t>(items, threads * 4u);
+    auto items_per_task = (items + tasks - 1) / tasks;
+
+    std::vector<std::decay_t<decltype(init())>> partials(tasks);
+
+    parallelFor(
+        tasks,
+        [&](size_t task) {
+            auto begin = std::min(task * items_per_task, items);
+            auto end = std::min(begin + items_per_task, items);
+
+            partials[task] = init();
+            func(partials[task], begin, end);
+        },
+        threads);
+
+    for (auto& partial : partials) {
+        merge(partial);
+    }
+}
+
+} // namespace hip
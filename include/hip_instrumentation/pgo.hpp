@@ -0,0 +1,102 @@
+/** \file pgo.hpp
+ * \brief Profile-guided optimization feedback from the measured counts : edge
+ * counts and branch weights of the instrumented CFG, and an LLVM sample
+ * profile keyed by function and source line
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "basic_block.hpp"
+
+namespace hip {
+
+/** \struct EdgeCount
+ * \brief Execution count of an edge of the instrumented CFG
+ */
+struct EdgeCount {
+    uint32_t from;
+
+    /** \brief Target block, or \ref BasicBlock::exit_block
+     */
+    uint32_t to;
+    uint64_t count;
+
+    /** \brief Whether the count follows from the block counts (flow
+     * conservation), or was estimated
+     */
+    bool exact;
+};
+
+/** \fn inferEdgeCounts
+ * \brief Derives the edge counts from the block counts. Only blocks are
+ * instrumented, so the edges are solved by flow conservation (the count of a
+ * block is the sum of its incoming and of its outgoing edges) : an edge is
+ * exact when it is the only unknown edge of a block. The remaining flow of a
+ * block is split between its unknown edges in proportion to the count of
+ * their target.
+ *
+ * The exit of the kernel (\ref BasicBlock::exit_block) is a sink, whose
+ * inflow is not constrained. The entries (blocks without predecessors, or
+ * block 0 if there is none) are also entered from outside of the CFG
+ *
+ * \param blocks Blocks in their normalized form, with their successors
+ * \param counts Execution count of every basic block, see \ref
+ * cpu::reduceCounts
+ */
+std::vector<EdgeCount> inferEdgeCounts(const std::vector<BasicBlock>& blocks,
+                                       const std::vector<uint64_t>& counts);
+
+/** \struct BranchWeights
+ * \brief Weights of the successors of a block with several successors
+ */
+struct BranchWeights {
+    uint32_t block;
+    std::vector<EdgeCount> edges;
+
+    /** \fn metadata
+     * \brief LLVM branch_weights metadata, scaled down to 32-bit weights.
+     * The weights follow the order of the successor ids, which may differ
+     * from the order of the successors of the terminator in the IR
+     */
+    std::string metadata() const;
+};
+
+/** \fn branchWeights
+ * \brief Branch weights of every block with more than one successor
+ */
+std::vector<BranchWeights> branchWeights(const std::vector<EdgeCount>& edges);
+
+/** \fn branchWeightsJson
+ * \brief Branch weights as a JSON array, with the source range of the blocks
+ */
+std::string branchWeightsJson(const std::vector<BranchWeights>& weights,
+                              const std::vector<BasicBlock>& blocks,
+                              const std::vector<uint64_t>& counts);
+
+/** \fn writeSampleProfile
+ * \brief Writes the counts as an LLVM sample profile (text format), for
+ * -fprofile-sample-use. Each line of the function holds the count of the
+ * innermost block covering it, at its offset from the first line of the
+ * function
+ *
+ * \param function Name of the function, mangled as in the IR
+ * \param file Source file of the function
+ * \param function_line Line of the function declaration, the line offsets
+ * are relative to it
+ * \param blocks Blocks of the database
+ * \param counts Execution count of every basic block
+ * \param entries Number of times the function was entered (e.g. threads)
+ */
+void writeSampleProfile(std::ostream& out, const std::string& function,
+                        const std::string& file, uint32_t function_line,
+                        const std::vector<BasicBlock>& blocks,
+                        const std::vector<uint64_t>& counts, uint64_t entries);
+
+} // namespace hip
@@ -0,0 +1,217 @@
+/** \file query_server.hpp
+ * \brief Long-running local analysis server : traces are loaded and indexed
+ * once, then queried over a UNIX socket
+ *
+ * \details The protocol is line-based : every request is a line of
+ * space-separated words, and every response a single line of JSON. Requests :
+ *
+ *      load <name> <kernel_info> <hiptrace> [database]
+ *      unload <name>
+ *      list
+ *      top <name> [n] [count|flops|wasted]
+ *      workgroup <name> <id>
+ *      workgroups <name> [n]
+ *      divergence <name> [n]
+ *
+ * Errors are reported as {"error": "<message>"}. Requests longer than 64 KiB
+ * are answered with an error, and the connection is closed. So are the
+ * connections idle for more than 5 minutes.
+ *
+ * By default, the socket is only accessible to the owner of the server (mode
+ * 0600), group members can be allowed to connect with mode 0660. The paths of
+ * a load request are relative to the data root of the server, and may not
+ * leave it. Without a data root, the traces can't be loaded over the socket,
+ * only preloaded with \ref QueryServer::load
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "basic_block.hpp"
+#include "divergence.hpp"
+
+namespace hip {
+
+/** \struct TraceIndex
+ * \brief Summary of a trace, built in a single streaming pass (see \ref
+ * StreamingAnalysis). Immutable once built, so it can be shared by the
+ * workers without locking
+ */
+struct TraceIndex {
+    std::string kernel;
+    uint32_t total_blocks;
+    uint32_t threads_per_block;
+    uint32_t bb_count;
+
+    /** \brief Per basic block execution count and flops
+     */
+    std::vector<uint64_t> counts;
+    std::vector<uint64_t> flops;
+
+    /** \brief Per workgroup execution counts, [workgroup][bblock]
+     */
+    std::vector<uint32_t> workgroup_counts;
+
+    /** \brief Per workgroup flops
+     */
+    std::vector<uint64_t> workgroup_flops;
+
+    /** \brief Divergence, with the worst wavefronts only
+     */
+    DivergenceReport divergence;
+
+    std::vector<BasicBlock> blocks;
+
+    /** \fn build
+     * \brief Streams the trace and builds its index
+     *
+     * \param database Block database, the default one if empty
+     */
+    static std::shared_ptr<const TraceIndex>
+    build(const std::string& kernel_info, const std::string& hiptrace,
+          const std::string& database = "", unsigned int threads = 0u);
+};
+
+/** \class QueryServer
+ * \brief Listens on a UNIX socket and dispatches the requests to a pool of
+ * workers. The connections are multiplexed by the listening thread, which
+ * only queues complete requests : idle clients don't hold a worker. Each
+ * connection can send any number of requests, answered in order
+ */
+class QueryServer {
+  public:
+    /** ctor
+     * \param workers Number of worker threads, all hardware threads if 0
+     * \param data_root Directory of the traces which can be loaded over the
+     * socket. If empty, load requests are rejected
+     * \param socket_mode Permissions of the socket. Connecting requires write
+     * access, e.g. 0660 lets the members of the group of the server query it
+     */
+    QueryServer(const std::string& socket_path, unsigned int workers = 0u,
+                const std::string& data_root = "",
+                unsigned int socket_mode = 0600u);
+
+    /** dtor. Stops the server if it is running
+     */
+    ~QueryServer();
+
+    /** \fn load
+     * \brief Loads and indexes a trace, replacing the previous one with the
+     * same name. The paths are not restricted to the data root
+     */
+    void load(const std::string& name, const std::string& kernel_info,
+              const std::string& hiptrace, const std::string& database = "");
+
+    /** \fn handle
+     * \brief Answers a request, see the protocol in query_server.hpp. Never
+     * throws : errors are part of the response
+     */
+    std::string handle(const std::string& request);
+
+    /** \fn serve
+     * \brief Accepts connections and reads the requests until \ref stop is
+     * called
+     */
+    void serve();
+
+    /** \fn stop
+     * \brief Stops accepting connections and joins the workers. Can be called
+     * from any thread
+     */
+    void stop();
+
+  private:
+    std::shared_ptr<const TraceIndex> find(const std::string& name) const;
+
+    /** \fn resolve
+     * \brief Path of a file of a load request, throws if it is outside of the
+     * data root
+     */
+    std::string resolve(const std::string& path) const;
+
+    /** \struct Connection
+     * \brief State of a client, owned by the listening thread
+     */
+    struct Connection {
+        /** \brief Received data, not yet dispatched
+         */
+        std::string pending;
+
+        /** \brief A request of the connection is being answered. The
+         * connection is not read from in the meantime
+         */
+        bool busy = false;
+
+        /** \brief End of stream, or request too long : the connection is
+         * closed once the complete requests are answered
+         */
+        bool eof = false;
+        bool overflow = false;
+
+        std::chrono::steady_clock::time_point last_activity;
+    };
+
+    struct Request {
+        int fd;
+        std::string line;
+    };
+
+    /** \fn receive
+     * \brief Reads the available data of a connection, returns false if it
+     * has to be closed
+     */
+    bool receive(int fd, Connection& connection);
+
+    /** \fn dispatch
+     * \brief Queues the next complete request of an idle connection, returns
+     * false if it has to be closed
+     */
+    bool dispatch(int fd, Connection& connection);
+
+    /** \fn wake
+     * \brief Interrupts the poll of the listening thread
+     */
+    void wake();
+
+    void work();
+
+    std::string socket_path;
+    unsigned int worker_count;
+    std::filesystem::path data_root;
+    unsigned int socket_mode;
+    int listen_fd = -1;
+    std::atomic<bool> running{false};
+
+    // Loaded traces
+    mutable std::shared_mutex traces_mutex;
+    std::map<std::string, std::shared_ptr<const TraceIndex>> traces;
+
+    // Open connections, only accessed by the listening thread
+    std::map<int, Connection> connections;
+
+    // Pending requests, and the connections whose request was answered (false
+    // if the response could not be sent)
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::queue<Request> requests;
+    std::vector<std::pair<int, bool>> answered;
+    int wake_pipe[2] = {-1, -1};
+    std::vector<std::thread> workers;
+};
+
+} // namespace hip
@@ -6,107 +6,130 @@
 
 #pragma once
 
+#include "hip/hip_runtime.h"
+
+#include <numeric>
+
 #include "basic_block.hpp"
+#include "compaction_kernels.hpp"
+#include "cpu_reductions.hpp"
+#include "hip_utils.hpp"
 
 namespace hip {
 
-struct LaunchGeometry {
-    uint32_t thread_count;
-    uint32_t block_count;
-    uint32_t bb_count;
-};
+namespace reduction {
 
-struct BlockUsage {
-    uint32_t count;
-    uint32_t flops;
-};
+constexpr unsigned int threads_per_block = 256u;
 
-/** \fn reduceFlops
- * \brief Compute the number of flops per basic block. 1-dimensionnal array
- *
- * \param instr_ptr Instrumentation data pointer
- * \param geometry Launch geometry of the original kernel (thus specifying the
- * size of the instrumentation)
- * \param blocks_info Array of block data in its normalized form \ref
- * hip::BasicBlock
- * \param buffer Pre-allocated array for scratch-pad operations, of size
- * gridDim.x * blockDim.x * bb_count
- * \param output Output array of size gridDim.x * bb_count
+/** \brief Each thread loads 16 counters at once
  */
+constexpr unsigned int items_per_thread = compaction::items_per_thread;
 
-__global__ void reduceFlops(const uint8_t* instr_ptr,
-                            hip::LaunchGeometry geometry,
-                            const hip::BasicBlock* blocks_info,
-                            hip::BlockUsage* buffer, hip::BlockUsage* output) {
-    // Parallel reduction
-    uint32_t tot_threads = geometry.thread_count * geometry.block_count;
+/** \brief Counters processed by a block per iteration
+ */
+constexpr unsigned int chunk_size = threads_per_block * items_per_thread;
 
-    hip::BlockUsage* blocks_thread =
-        &buffer[(blockIdx.x * blockDim.x + threadIdx.x) * geometry.bb_count];
+/** \fn gridSize
+ * \brief Number of blocks of the reduction : a few per compute unit (no more
+ * than there are counters to process), rounded so the grid stride is a
+ * multiple of bb_count
+ */
+inline unsigned int gridSize(uint32_t size, uint32_t bb_count) {
+    int device;
+    hipDeviceProp_t properties;
+    hip::check(hipGetDevice(&device));
+    hip::check(hipGetDeviceProperties(&properties, device));
 
-    // Phase 0 : init local buffers
+    constexpr auto blocks_per_cu = 4u;
+    auto blocks = std::min(properties.multiProcessorCount * blocks_per_cu,
+                           (size + chunk_size - 1) / chunk_size);
 
-    for (auto bb = 0u; bb < geometry.bb_count; ++bb) {
-        blocks_thread[bb] = {0u, 0u};
-    }
+    auto multiple = bb_count / std::gcd(bb_count, chunk_size);
 
-    // Phase 1 : accumulate thread-local values
+    return std::max((blocks + multiple - 1) / multiple * multiple, multiple);
+}
 
-    unsigned int begin = blockIdx.x * blockDim.x + threadIdx.x;
-    unsigned int stride = blockDim.x * gridDim.x;
-    unsigned int end = tot_threads;
+} // namespace reduction
 
-    for (auto i = begin; i < end; i += stride) {
-        if (i < tot_threads) {
-            for (auto bb = 0u; bb < geometry.bb_count; ++bb) {
-                blocks_thread[bb].count += static_cast<uint32_t>(
-                    instr_ptr[i * geometry.bb_count + bb]);
-            }
-        }
-    }
+/** \fn reduceFlops
+ * \brief Compute the number of executions and flops per basic block.
+ *
+ * Each thread loads 16 counters at once. As the grid stride is a multiple of
+ * bb_count, these always belong to the same 16 basic blocks and are
+ * accumulated in registers. The per-thread sums are then merged in a shared
+ * memory array of all basic blocks, and each block adds its partial sums to
+ * the output. The sums being integers, the result does not depend on the
+ * order of the atomic operations.
+ *
+ * Launched with reduction::gridSize() blocks and
+ * bb_count * sizeof(unsigned long long) bytes of dynamic shared memory
+ *
+ * \param instr_ptr Instrumentation data pointer
+ * \param size Number of counters
+ * \param bb_count Number of basic blocks
+ * \param blocks_info Block table, see \ref
+ * hip::Instrumenter::deviceBlocksInfo
+ * \param output Zero-initialized output array of size bb_count
+ */
+__global__ void reduceFlops(const uint8_t* instr_ptr, uint32_t size,
+                            uint32_t bb_count,
+                            const hip::DeviceBlockInfo* blocks_info,
+                            hip::BlockUsage* output) {
+    using namespace hip::reduction;
 
-    // Compute flops
+    extern __shared__ unsigned long long block_counts[];
 
-    for (auto bb = 0u; bb < geometry.bb_count; ++bb) {
-        blocks_thread[bb].flops =
-            blocks_thread[bb].count * blocks_info[bb].flops;
+    for (auto bb = threadIdx.x; bb < bb_count; bb += blockDim.x) {
+        block_counts[bb] = 0u;
     }
 
-    // Phase 2 : regroup values at block-level
+    __syncthreads();
 
-    __shared__ hip::BlockUsage intermediary;
+    // Phase 1 : accumulate thread-local values in registers
 
-    for (auto bb = 0u; bb < geometry.bb_count; ++bb) {
-        if (threadIdx.x == 0) {
-            intermediary = {0u, 0u};
-        }
+    uint32_t begin = (blockIdx.x * blockDim.x + threadIdx.x) * items_per_thread;
+    uint32_t stride = blockDim.x * gridDim.x * items_per_thread;
 
-        __syncthreads();
+    uint32_t sums[items_per_thread] = {0u};
 
-        atomicAdd(&intermediary.count, blocks_thread[bb].count);
-        atomicAdd(&intermediary.flops, blocks_thread[bb].flops);
+    for (auto i = begin; i < size; i += stride) {
+        alignas(16) uint8_t chunk[items_per_thread];
+        compaction::loadChunk(instr_ptr, size, i, chunk);
 
-        __syncthreads();
+#pragma unroll
+        for (auto k = 0u; k < items_per_thread; ++k) {
+            sums[k] += chunk[k];
+        }
+    }
 
-        if (threadIdx.x == 0) {
-            // Phase 3 : save values to global memory
+    // Phase 2 : regroup values at block-level, for all basic blocks at once
 
-            output[blockIdx.x * geometry.bb_count + bb] = intermediary;
+    auto bb = begin % bb_count;
+    for (auto k = 0u; k < items_per_thread; ++k) {
+        if (sums[k] != 0u) {
+            atomicAdd(&block_counts[bb],
+                      static_cast<unsigned long long>(sums[k]));
+        }
+
+        if (++bb == bb_count) {
+            bb = 0u;
         }
     }
-}
-/*
-struct BlockBounds {
-    uint8_t min;
-    uint8_t max;
-}
 
-__global__ void
-findBounds(const uint8_t* instr_ptr, hip::LaunchGeometry geometry,
-           const hip::BasicBlock* blocks_info, BlockBounds* output) {
+    __syncthreads();
 
+    // Phase 3 : save values to global memory
 
+    for (auto bb = threadIdx.x; bb < bb_count; bb += blockDim.x) {
+        auto count = block_counts[bb];
 
+        if (count != 0u) {
+            atomicAdd(reinterpret_cast<unsigned long long*>(&output[bb].count),
+                      count);
+            atomicAdd(reinterpret_cast<unsigned long long*>(&output[bb].flops),
+                      count * blocks_info[bb].flops);
+        }
+    }
 }
-*/
+
 } // namespace hip
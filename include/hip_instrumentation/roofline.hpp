@@ -0,0 +1,158 @@
+/** \file roofline.hpp
+ * \brief Roofline model of an instrumented kernel : places its dynamic
+ * arithmetic intensity and attained performance against the roofs of a GPU
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "gpu_info.hpp"
+#include "intensity.hpp"
+
+namespace hip {
+
+/** \struct RoofPlacement
+ * \brief Position of the kernel relative to a single roof
+ */
+struct RoofPlacement {
+    std::string name;
+
+    /** \brief The roof bounds memory bandwidth (slanted), or compute (flat)
+     */
+    bool memory;
+
+    /** \brief Peak of the roof, in Bytes/s or FLOP/s
+     */
+    double peak;
+
+    /** \brief Performance bound by the roof at the kernel's arithmetic
+     * intensity, in FLOP/s
+     */
+    double bound;
+
+    /** \brief Attained performance relative to the bound
+     */
+    double fraction;
+};
+
+/** \struct BlockRoofline
+ * \brief Position of a basic block on the roofline. There is no per-block
+ * timing : the kernel duration is split between the blocks in proportion to
+ * the time they would take at the highest roofs
+ */
+struct BlockRoofline {
+    uint32_t id;
+
+    uint64_t flops;
+    uint64_t bytes;
+
+    /** \brief FLOPs/byte, 0 if the block does not access memory
+     */
+    double intensity;
+
+    /** \brief Estimated fraction of the kernel duration
+     */
+    double time_share;
+
+    /** \brief Estimated time spent in the block, in seconds
+     */
+    double time;
+
+    /** \brief Estimated FLOP/s
+     */
+    double flops_s;
+
+    /** \brief The block is bound by the highest memory roof rather than the
+     * highest compute roof
+     */
+    bool memory_bound;
+
+    /** \brief Nearest roof above the block
+     */
+    std::string nearest_roof;
+
+    /** \brief Speedup if the block reached its nearest roof
+     */
+    double speedup;
+
+    /** \brief Kernel time saved if the block reached its nearest roof, in
+     * seconds
+     */
+    double time_saved;
+};
+
+/** \enum BlockOrder
+ * \brief Sort criterion of the basic blocks, see \ref Roofline::sortedBlocks
+ */
+enum class BlockOrder { TimeSaved, Speedup, TimeShare };
+
+/** \struct Roofline
+ * \brief Roofline model of a kernel execution
+ */
+struct Roofline {
+    std::string kernel;
+    std::string gpu;
+
+    /** \brief Kernel duration, in seconds
+     */
+    double duration;
+
+    uint64_t flops;
+    uint64_t bytes;
+
+    /** \brief FLOPs/byte
+     */
+    double intensity;
+
+    /** \brief Attained FLOP/s
+     */
+    double flops_s;
+
+    /** \brief Attained floating point data bandwidth, Bytes/s
+     */
+    double bandwidth;
+
+    /** \brief Best attainable FLOP/s at this intensity : the lowest of the
+     * highest memory and the highest compute roofs
+     */
+    double attainable;
+
+    /** \brief The highest roofs bound the kernel on its memory accesses
+     */
+    bool memory_bound;
+
+    std::vector<RoofPlacement> roofs;
+
+    /** \brief Basic blocks executing floating point operations or memory
+     * accesses
+     */
+    std::vector<BlockRoofline> blocks;
+
+    /** \fn sortedBlocks
+     * \brief Indices in blocks, by decreasing order
+     */
+    std::vector<size_t> sortedBlocks(BlockOrder order) const;
+
+    /** \fn json
+     * \brief Machine-readable report
+     */
+    std::string json() const;
+
+    /** \fn svg
+     * \brief Log-log roofline plot
+     */
+    std::string svg() const;
+};
+
+/** \fn roofline
+ * \brief Places a kernel execution of the given duration (seconds) and its
+ * basic blocks against the roofs of gpu_info
+ */
+Roofline roofline(const GpuInfo& gpu_info, const std::string& kernel,
+                  const ArithmeticIntensity& ai, double duration);
+
+} // namespace hip
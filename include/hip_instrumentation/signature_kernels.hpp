@@ -0,0 +1,72 @@
+/** \file signature_kernels.hpp
+ * \brief GPU packing and expansion of the deduplicated counters (see \ref
+ * hip::SignatureTrace)
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include "hip/hip_runtime.h"
+
+#include "signatures.hpp"
+
+namespace hip {
+
+namespace signatures {
+
+constexpr unsigned int threads_per_block = 256u;
+
+/** \fn packDictionaries
+ * \brief Gathers the per-workgroup dictionaries, written by the instrumented
+ * kernel at the beginning of the region of each workgroup, into a contiguous
+ * array. One block per workgroup
+ *
+ * \param dictionaries Dictionaries as written by the kernel
+ * \param offsets Offsets of the dictionaries, see \ref SignatureTrace::offsets
+ * \param threads Threads per workgroup of the instrumented kernel
+ * \param packed Output array of size offsets[total_blocks] * bb_count
+ */
+__global__ void packDictionaries(const uint8_t* dictionaries,
+                                 const uint32_t* offsets, uint32_t threads,
+                                 uint32_t bb_count, uint8_t* packed) {
+    auto workgroup = blockIdx.x;
+
+    auto src = &dictionaries[workgroup * threads * bb_count];
+    auto dst = &packed[offsets[workgroup] * bb_count];
+    auto size = (offsets[workgroup + 1] - offsets[workgroup]) * bb_count;
+
+    for (auto i = threadIdx.x; i < size; i += blockDim.x) {
+        dst[i] = src[i];
+    }
+}
+
+/** \fn expandDictionaries
+ * \brief Reconstructs the full counters from the packed dictionaries and the
+ * per-thread signature indices. One block per workgroup
+ *
+ * \param output Output counters of size total_blocks * threads * bb_count
+ */
+__global__ void expandDictionaries(const uint8_t* packed,
+                                   const uint32_t* offsets,
+                                   const signature_index_t* thread_signatures,
+                                   uint32_t threads, uint32_t bb_count,
+                                   uint8_t* output) {
+    auto workgroup = blockIdx.x;
+    auto size = threads * bb_count;
+
+    auto dictionary = &packed[offsets[workgroup] * bb_count];
+    auto indices = &thread_signatures[workgroup * threads];
+    auto dst = &output[workgroup * size];
+
+    for (auto i = threadIdx.x; i < size; i += blockDim.x) {
+        auto thread = i / bb_count;
+        auto bb = i % bb_count;
+
+        dst[i] = dictionary[indices[thread] * bb_count + bb];
+    }
+}
+
+} // namespace signatures
+
+} // namespace hip
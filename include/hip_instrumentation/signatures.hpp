@@ -0,0 +1,86 @@
+/** \file signatures.hpp
+ * \brief Control-path signatures : deduplication of the per-thread counter
+ * vectors within a workgroup
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hip {
+
+/** \brief Index of a signature in its workgroup dictionary
+ */
+using signature_index_t = uint16_t;
+
+/** \struct SignatureTrace
+ * \brief Deduplicated counters. Every workgroup holds a dictionary of its
+ * unique counter vectors (signatures), in the order of their first occurrence,
+ * and each thread refers to its signature by index
+ */
+struct SignatureTrace {
+    /** \brief Offset (in signatures) of the dictionary of each workgroup, of
+     * size total_blocks + 1. The last element is the total number of
+     * signatures
+     */
+    std::vector<uint32_t> offsets;
+
+    /** \brief Packed dictionaries, of size offsets.back() * bb_count
+     */
+    std::vector<uint8_t> dictionary;
+
+    /** \brief Per-thread signature index, relative to the dictionary of its
+     * workgroup
+     */
+    std::vector<signature_index_t> thread_signatures;
+
+    /** \fn signatureCount
+     * \brief Number of unique signatures in a workgroup
+     */
+    uint32_t signatureCount(uint32_t workgroup) const {
+        return offsets[workgroup + 1] - offsets[workgroup];
+    }
+
+    /** \fn signature
+     * \brief Pointer to the counters of a signature
+     */
+    const uint8_t* signature(uint32_t workgroup, uint32_t index,
+                             uint32_t bb_count) const {
+        return &dictionary[(offsets[workgroup] + index) * bb_count];
+    }
+};
+
+/** \fn hashCounters
+ * \brief FNV-1a hash of a thread's counter vector, identical to the one
+ * computed by the instrumented kernel
+ */
+inline uint32_t hashCounters(const uint8_t* counters, uint32_t bb_count) {
+    uint32_t hash = 2166136261u;
+
+    for (auto i = 0u; i < bb_count; ++i) {
+        hash = (hash ^ counters[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+/** \fn deduplicateSignatures
+ * \brief Host reference implementation of the on-device deduplication
+ */
+SignatureTrace deduplicateSignatures(const uint8_t* counters,
+                                     uint32_t total_blocks,
+                                     uint32_t threads_per_block,
+                                     uint32_t bb_count);
+
+/** \fn expandSignatures
+ * \brief Reconstructs the full counters from the signatures. output must be
+ * of size total_blocks * threads_per_block * bb_count
+ */
+void expandSignatures(const SignatureTrace& trace, uint32_t threads_per_block,
+                      uint32_t bb_count, uint8_t* output);
+
+} // namespace hip
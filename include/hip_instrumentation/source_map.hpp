@@ -0,0 +1,100 @@
+/** \file source_map.hpp
+ * \brief Maps the basic blocks back to the source lines, from their begin and
+ * end locations
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "basic_block.hpp"
+
+namespace hip {
+
+/** \struct SourceLocation
+ * \brief Parsed clang source location
+ */
+struct SourceLocation {
+    std::string file;
+    uint32_t line;
+    uint32_t column;
+
+    /** \fn parse
+     * \brief Parses a location as printed by clang, "file:line:col", ignoring
+     * a trailing " <...>" (e.g. macro spelling). The file may contain spaces
+     */
+    static std::optional<SourceLocation> parse(const std::string& location);
+};
+
+/** \struct LineStats
+ * \brief Dynamic counts attributed to a source line
+ */
+struct LineStats {
+    /** \brief Executions of the innermost basic block covering the line
+     */
+    uint64_t executions = 0u;
+
+    /** \brief Floating point operations of the basic blocks beginning on the
+     * line
+     */
+    uint64_t flops = 0u;
+};
+
+/** \class SourceMap
+ * \brief Per-file line intervals of the basic blocks. Each line belongs to the
+ * innermost (shortest) block covering it
+ */
+class SourceMap {
+  public:
+    /** \brief Sentinel for lines not covered by any block
+     */
+    static constexpr uint32_t no_block = 0xffffffffu;
+
+    /** ctor
+     * \brief Parses the locations of the blocks once. Blocks with unparsable
+     * locations or spanning several files are ignored
+     */
+    SourceMap(const std::vector<BasicBlock>& blocks);
+
+    /** \fn files
+     * \brief Files referenced by the blocks
+     */
+    std::vector<std::string> files() const;
+
+    /** \fn blockAt
+     * \brief Innermost block covering a line (1-based), or no_block
+     */
+    uint32_t blockAt(const std::string& file, uint32_t line) const;
+
+    /** \fn lineStats
+     * \brief Aggregates the dynamic counts per source line of a file. Indexed
+     * by line number (index 0 is unused)
+     *
+     * \param counts Execution count of every basic block, see \ref
+     * cpu::reduceCounts
+     */
+    std::vector<LineStats> lineStats(const std::string& file,
+                                     const std::vector<uint64_t>& counts) const;
+
+  private:
+    struct FileMap {
+        /** \brief Owning block of each line, indexed by line number
+         */
+        std::vector<uint32_t> owners;
+
+        /** \brief (begin line, block id) of the blocks of the file
+         */
+        std::vector<std::pair<uint32_t, uint32_t>> begins;
+    };
+
+    std::map<std::string, FileMap> file_maps;
+    std::vector<DeviceBlockInfo> table;
+};
+
+} // namespace hip
@@ -0,0 +1,164 @@
+/** \file streaming.hpp
+ * \brief Out-of-core analysis of dense traces : the trace is read in chunks of
+ * whole workgroups and fed to a set of reducers, so the memory usage does not
+ * depend on the size of the trace
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "divergence.hpp"
+#include "trace_reader.hpp"
+
+namespace hip {
+
+/** \struct TraceChunk
+ * \brief Counters of a range of consecutive workgroups
+ */
+struct TraceChunk {
+    /** \brief Counters of the chunk, [block][thread][bblock]
+     */
+    const uint8_t* counters;
+
+    /** \brief Index of the first workgroup of the chunk in the trace
+     */
+    uint32_t first_workgroup;
+
+    uint32_t workgroups;
+
+    /** \brief Number of counters, workgroups * threads_per_block * bb_count
+     */
+    size_t size;
+};
+
+/** \class ChunkReducer
+ * \brief Interface of the analyses run by \ref StreamingAnalysis. Chunks are
+ * processed in the order of the trace, one at a time
+ */
+class ChunkReducer {
+  public:
+    virtual ~ChunkReducer() = default;
+
+    virtual void reduce(const TraceChunk& chunk) = 0;
+};
+
+/** \class StreamingAnalysis
+ * \brief Reads a dense trace chunk by chunk and runs the reducers on every
+ * chunk. The next chunk is read while the reducers process the current one
+ * (double buffering), so the peak memory usage is two chunks
+ */
+class StreamingAnalysis {
+  public:
+    /** ctor
+     * \param chunk_size Target chunk size in bytes, rounded down to whole
+     * workgroups (at least one)
+     */
+    StreamingAnalysis(TraceChunkReader& reader, uint32_t threads_per_block,
+                      uint32_t bb_count, size_t chunk_size = 64u << 20);
+
+    /** \fn add
+     * \brief Registers a reducer. It must outlive the call to \ref run
+     */
+    StreamingAnalysis& add(ChunkReducer& reducer) {
+        reducers.emplace_back(&reducer);
+        return *this;
+    }
+
+    /** \fn run
+     * \brief Streams the remainder of the trace through the reducers. Throws
+     * if the trace is not made of whole workgroups
+     */
+    void run();
+
+    /** \fn chunkWorkgroups
+     * \brief Number of workgroups per chunk
+     */
+    uint32_t chunkWorkgroups() const { return chunk_workgroups; }
+
+  private:
+    TraceChunkReader& reader;
+    uint32_t threads_per_block;
+    uint32_t bb_count;
+    uint32_t chunk_workgroups;
+    std::vector<ChunkReducer*> reducers;
+};
+
+// ----- Reducers ----- //
+
+/** \class CountReducer
+ * \brief Total execution count of every basic block, see \ref
+ * hip::cpu::reduceCounts
+ */
+class CountReducer : public ChunkReducer {
+  public:
+    CountReducer(uint32_t bb_count, unsigned int threads = 0u)
+        : bb_count(bb_count), threads(threads), totals(bb_count, 0u) {}
+
+    void reduce(const TraceChunk& chunk) override;
+
+    const std::vector<uint64_t>& counts() const { return totals; }
+
+  private:
+    uint32_t bb_count;
+    unsigned int threads;
+    std::vector<uint64_t> totals;
+};
+
+/** \class HistogramReducer
+ * \brief Distribution of the per-thread counter values of every basic block
+ */
+class HistogramReducer : public ChunkReducer {
+  public:
+    using Histogram = std::array<uint64_t, 256>;
+
+    HistogramReducer(uint32_t bb_count) : histograms(bb_count) {}
+
+    void reduce(const TraceChunk& chunk) override;
+
+    /** \fn histogram
+     * \brief Number of threads per counter value, for a basic block
+     */
+    const Histogram& histogram(uint32_t bb) const { return histograms[bb]; }
+
+  private:
+    std::vector<Histogram> histograms;
+};
+
+/** \class DivergenceReducer
+ * \brief Wavefront divergence, see \ref analyzeDivergence. Only the worst
+ * wavefronts are kept, to bound the memory usage
+ */
+class DivergenceReducer : public ChunkReducer {
+  public:
+    /** ctor
+     * \param kept_waves Number of wavefronts (wasting the most lane slots) to
+     * keep in the report
+     */
+    DivergenceReducer(uint32_t threads_per_block, uint32_t bb_count,
+                      uint32_t wave_size = 64u, size_t kept_waves = 64u,
+                      unsigned int threads = 0u);
+
+    void reduce(const TraceChunk& chunk) override;
+
+    /** \fn report
+     * \brief Divergence of the chunks reduced so far. The waves are the worst
+     * ones, worst first
+     */
+    const DivergenceReport& report() const { return divergence; }
+
+  private:
+    uint32_t threads_per_block;
+    uint32_t bb_count;
+    uint32_t wave_size;
+    size_t kept_waves;
+    unsigned int threads;
+    DivergenceReport divergence;
+};
+
+} // namespace hip
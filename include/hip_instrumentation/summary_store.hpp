@@ -0,0 +1,268 @@
+/** \file summary_store.hpp
+ * \brief Time series of per-launch summaries : one fixed-size record per
+ * launch (kernel id, stamps, per-basic block totals), for applications
+ * launching kernels too many times to save their full traces
+ *
+ * \details The store is a columnar file of fixed-size row groups. Each group
+ * starts with a header (the stamp range and row count of the group, which
+ * makes up a sparse time index), followed by one column per field :
+ *
+ *      file header | group 0 | group 1 | ...
+ *      group : header | begin stamps | end stamps | totals bb 0 | totals bb 1
+ *              | ... | kernel ids
+ *
+ * The writer buffers the current group and writes it at once, the reader
+ * maps the file in memory.
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hip {
+
+/** \brief Environment variable holding the directory of the summary stores of
+ * the instrumented application, one per kernel. No summary is recorded if it
+ * is not set
+ */
+constexpr auto summary_env_var = "HIP_ANALYZER_SUMMARY";
+
+/** \struct LaunchSummary
+ * \brief Record of a launch
+ */
+struct LaunchSummary {
+    uint32_t kernel_id;
+    uint64_t stamp_begin;
+    uint64_t stamp_end;
+
+    /** \brief Per basic block execution count, summed over all threads
+     */
+    std::vector<uint64_t> totals;
+};
+
+/** \struct SummaryBucket
+ * \brief Aggregate of the launches which began in [begin, end)
+ */
+struct SummaryBucket {
+    uint64_t begin;
+    uint64_t end;
+    uint64_t launches;
+
+    /** \brief Total time spent in the launches, in ns
+     */
+    uint64_t duration;
+
+    std::vector<uint64_t> totals;
+};
+
+namespace summary {
+
+constexpr char magic[8] = {'H', 'I', 'P', 'S', 'U', 'M', 'M', '1'};
+
+/** \struct FileHeader
+ * \brief Header of the store
+ */
+struct FileHeader {
+    char magic[8];
+    uint32_t bb_count;
+    uint32_t rows_per_group;
+};
+
+/** \struct GroupHeader
+ * \brief Header of a row group
+ */
+struct GroupHeader {
+    /** \brief Smallest begin and largest end stamps of the group
+     */
+    uint64_t min_stamp;
+    uint64_t max_stamp;
+
+    uint32_t rows;
+    uint32_t reserved;
+};
+
+/** \struct GroupLayout
+ * \brief Offsets of the columns in a row group. The number of rows is a
+ * multiple of 8 so that all columns are aligned
+ */
+struct GroupLayout {
+    GroupLayout(uint32_t bb_count, uint32_t rows_per_group)
+        : rows(rows_per_group), begin_stamps(sizeof(GroupHeader)),
+          end_stamps(begin_stamps + rows * sizeof(uint64_t)),
+          totals(end_stamps + rows * sizeof(uint64_t)),
+          kernel_ids(totals + static_cast<size_t>(bb_count) * rows *
+                                  sizeof(uint64_t)),
+          size(kernel_ids + rows * sizeof(uint32_t)) {}
+
+    size_t rows;
+    size_t begin_stamps;
+    size_t end_stamps;
+    size_t totals;
+    size_t kernel_ids;
+
+    /** \brief Size of a group, in bytes
+     */
+    size_t size;
+
+    /** \fn blockTotals
+     * \brief Offset of the totals column of a basic block
+     */
+    size_t blockTotals(uint32_t bb) const {
+        return totals + bb * rows * sizeof(uint64_t);
+    }
+};
+
+/** \fn roundRows
+ * \brief Rows per group, rounded up to a multiple of 8
+ */
+inline uint32_t roundRows(uint32_t rows_per_group) {
+    return (std::max(rows_per_group, 1u) + 7u) / 8u * 8u;
+}
+
+/** \fn kernelId
+ * \brief Identifier of a kernel from its name
+ */
+uint32_t kernelId(const std::string& kernel_name);
+
+} // namespace summary
+
+/** \class SummaryWriter
+ * \brief Appends launch records to a store. The records are only guaranteed
+ * to be on disk after \ref flush (or the destruction of the writer)
+ */
+class SummaryWriter {
+  public:
+    /** ctor
+     * \brief Opens the store for appending, or creates it if it does not
+     * exist. Throws if an existing store has a different number of basic
+     * blocks
+     */
+    SummaryWriter(const std::string& filename, uint32_t bb_count,
+                  uint32_t rows_per_group = 4096u);
+
+    SummaryWriter(const SummaryWriter&) = delete;
+    SummaryWriter& operator=(const SummaryWriter&) = delete;
+
+    /** dtor. Flushes the current group
+     */
+    ~SummaryWriter();
+
+    /** \fn append
+     * \brief Appends a record. totals must hold bb_count values
+     */
+    void append(uint32_t kernel_id, uint64_t stamp_begin, uint64_t stamp_end,
+                const uint64_t* totals);
+
+    /** \fn flush
+     * \brief Writes the current (possibly partial) group to the file
+     */
+    void flush();
+
+    /** \fn size
+     * \brief Number of records in the store
+     */
+    size_t size() const { return full_groups * rows_per_group + rows; }
+
+  private:
+    template <typename T> T* column(size_t offset) {
+        return reinterpret_cast<T*>(group.data() + offset);
+    }
+
+    summary::GroupHeader& groupHeader() {
+        return *column<summary::GroupHeader>(0u);
+    }
+
+    void resetGroup();
+
+    std::string filename;
+    int fd = -1;
+    uint32_t bb_count;
+    uint32_t rows_per_group;
+    summary::GroupLayout layout;
+
+    /** \brief Groups already complete in the file
+     */
+    size_t full_groups = 0u;
+
+    /** \brief Buffered group and its row count
+     */
+    std::vector<uint8_t> group;
+    uint32_t rows = 0u;
+};
+
+/** \class SummaryReader
+ * \brief Memory-mapped, read-only view of a store
+ */
+class SummaryReader {
+  public:
+    SummaryReader(const std::string& filename);
+
+    SummaryReader(const SummaryReader&) = delete;
+    SummaryReader& operator=(const SummaryReader&) = delete;
+
+    ~SummaryReader();
+
+    uint32_t basicBlocks() const { return bb_count; }
+
+    /** \fn size
+     * \brief Number of records
+     */
+    size_t size() const { return records; }
+
+    /** \fn at
+     * \brief Record of index i
+     */
+    LaunchSummary at(size_t i) const;
+
+    /** \fn range
+     * \brief Records of the launches which began in [begin, end). Groups are
+     * skipped according to their stamp range
+     */
+    std::vector<LaunchSummary> range(uint64_t begin, uint64_t end) const;
+
+    /** \fn downsample
+     * \brief Aggregates the launches which began in [begin, end) in buckets of
+     * equal duration
+     */
+    std::vector<SummaryBucket> downsample(uint64_t begin, uint64_t end,
+                                          size_t buckets) const;
+
+    /** \fn stampRange
+     * \brief Smallest begin and largest end stamps of the store
+     */
+    std::pair<uint64_t, uint64_t> stampRange() const;
+
+  private:
+    template <typename T> const T* column(size_t g, size_t offset) const {
+        auto group = mapping + sizeof(summary::FileHeader) + g * layout.size;
+        return reinterpret_cast<const T*>(group + offset);
+    }
+
+    const summary::GroupHeader& groupHeader(size_t g) const {
+        return *column<summary::GroupHeader>(g, 0u);
+    }
+
+    /** \fn forEachRow
+     * \brief Calls func(group, row) for every row which began in [begin, end)
+     */
+    template <typename Func>
+    void forEachRow(uint64_t begin, uint64_t end, Func&& func) const;
+
+    LaunchSummary row(size_t g, uint32_t r) const;
+
+    const uint8_t* mapping = nullptr;
+    size_t mapping_size = 0u;
+    uint32_t bb_count;
+    summary::GroupLayout layout;
+    size_t groups;
+    size_t records = 0u;
+};
+
+} // namespace hip
@@ -0,0 +1,124 @@
+/** \file timeline.hpp
+ * \brief Chrome trace event (JSON) export of the instrumented launches, to be
+ * opened in chrome://tracing or Perfetto
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hip {
+
+/** \brief Environment variable holding the output file of the timeline of the
+ * instrumented application. No timeline is recorded if it is not set
+ */
+constexpr auto timeline_env_var = "HIP_ANALYZER_TIMELINE";
+
+/** \class TimelineWriter
+ * \brief Writes trace events incrementally : events are serialized to a
+ * bounded buffer, flushed to the file once full, so any number of launches can
+ * be recorded. Timestamps are in ns (roctracer clock). Thread-safe
+ */
+class TimelineWriter {
+  public:
+    using Args = std::vector<std::pair<std::string, std::string>>;
+
+    /** ctor
+     * \param buffer_size Buffered bytes before the events are flushed
+     */
+    TimelineWriter(const std::string& filename,
+                   size_t buffer_size = 1u << 20);
+
+    TimelineWriter(const TimelineWriter&) = delete;
+    TimelineWriter& operator=(const TimelineWriter&) = delete;
+
+    /** dtor. Closes the trace
+     */
+    ~TimelineWriter();
+
+    /** \fn complete
+     * \brief Event with a duration, on a thread of the process
+     *
+     * \param args Event arguments, as (key, JSON value) pairs
+     */
+    void complete(const std::string& name, const std::string& category,
+                  uint64_t begin, uint64_t end, uint32_t tid,
+                  const Args& args = {});
+
+    /** \fn async
+     * \brief Event with a duration, which may overlap with others (e.g. kernel
+     * executions). Each id is displayed on its own track
+     */
+    void async(const std::string& name, const std::string& category,
+               uint64_t begin, uint64_t end, uint64_t id,
+               const Args& args = {});
+
+    /** \fn counter
+     * \brief Values of a counter track at a given time
+     */
+    void counter(const std::string& name, uint64_t stamp,
+                 const std::vector<std::pair<std::string, uint64_t>>& values);
+
+    /** \fn threadName
+     * \brief Names a thread track
+     */
+    void threadName(uint32_t tid, const std::string& name);
+
+    /** \fn flush
+     * \brief Writes the buffered events to the file
+     */
+    void flush();
+
+    /** \fn close
+     * \brief Flushes the buffer and terminates the JSON document. No event can
+     * be recorded afterwards
+     */
+    void close();
+
+    /** \fn quoted
+     * \brief Escaped JSON string, to be used as an event argument
+     */
+    static std::string quoted(const std::string& str);
+
+    /** \fn global
+     * \brief Process-wide timeline, opened on the first call if \ref
+     * timeline_env_var is set, nullptr otherwise. Closed at exit
+     */
+    static TimelineWriter* global();
+
+    /** \fn nextId
+     * \brief Unique id for an async event
+     */
+    uint64_t nextId();
+
+    /** \fn hostThread
+     * \brief Track of the calling thread, named on the first call. The kernels
+     * are on track 0
+     */
+    uint32_t hostThread();
+
+  private:
+    void beginEvent(const char* phase, const std::string& name,
+                    const std::string& category, uint64_t stamp);
+    void endEvent(const Args& args);
+    void writeBuffer();
+
+    std::string filename;
+    std::ofstream out;
+    size_t capacity;
+    std::string buffer;
+    bool first_event = true;
+    bool closed = false;
+    uint64_t next_id = 0u;
+    uint32_t pid;
+    std::mutex mutex;
+};
+
+} // namespace hip
@@ -0,0 +1,119 @@
+/** \file trace_diff.hpp
+ * \brief Differential comparison of two traces of the same kernel, per basic
+ * block and per workgroup. Fed by chunks of whole workgroups, so the traces
+ * can be streamed (see \ref TraceChunkReader)
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "basic_block.hpp"
+
+namespace hip {
+
+/** \struct BlockDelta
+ * \brief Change of a basic block between the two traces. The per-workgroup
+ * deltas are the samples of the significance test
+ */
+struct BlockDelta {
+    uint32_t id;
+
+    /** \brief Total executions in each trace
+     */
+    uint64_t count_a, count_b;
+
+    /** \brief Mean and standard deviation of the per-workgroup deltas
+     */
+    double mean, stddev;
+
+    /** \brief z-score of the mean delta (mean over its standard error).
+     * Infinite for a change identical in all workgroups
+     */
+    double z;
+
+    /** \brief Change in dynamic flops, (count_b - count_a) * flops
+     */
+    int64_t flops_delta;
+
+    int64_t delta() const {
+        return static_cast<int64_t>(count_b) - static_cast<int64_t>(count_a);
+    }
+};
+
+/** \struct WorkgroupDelta
+ * \brief Change of the dynamic flops of a workgroup
+ */
+struct WorkgroupDelta {
+    uint32_t workgroup;
+    int64_t flops_delta;
+
+    /** \brief z-score relative to the distribution of the workgroup deltas
+     */
+    double z;
+};
+
+/** \class TraceDiff
+ * \brief Accumulates the differences between two traces, workgroup by
+ * workgroup
+ */
+class TraceDiff {
+  public:
+    /** ctor
+     *
+     * \param blocks Block database, for the flops of each block
+     */
+    TraceDiff(uint32_t bb_count, uint32_t threads_per_block,
+              const std::vector<BasicBlock>& blocks);
+
+    /** \fn addWorkgroups
+     * \brief Accumulates the counters of consecutive whole workgroups of
+     * both traces
+     */
+    void addWorkgroups(const uint8_t* a, const uint8_t* b, size_t workgroups);
+
+    /** \fn blocks
+     * \brief Per basic block changes, indexed by block id
+     */
+    std::vector<BlockDelta> blocks() const;
+
+    /** \fn significantBlocks
+     * \brief Blocks whose |z| is at least z_threshold, by decreasing absolute
+     * flop impact (then absolute count change)
+     */
+    std::vector<BlockDelta> significantBlocks(double z_threshold) const;
+
+    /** \fn workgroups
+     * \brief Per workgroup flop changes, in the order of the workgroups
+     */
+    std::vector<WorkgroupDelta> workgroups() const;
+
+    /** \fn workgroupCount
+     * \brief Number of workgroups accumulated so far
+     */
+    size_t workgroupCount() const { return workgroup_flops.size(); }
+
+  private:
+    uint32_t bb_count;
+    uint32_t threads_per_block;
+    std::vector<uint32_t> flops;
+
+    std::vector<uint64_t> count_a, count_b;
+
+    /** \brief Welford accumulators of the per-workgroup deltas
+     */
+    std::vector<double> mean, m2;
+
+    std::vector<int64_t> workgroup_flops;
+
+    /** \brief Scratch per-workgroup deltas
+     */
+    std::vector<int32_t> deltas;
+};
+
+} // namespace hip
@@ -0,0 +1,88 @@
+/** \file trace_reader.hpp
+ * \brief Trace header parsing and chunked reading of dense traces, for traces
+ * larger than memory
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace hip {
+
+/** \brief Small header to validate the trace type
+ */
+constexpr auto hiptrace_name = "hiptrace";
+constexpr auto hiptrace_sparse_name = "hiptrace_sparse";
+constexpr auto hiptrace_signatures_name = "hiptrace_signatures";
+constexpr auto hiptrace_coverage_name = "hiptrace_coverage";
+
+/** \struct TraceHeader
+ * \brief Header of a binary trace, like "<type>,<kernel name>,<num
+ * counters>,<stamp>,<stamp_begin>,<stamp_end>,<counter size>[,<entries>]"
+ */
+struct TraceHeader {
+    std::string type;
+    std::string kernel;
+    size_t instr_size;
+    uint64_t stamp;
+    uint64_t stamp_begin;
+    uint64_t stamp_end;
+    size_t counter_size;
+
+    /** \brief Number of entries of the payload, the number of counters for a
+     * dense trace
+     */
+    size_t entries;
+
+    /** \fn parse
+     * \brief Parses a header line, throws if it is malformed
+     */
+    static TraceHeader parse(const std::string& header);
+};
+
+/** \class TraceChunkReader
+ * \brief Reads the counters of a dense trace chunk by chunk, without loading
+ * the whole trace in memory
+ */
+class TraceChunkReader {
+  public:
+    /** ctor
+     * \brief Opens the trace and parses its header. Throws if it is not a
+     * dense trace
+     */
+    TraceChunkReader(const std::string& filename);
+
+    /** \fn read
+     * \brief Reads up to count counters to buffer, returns the number of
+     * counters read (0 at the end of the trace)
+     */
+    size_t read(uint8_t* buffer, size_t count);
+
+    /** \fn header
+     * \brief Header of the trace
+     */
+    const TraceHeader& header() const { return trace_header; }
+
+    /** \fn position
+     * \brief Counters read so far
+     */
+    size_t position() const { return pos; }
+
+    /** \fn size
+     * \brief Total number of counters
+     */
+    size_t size() const { return trace_header.instr_size; }
+
+  private:
+    std::string filename;
+    std::ifstream in;
+    TraceHeader trace_header;
+    size_t pos = 0u;
+};
+
+} // namespace hip
@@ -80,11 +80,109 @@ struct InstrGenerator {
      */
     std::string threads, blocks;
 
+    /** \brief Launch stream expression
+     */
+    std::string stream = "nullptr";
+
     std::string kernel_name;
+
+    /** \brief If true, the counters are compacted on the device and only the
+     * non-zero values are copied back
+     */
+    bool sparse_readback = false;
 };
 
 struct MultipleExecutionInstrGenerator : public InstrGenerator {
     virtual std::string generatePostKernel() const override;
 };
 
+/** \struct LiveInstrGenerator
+ * \brief Live instrumentation : on top of the regular counters, the kernel
+ * periodically flushes its per-basic block totals to a host-visible buffer
+ * which is sampled during the execution (see \ref hip::CounterMonitor)
+ */
+struct LiveInstrGenerator : public InstrGenerator {
+    /** ctor
+     * \param period Number of executions of a basic block (per thread)
+     * between two flushes. Has to be a power of two, at most 256
+     * \param interval_us Host sampling interval, in microseconds
+     */
+    LiveInstrGenerator(unsigned int period = 16u,
+                       unsigned int interval_us = 100000u);
+
+    virtual std::string generateBlockCode(unsigned int id) const override;
+
+    virtual std::string generateInstrumentationParms() const override;
+
+    virtual std::string generateInstrumentationCommit() const override;
+
+    virtual std::string generateInstrumentationInit() const override;
+
+    virtual std::string generateInstrumentationLaunchParms() const override;
+
+    virtual std::string generateInstrumentationFinalize() const override;
+
+    unsigned int flush_period;
+    unsigned int sampling_interval;
+};
+
+/** \struct SignatureInstrGenerator
+ * \brief Control-path signatures : the commit phase deduplicates the counter
+ * vectors of the threads within a workgroup, and writes a dictionary of unique
+ * vectors along with a per-thread signature index (see \ref
+ * hip::SignatureTrace). The commit synchronizes the workgroup, and thus
+ * requires every thread to reach the end of the kernel
+ */
+struct SignatureInstrGenerator : public InstrGenerator {
+    virtual std::string generateInstrumentationParms() const override;
+
+    virtual std::string generateInstrumentationCommit() const override;
+
+    virtual std::string generateInstrumentationInit() const override;
+
+    virtual std::string generateInstrumentationLaunchParms() const override;
+
+    virtual std::string generateInstrumentationFinalize() const override;
+};
+
+/** \struct GraphInstrGenerator
+ * \brief Stream capture-compatible instrumentation : the counters are
+ * allocated once per launch geometry and owned by a static instrumenter (see
+ * \ref hip::GraphInstrumenters), and the zeroing and readback are asynchronous
+ * operations on the launch stream. When captured, they are recorded as
+ * memset / memcpy / host nodes and replayed with the graph, refreshing the
+ * host counters after every replay. Graphs of the same launch site and
+ * geometry share the counters, and must not be replayed concurrently
+ */
+struct GraphInstrGenerator : public InstrGenerator {
+    virtual std::string generateInstrumentationInit() const override;
+
+    virtual std::string generateInstrumentationFinalize() const override;
+};
+
+/** \struct CoverageInstrGenerator
+ * \brief One-bit coverage : each basic block sets the bits of the active
+ * lanes of the wavefront using a wave-wide ballot, in one 64-bit word per
+ * (wavefront, basic block) (see \ref hip::Instrumenter::coverage)
+ */
+struct CoverageInstrGenerator : public InstrGenerator {
+    virtual std::string generateBlockCode(unsigned int id) const override;
+
+    virtual std::string generateInstrumentationParms() const override;
+
+    virtual std::string generateInstrumentationLocals() const override;
+
+    virtual std::string generateInstrumentationCommit() const override;
+
+    virtual std::string generateInstrumentationInit() const override;
+
+    virtual std::string generateInstrumentationLaunchParms() const override;
+
+    virtual std::string generateInstrumentationFinalize() const override;
+
+    /** \brief Maximum number of wavefronts per block (1024 threads of wave32)
+     */
+    static constexpr unsigned int max_waves = 32u;
+};
+
 } // namespace hip
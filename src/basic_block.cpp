@@ -8,6 +8,7 @@
 
 // Std includes
 
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <sstream>
@@ -30,7 +31,8 @@ BasicBlock::BasicBlock(const BasicBlock& other)
     : id(other.id), clang_id(other.clang_id), flops(other.flops),
       begin_loc(std::make_unique<std::string>(*other.begin_loc)),
       end_loc(std::make_unique<std::string>(*other.end_loc)),
-      floating_ld(other.floating_ld), floating_st(other.floating_st) {}
+      floating_ld(other.floating_ld), floating_st(other.floating_st),
+      successors(other.successors) {}
 
 BasicBlock& BasicBlock::operator=(const BasicBlock& other) {
     id = other.id;
@@ -40,6 +42,7 @@ BasicBlock& BasicBlock::operator=(const BasicBlock& other) {
     end_loc = std::make_unique<std::string>(*other.end_loc);
     floating_ld = other.floating_ld;
     floating_st = other.floating_st;
+    successors = other.successors;
 
     return *this;
 }
@@ -50,7 +53,13 @@ std::string hip::BasicBlock::json() const {
     ss << "{\"id\":" << id << ",\"clang_id\":" << clang_id << ",\"begin\":\""
        << *begin_loc << "\",\"end\":\"" << *end_loc << "\",\"flops\": " << flops
        << ",\"floating_ld\":" << floating_ld
-       << ",\"floating_st\":" << floating_st << "}";
+       << ",\"floating_st\":" << floating_st << ",\"successors\":[";
+
+    for (auto i = 0u; i < successors.size(); ++i) {
+        ss << (i ? "," : "") << successors[i];
+    }
+
+    ss << "]}";
 
     return ss.str();
 }
@@ -86,7 +95,12 @@ BasicBlock BasicBlock::fromJson(const std::string& json) {
     unsigned int f_ld = root.get("floating_ld", 0u).asUInt();
     unsigned int f_st = root.get("floating_st", 0u).asUInt();
 
-    return {id, clang_id, flops, begin_loc, end_loc, f_ld, f_st};
+    BasicBlock block{id, clang_id, flops, begin_loc, end_loc, f_ld, f_st};
+    for (const auto& successor : root["successors"]) {
+        block.successors.emplace_back(successor.asUInt());
+    }
+
+    return block;
 }
 
 std::vector<BasicBlock> BasicBlock::fromJsonArray(const std::string& json) {
@@ -105,8 +119,11 @@ std::vector<BasicBlock> BasicBlock::fromJsonArray(const std::string& json) {
         unsigned int f_ld = value.get("floating_ld", 0u).asUInt();
         unsigned int f_st = value.get("floating_st", 0u).asUInt();
 
-        blocks.emplace_back(id, clang_id, flops, begin_loc, end_loc, f_ld,
-                            f_st);
+        auto& block = blocks.emplace_back(id, clang_id, flops, begin_loc,
+                                          end_loc, f_ld, f_st);
+        for (const auto& successor : value["successors"]) {
+            block.successors.emplace_back(successor.asUInt());
+        }
     }
 
     return blocks;
@@ -135,4 +152,18 @@ BasicBlock::normalized(const std::vector<BasicBlock>& blocks) {
     return b_norm;
 }
 
+std::vector<DeviceBlockInfo>
+DeviceBlockInfo::table(const std::vector<BasicBlock>& blocks,
+                       uint32_t bb_count) {
+    std::vector<DeviceBlockInfo> table(bb_count, {0u, 0u, 0u, 0u});
+
+    for (const auto& b : blocks) {
+        if (b.id < bb_count) {
+            table[b.id] = {b.flops, b.floating_ld, b.floating_st, present};
+        }
+    }
+
+    return table;
+}
+
 } // namespace hip
@@ -19,7 +19,9 @@
 
 #include <algorithm>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <set>
 #include <sstream>
 #include <string>
 
@@ -167,9 +169,21 @@ void hip::KernelCfgInstrumenter::run(const MatchFinder::MatchResult& Result) {
                                  clang::CFG::BuildOptions());
         cfg->dump(lang_opt, true);
 
+        // Clang id -> instrumented id, and successors of every CFG block, to
+        // store the instrumented CFG in the database
+        std::map<unsigned int, uint32_t> instrumented;
+        std::map<unsigned int, std::vector<unsigned int>> cfg_successors;
+        auto first_block = blocks.size();
+
         for (auto block : *cfg.get()) {
             auto id = block->getBlockID();
 
+            for (const auto& succ : block->succs()) {
+                if (auto reachable = succ.getReachableBlock()) {
+                    cfg_successors[id].emplace_back(reachable->getBlockID());
+                }
+            }
+
             std::cout << "\nBlock " << id << '\n';
 
             // If the block terminator is a for-loop, then do not instrument
@@ -219,10 +233,50 @@ void hip::KernelCfgInstrumenter::run(const MatchFinder::MatchResult& Result) {
                                     begin_loc.printToString(source_manager),
                                     end_loc.printToString(source_manager));
 
+                instrumented[id] = instr_generator->bb_count;
                 instr_generator->bb_count++;
             }
         }
 
+        // Successors in the instrumented CFG : skip through the blocks which
+        // were not instrumented. Reaching the exit of the CFG is recorded as
+        // a successor as well
+
+        auto exit_id = cfg->getExit().getBlockID();
+
+        for (auto i = first_block; i < blocks.size(); ++i) {
+            auto& block = blocks[i];
+            std::vector<unsigned int> stack = cfg_successors[block.clang_id];
+            std::set<unsigned int> visited(stack.begin(), stack.end());
+
+            while (!stack.empty()) {
+                auto succ = stack.back();
+                stack.pop_back();
+
+                if (succ == exit_id) {
+                    block.successors.emplace_back(hip::BasicBlock::exit_block);
+                    continue;
+                }
+
+                if (auto it = instrumented.find(succ);
+                    it != instrumented.end()) {
+                    block.successors.emplace_back(it->second);
+                    continue;
+                }
+
+                for (auto next : cfg_successors[succ]) {
+                    if (visited.insert(next).second) {
+                        stack.emplace_back(next);
+                    }
+                }
+            }
+
+            std::sort(block.successors.begin(), block.successors.end());
+            block.successors.erase(std::unique(block.successors.begin(),
+                                               block.successors.end()),
+                                   block.successors.end());
+        }
+
         addExtraParameters(match, source_manager, lang_opt);
 
         addLocals(match, source_manager, lang_opt);
@@ -445,6 +499,14 @@ makeCfgInstrumenter(const std::string& kernel,
     return std::make_unique<KernelCfgInstrumenter>(kernel, blocks);
 }
 
+std::unique_ptr<KernelCfgInstrumenter>
+makeCfgInstrumenter(const std::string& kernel,
+                    std::vector<hip::BasicBlock>& blocks,
+                    std::unique_ptr<hip::InstrGenerator> instr_gen) {
+    return std::make_unique<KernelCfgInstrumenter>(kernel, blocks,
+                                                   std::move(instr_gen));
+}
+
 std::unique_ptr<MatchFinder::MatchCallback>
 makeCudaCallInstrumenter(const std::string& kernel,
                          const std::string& output_file) {
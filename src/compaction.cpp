@@ -0,0 +1,48 @@
+/** \file compaction.cpp
+ * \brief Sparse representation of the instrumentation counters
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/compaction.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace hip {
+
+SparseCounters compactCounters(const uint8_t* counters, size_t size) {
+    if (size > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("hip::compactCounters() : Too many counters "
+                                 "for 32-bit indices");
+    }
+
+    SparseCounters sparse;
+
+    for (size_t i = 0u; i < size; ++i) {
+        if (counters[i] != 0u) {
+            sparse.indices.emplace_back(i);
+            sparse.counts.emplace_back(counters[i]);
+        }
+    }
+
+    return sparse;
+}
+
+void expandCounters(const SparseCounters& sparse, uint8_t* output,
+                    size_t size) {
+    std::fill(output, output + size, 0u);
+
+    for (size_t i = 0u; i < sparse.size(); ++i) {
+        auto index = sparse.indices[i];
+        if (index >= size) {
+            throw std::runtime_error("hip::expandCounters() : Index out of "
+                                     "bounds, incompatible sparse trace?");
+        }
+
+        output[index] = sparse.counts[i];
+    }
+}
+
+} // namespace hip
@@ -0,0 +1,110 @@
+/** \file counter_monitor.cpp
+ * \brief Host-side live sampling of instrumentation counters during a kernel
+ * execution
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/counter_monitor.hpp"
+#include "hip_instrumentation/hip_utils.hpp"
+
+#include <cstring>
+
+namespace hip {
+
+CounterMonitor::CounterMonitor(unsigned int bblocks,
+                               std::chrono::microseconds i)
+    : bb_count(bblocks), interval(i) {
+    auto size = bb_count * sizeof(live_counter_t);
+
+    // Coherent memory is required to see the updates made by the device
+    // during the kernel execution, without any synchronization
+    hip::check(hipHostMalloc(&host_ptr, size,
+                             hipHostMallocMapped | hipHostMallocCoherent));
+    hip::check(hipHostGetDevicePointer(&device_ptr, host_ptr, 0));
+
+    std::memset(host_ptr, 0, size);
+}
+
+CounterMonitor::~CounterMonitor() {
+    stop();
+
+    // Can't throw in a destructor, ignore the return value
+    (void)hipHostFree(host_ptr);
+}
+
+void CounterMonitor::start() {
+    if (running) {
+        return;
+    }
+
+    std::memset(host_ptr, 0, bb_count * sizeof(live_counter_t));
+
+    {
+        std::lock_guard lock(snapshots_mutex);
+        history.clear();
+    }
+
+    t0 = std::chrono::steady_clock::now();
+    running = true;
+    sampler = std::thread(&CounterMonitor::run, this);
+}
+
+void CounterMonitor::stop() {
+    if (!running) {
+        return;
+    }
+
+    running = false;
+    sampler.join();
+
+    // Final values, the kernel should have completed by now
+    sample();
+}
+
+void CounterMonitor::run() {
+    auto next = std::chrono::steady_clock::now();
+
+    while (running) {
+        sample();
+
+        next += interval;
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void CounterMonitor::sample() {
+    ProgressSnapshot snapshot;
+
+    auto now = std::chrono::steady_clock::now();
+    snapshot.elapsed =
+        std::chrono::duration_cast<std::chrono::microseconds>(now - t0)
+            .count();
+
+    snapshot.totals.reserve(bb_count);
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        // The device may be updating the value concurrently
+        std::atomic_ref<live_counter_t> value(host_ptr[bb]);
+        snapshot.totals.emplace_back(value.load(std::memory_order_relaxed));
+    }
+
+    std::lock_guard lock(snapshots_mutex);
+    history.emplace_back(std::move(snapshot));
+}
+
+std::vector<ProgressSnapshot> CounterMonitor::snapshots() const {
+    std::lock_guard lock(snapshots_mutex);
+    return history;
+}
+
+ProgressSnapshot CounterMonitor::latest() const {
+    std::lock_guard lock(snapshots_mutex);
+
+    if (history.empty()) {
+        return {0u, std::vector<uint64_t>(bb_count, 0u)};
+    }
+
+    return history.back();
+}
+
+} // namespace hip
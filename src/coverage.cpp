@@ -0,0 +1,83 @@
+/** \file coverage.cpp
+ * \brief One-bit coverage traces : whether a thread executed a basic block,
+ * packed as one 64-bit word per (wavefront, basic block)
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/coverage.hpp"
+
+#include <bit>
+#include <stdexcept>
+
+namespace hip {
+
+std::vector<uint64_t> coverageFromCounters(const uint8_t* counters,
+                                           uint32_t total_blocks,
+                                           uint32_t threads_per_block,
+                                           uint32_t bb_count,
+                                           uint32_t wave_size) {
+    if (wave_size == 0u || wave_size > 64u) {
+        throw std::runtime_error(
+            "hip::coverageFromCounters() : Unsupported wavefront size");
+    }
+
+    auto waves = (threads_per_block + wave_size - 1) / wave_size;
+    std::vector<uint64_t> coverage(total_blocks * waves * bb_count, 0u);
+
+    for (auto block = 0u; block < total_blocks; ++block) {
+        for (auto thread = 0u; thread < threads_per_block; ++thread) {
+            auto wave = thread / wave_size;
+            auto lane = thread % wave_size;
+
+            auto thread_counters =
+                &counters[(block * threads_per_block + thread) * bb_count];
+            auto words = &coverage[(block * waves + wave) * bb_count];
+
+            for (auto bb = 0u; bb < bb_count; ++bb) {
+                words[bb] |= static_cast<uint64_t>(thread_counters[bb] != 0u)
+                             << lane;
+            }
+        }
+    }
+
+    return coverage;
+}
+
+std::vector<uint8_t> activeLanes(const std::vector<uint64_t>& coverage) {
+    std::vector<uint8_t> lanes(coverage.size());
+
+    for (auto i = 0u; i < coverage.size(); ++i) {
+        lanes[i] = static_cast<uint8_t>(std::popcount(coverage[i]));
+    }
+
+    return lanes;
+}
+
+std::vector<uint64_t> threadsPerBlock(const std::vector<uint64_t>& coverage,
+                                      uint32_t bb_count) {
+    std::vector<uint64_t> threads(bb_count, 0u);
+
+    for (auto i = 0u; i < coverage.size(); i += bb_count) {
+        for (auto bb = 0u; bb < bb_count; ++bb) {
+            threads[bb] += std::popcount(coverage[i + bb]);
+        }
+    }
+
+    return threads;
+}
+
+std::vector<uint32_t> blocksPerWave(const std::vector<uint64_t>& coverage,
+                                    uint32_t bb_count) {
+    std::vector<uint32_t> blocks(coverage.size() / bb_count, 0u);
+
+    for (auto wave = 0u; wave < blocks.size(); ++wave) {
+        for (auto bb = 0u; bb < bb_count; ++bb) {
+            blocks[wave] += coverage[wave * bb_count + bb] != 0u;
+        }
+    }
+
+    return blocks;
+}
+
+} // namespace hip
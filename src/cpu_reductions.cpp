@@ -0,0 +1,138 @@
+/** \file cpu_reductions.cpp
+ * \brief Host reductions of the instrumentation data
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/cpu_reductions.hpp"
+#include "hip_instrumentation/parallel.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace hip {
+
+namespace cpu {
+
+namespace {
+
+/** \brief Minimum width (in counters) of a row, so the sums are vectorized
+ * even with few basic blocks
+ */
+constexpr uint32_t min_row_width = 64u;
+
+/** \brief Rows summed in the 16-bit accumulators before they are flushed :
+ * 257 * 255 = 65535
+ */
+constexpr size_t flush_period = 257u;
+
+/** \brief Counters processed by a task. Also bounds the 32-bit accumulators to
+ * (task_size / min_row_width) * 255, which can't overflow
+ */
+constexpr size_t task_size = 1u << 22;
+
+/** \fn rowWidth
+ * \brief Smallest multiple of bb_count of at least min_row_width
+ */
+uint32_t rowWidth(uint32_t bb_count) {
+    return bb_count * ((min_row_width + bb_count - 1) / bb_count);
+}
+
+/** \fn sumRange
+ * \brief Per basic block sums of a range of counters, starting with the first
+ * basic block
+ *
+ * \param sums Output array of size bb_count
+ */
+void sumRange(const uint8_t* counters, size_t size, uint32_t width,
+              uint32_t bb_count, uint64_t* sums) {
+    std::vector<uint16_t> acc16(width, 0u);
+    std::vector<uint32_t> acc32(width, 0u);
+
+    auto rows = size / width;
+
+    for (size_t row = 0u; row < rows;) {
+        auto end = std::min(rows, row + flush_period);
+
+        // Widening sum, u8 -> u16
+        for (; row < end; ++row) {
+            auto src = &counters[row * width];
+            for (auto j = 0u; j < width; ++j) {
+                acc16[j] += src[j];
+            }
+        }
+
+        // Flush, u16 -> u32
+        for (auto j = 0u; j < width; ++j) {
+            acc32[j] += acc16[j];
+            acc16[j] = 0u;
+        }
+    }
+
+    for (auto j = 0u; j < width; ++j) {
+        sums[j % bb_count] += acc32[j];
+    }
+
+    // Incomplete row
+    for (auto i = rows * width; i < size; ++i) {
+        sums[i % bb_count] += counters[i];
+    }
+}
+
+} // namespace
+
+std::vector<uint64_t> reduceCounts(const uint8_t* counters, size_t size,
+                                   uint32_t bb_count, unsigned int threads) {
+    auto width = rowWidth(bb_count);
+
+    // Tasks start on a row boundary, hence on the first basic block
+    auto task_length = std::max<size_t>(task_size / width, 1u) * width;
+    auto tasks = (size + task_length - 1) / task_length;
+
+    std::vector<uint64_t> partials(tasks * bb_count, 0u);
+
+    parallelFor(
+        tasks,
+        [&](size_t task) {
+            auto begin = task * task_length;
+            auto length = std::min(task_length, size - begin);
+
+            sumRange(&counters[begin], length, width, bb_count,
+                     &partials[task * bb_count]);
+        },
+        threads);
+
+    // Merge the partial sums in order
+    std::vector<uint64_t> counts(bb_count, 0u);
+
+    for (size_t task = 0u; task < tasks; ++task) {
+        for (auto bb = 0u; bb < bb_count; ++bb) {
+            counts[bb] += partials[task * bb_count + bb];
+        }
+    }
+
+    return counts;
+}
+
+std::vector<BlockUsage>
+reduceBlockUsage(const uint8_t* counters, size_t size,
+                 const std::vector<BasicBlock>& blocks_info, uint32_t bb_count,
+                 unsigned int threads) {
+    if (blocks_info.size() < bb_count) {
+        throw std::runtime_error(
+            "hip::cpu::reduceBlockUsage() : Incomplete block database");
+    }
+
+    auto counts = reduceCounts(counters, size, bb_count, threads);
+
+    std::vector<BlockUsage> usage(bb_count);
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        usage[bb] = {counts[bb], counts[bb] * blocks_info[bb].flops};
+    }
+
+    return usage;
+}
+
+} // namespace cpu
+
+} // namespace hip
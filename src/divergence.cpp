@@ -0,0 +1,220 @@
+/** \file divergence.cpp
+ * \brief Wavefront divergence analysis of the per-thread counters
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/divergence.hpp"
+#include "hip_instrumentation/parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace hip {
+
+void BlockDivergence::merge(const BlockDivergence& other) {
+    executed_waves += other.executed_waves;
+    divergent_waves += other.divergent_waves;
+    issued += other.issued;
+    lane_executions += other.lane_executions;
+    lane_slots += other.lane_slots;
+    active_lanes += other.active_lanes;
+    lanes += other.lanes;
+    distinct_counts += other.distinct_counts;
+}
+
+std::vector<uint32_t> DivergenceReport::worstBlocks(size_t n) const {
+    std::vector<uint32_t> ids(blocks.size());
+    std::iota(ids.begin(), ids.end(), 0u);
+
+    n = std::min(n, ids.size());
+    std::partial_sort(ids.begin(), ids.begin() + n, ids.end(),
+                      [&](auto lhs, auto rhs) {
+                          return blocks[lhs].wastedSlots() >
+                                 blocks[rhs].wastedSlots();
+                      });
+
+    ids.resize(n);
+    return ids;
+}
+
+std::vector<size_t> DivergenceReport::worstWaves(size_t n) const {
+    std::vector<size_t> ids(waves.size());
+    std::iota(ids.begin(), ids.end(), 0u);
+
+    n = std::min(n, ids.size());
+    std::partial_sort(ids.begin(), ids.begin() + n, ids.end(),
+                      [&](auto lhs, auto rhs) {
+                          return waves[lhs].wastedSlots() >
+                                 waves[rhs].wastedSlots();
+                      });
+
+    ids.resize(n);
+    return ids;
+}
+
+namespace {
+
+/** \struct WaveScratch
+ * \brief Per basic block accumulators for a single wavefront
+ */
+struct WaveScratch {
+    std::vector<uint8_t> max;
+    std::vector<uint32_t> sum;
+    std::vector<uint32_t> active;
+
+    /** \brief Bitset of the count values seen (256 bits per block)
+     */
+    std::vector<std::array<uint64_t, 4>> seen;
+
+    std::vector<const uint8_t*> lane_counters;
+
+    WaveScratch(uint32_t bb_count, uint32_t wave_size)
+        : max(bb_count), sum(bb_count), active(bb_count), seen(bb_count),
+          lane_counters(wave_size) {}
+
+    void reset() {
+        std::fill(max.begin(), max.end(), 0u);
+        std::fill(sum.begin(), sum.end(), 0u);
+        std::fill(active.begin(), active.end(), 0u);
+        std::fill(seen.begin(), seen.end(), std::array<uint64_t, 4>{});
+    }
+};
+
+/** \fn distinctVectors
+ * \brief Number of distinct counter vectors among the lanes of a wavefront
+ */
+uint32_t distinctVectors(std::vector<const uint8_t*>& lanes, uint32_t count,
+                         uint32_t bb_count) {
+    auto end = lanes.begin() + count;
+    auto compare = [bb_count](auto lhs, auto rhs) {
+        return std::memcmp(lhs, rhs, bb_count) < 0;
+    };
+    auto equal = [bb_count](auto lhs, auto rhs) {
+        return std::memcmp(lhs, rhs, bb_count) == 0;
+    };
+
+    std::sort(lanes.begin(), end, compare);
+    return std::distance(lanes.begin(), std::unique(lanes.begin(), end, equal));
+}
+
+/** \fn analyzeWave
+ * \brief Accumulates the divergence of a wavefront in blocks, and returns its
+ * summary
+ */
+WaveDivergence analyzeWave(const uint8_t* wave_counters, uint32_t lanes,
+                           uint32_t bb_count, WaveScratch& scratch,
+                           std::vector<BlockDivergence>& blocks) {
+    scratch.reset();
+
+    // Lane-major traversal, following the memory layout
+    for (auto lane = 0u; lane < lanes; ++lane) {
+        auto counters = &wave_counters[lane * bb_count];
+        scratch.lane_counters[lane] = counters;
+
+        for (auto bb = 0u; bb < bb_count; ++bb) {
+            auto count = counters[bb];
+            scratch.max[bb] = std::max(scratch.max[bb], count);
+            scratch.sum[bb] += count;
+            scratch.active[bb] += count != 0u;
+            scratch.seen[bb][count >> 6] |= 1ull << (count & 63u);
+        }
+    }
+
+    WaveDivergence wave{0u, 0u, lanes, 0u, 0u, 0u, 0u};
+
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        if (scratch.max[bb] == 0u) {
+            continue;
+        }
+
+        uint32_t distinct = 0u;
+        for (auto word : scratch.seen[bb]) {
+            distinct += std::popcount(word);
+        }
+
+        auto& block = blocks[bb];
+        ++block.executed_waves;
+        block.divergent_waves += distinct > 1u;
+        block.issued += scratch.max[bb];
+        block.lane_executions += scratch.sum[bb];
+        block.lane_slots += scratch.max[bb] * lanes;
+        block.active_lanes += scratch.active[bb];
+        block.lanes += lanes;
+        block.distinct_counts += distinct;
+
+        wave.issued += scratch.max[bb];
+        wave.lane_executions += scratch.sum[bb];
+        wave.lane_slots += scratch.max[bb] * lanes;
+    }
+
+    wave.distinct_vectors =
+        distinctVectors(scratch.lane_counters, lanes, bb_count);
+
+    return wave;
+}
+
+} // namespace
+
+DivergenceReport analyzeDivergence(const uint8_t* counters,
+                                   uint32_t total_blocks,
+                                   uint32_t threads_per_block,
+                                   uint32_t bb_count, uint32_t wave_size,
+                                   unsigned int threads) {
+    if (wave_size == 0u) {
+        throw std::runtime_error(
+            "hip::analyzeDivergence() : Invalid wavefront size");
+    }
+
+    auto waves_per_block = (threads_per_block + wave_size - 1) / wave_size;
+
+    DivergenceReport report;
+    report.blocks.resize(bb_count);
+    report.waves.resize(total_blocks * waves_per_block);
+
+    // Each range of workgroups has its own block accumulators
+    parallelReduce(
+        total_blocks,
+        [&]() { return std::vector<BlockDivergence>(bb_count); },
+        [&](std::vector<BlockDivergence>& blocks, size_t begin, size_t end) {
+            WaveScratch scratch(bb_count, wave_size);
+
+            for (auto workgroup = begin; workgroup < end; ++workgroup) {
+                for (auto w = 0u; w < waves_per_block; ++w) {
+                    auto first_thread = w * wave_size;
+                    auto lanes =
+                        std::min(wave_size, threads_per_block - first_thread);
+
+                    auto wave_counters =
+                        &counters[(workgroup * threads_per_block +
+                                   first_thread) *
+                                  bb_count];
+
+                    auto wave = analyzeWave(wave_counters, lanes, bb_count,
+                                            scratch, blocks);
+                    wave.workgroup = workgroup;
+                    wave.wave = w;
+
+                    report.waves[workgroup * waves_per_block + w] = wave;
+                }
+            }
+        },
+        [&](const std::vector<BlockDivergence>& blocks) {
+            for (auto bb = 0u; bb < blocks.size(); ++bb) {
+                report.blocks[bb].merge(blocks[bb]);
+            }
+        },
+        threads);
+
+    for (const auto& block : report.blocks) {
+        report.total.merge(block);
+    }
+
+    return report;
+}
+
+} // namespace hip
@@ -0,0 +1,283 @@
+/** \file equivalence.cpp
+ * \brief Thread equivalence classes per wavefront and per workgroup
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/equivalence.hpp"
+#include "hip_instrumentation/parallel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace hip {
+
+void EquivalenceStats::merge(const EquivalenceStats& other) {
+    for (auto i = 0u; i < histogram.size(); ++i) {
+        histogram[i] += other.histogram[i];
+    }
+
+    groups += other.groups;
+    threads += other.threads;
+    classes += other.classes;
+    max_classes = std::max(max_classes, other.max_classes);
+    majority_threads += other.majority_threads;
+
+    distinguishing.resize(
+        std::max(distinguishing.size(), other.distinguishing.size()), 0u);
+    for (auto bb = 0u; bb < other.distinguishing.size(); ++bb) {
+        distinguishing[bb] += other.distinguishing[bb];
+    }
+}
+
+std::vector<uint32_t> EquivalenceReport::worstWorkgroups(size_t n) const {
+    std::vector<uint32_t> ids(workgroup_classes.size());
+    std::iota(ids.begin(), ids.end(), 0u);
+
+    n = std::min(n, ids.size());
+    std::partial_sort(ids.begin(), ids.begin() + n, ids.end(),
+                      [&](auto lhs, auto rhs) {
+                          return workgroup_classes[lhs] >
+                                 workgroup_classes[rhs];
+                      });
+
+    ids.resize(n);
+    return ids;
+}
+
+std::vector<uint32_t> EquivalenceReport::distinguishingBlocks(size_t n) const {
+    const auto& counts = waves.distinguishing;
+
+    std::vector<uint32_t> ids(counts.size());
+    std::iota(ids.begin(), ids.end(), 0u);
+
+    n = std::min(n, ids.size());
+    std::partial_sort(
+        ids.begin(), ids.begin() + n, ids.end(),
+        [&](auto lhs, auto rhs) { return counts[lhs] > counts[rhs]; });
+
+    ids.resize(n);
+    return ids;
+}
+
+void hashThreads(const uint8_t* counters, uint32_t threads, uint32_t bb_count,
+                 uint32_t* hashes) {
+    // FNV-1a, see hashCounters, one lane per thread. The counters of a batch
+    // are transposed tile by tile to [bblock][lane], so the hash loop reads
+    // them contiguously
+    constexpr uint32_t batch = 64u;
+    constexpr uint32_t tile = 64u;
+
+    uint8_t transposed[tile][batch];
+
+    for (auto first = 0u; first < threads; first += batch) {
+        auto lanes = std::min(batch, threads - first);
+        auto batch_counters = &counters[static_cast<size_t>(first) * bb_count];
+
+        uint32_t hash[batch];
+        std::fill(hash, hash + batch, 2166136261u);
+
+        // The missing lanes of a partial batch hash zeroes, and are discarded
+        if (lanes < batch) {
+            std::memset(transposed, 0, sizeof(transposed));
+        }
+
+        for (auto first_bb = 0u; first_bb < bb_count; first_bb += tile) {
+            auto bbs = std::min(tile, bb_count - first_bb);
+
+            for (auto lane = 0u; lane < lanes; ++lane) {
+                auto row = &batch_counters[lane * bb_count + first_bb];
+                for (auto bb = 0u; bb < bbs; ++bb) {
+                    transposed[bb][lane] = row[bb];
+                }
+            }
+
+            for (auto bb = 0u; bb < bbs; ++bb) {
+                for (auto lane = 0u; lane < batch; ++lane) {
+                    hash[lane] =
+                        (hash[lane] ^ transposed[bb][lane]) * 16777619u;
+                }
+            }
+        }
+
+        std::copy(hash, hash + lanes, hashes + first);
+    }
+}
+
+namespace {
+
+/** \struct Classifier
+ * \brief Equivalence classes of a group of threads, in the order of their
+ * first occurrence
+ */
+struct Classifier {
+    /** \brief Open-addressing hash table (linear probing) of the classes, at
+     * least twice as large as the group. A slot holds the class index + 1, or
+     * 0 if empty
+     */
+    std::vector<uint32_t> table;
+
+    std::vector<uint32_t> class_hashes;
+    std::vector<const uint8_t*> representatives;
+    std::vector<uint32_t> sizes;
+
+    /** \fn classify
+     * \brief Classifies consecutive threads, given their hashes
+     */
+    void classify(const uint8_t* counters, const uint32_t* hashes,
+                  uint32_t threads, uint32_t bb_count) {
+        auto capacity = std::bit_ceil(std::max(2u * threads, 2u));
+        auto shift = 32 - std::countr_zero(capacity);
+        table.assign(capacity, 0u);
+
+        class_hashes.clear();
+        representatives.clear();
+        sizes.clear();
+
+        for (auto thread = 0u; thread < threads; ++thread) {
+            auto thread_counters = &counters[thread * bb_count];
+            auto hash = hashes[thread];
+
+            // Fibonacci hashing, the low bits of FNV-1a are not well mixed
+            auto slot = (hash * 2654435769u) >> shift;
+
+            while (true) {
+                auto entry = table[slot];
+
+                if (entry == 0u) {
+                    table[slot] = representatives.size() + 1u;
+                    class_hashes.emplace_back(hash);
+                    representatives.emplace_back(thread_counters);
+                    sizes.emplace_back(1u);
+                    break;
+                }
+
+                // The hash might collide
+                auto c = entry - 1u;
+                if (class_hashes[c] == hash &&
+                    std::memcmp(representatives[c], thread_counters,
+                                bb_count) == 0) {
+                    ++sizes[c];
+                    break;
+                }
+
+                slot = (slot + 1u) & (capacity - 1u);
+            }
+        }
+    }
+
+    /** \fn accumulate
+     * \brief Accounts for the classes of the last group in stats, returns
+     * the number of classes
+     */
+    uint32_t accumulate(EquivalenceStats& stats, uint32_t threads,
+                        uint32_t bb_count) const {
+        auto classes = static_cast<uint32_t>(sizes.size());
+
+        ++stats.groups;
+        stats.threads += threads;
+        stats.classes += classes;
+        stats.max_classes = std::max(stats.max_classes, classes);
+        stats.majority_threads += *std::max_element(sizes.begin(), sizes.end());
+        ++stats.histogram[std::min<size_t>(classes,
+                                           stats.histogram.size() - 1u)];
+
+        // A block distinguishes the classes if its count is not the same in
+        // all of them
+        if (classes > 1u) {
+            auto first = representatives[0];
+            for (auto bb = 0u; bb < bb_count; ++bb) {
+                for (auto c = 1u; c < classes; ++c) {
+                    if (representatives[c][bb] != first[bb]) {
+                        ++stats.distinguishing[bb];
+                        break;
+                    }
+                }
+            }
+        }
+
+        return classes;
+    }
+};
+
+/** \struct EquivalencePartial
+ * \brief Accumulators of a task
+ */
+struct EquivalencePartial {
+    EquivalenceStats waves;
+    EquivalenceStats workgroups;
+};
+
+} // namespace
+
+EquivalenceReport analyzeEquivalence(const uint8_t* counters,
+                                     uint32_t total_blocks,
+                                     uint32_t threads_per_block,
+                                     uint32_t bb_count, uint32_t wave_size,
+                                     unsigned int threads) {
+    if (wave_size == 0u) {
+        throw std::runtime_error(
+            "hip::analyzeEquivalence() : Invalid wavefront size");
+    }
+
+    EquivalenceReport report;
+    report.waves.distinguishing.resize(bb_count);
+    report.workgroups.distinguishing.resize(bb_count);
+    report.workgroup_classes.resize(total_blocks);
+
+    if (total_blocks == 0u || threads_per_block == 0u) {
+        return report;
+    }
+
+    auto waves_per_block = (threads_per_block + wave_size - 1) / wave_size;
+
+    parallelReduce(
+        total_blocks,
+        [&]() {
+            EquivalencePartial partial;
+            partial.waves.distinguishing.resize(bb_count);
+            partial.workgroups.distinguishing.resize(bb_count);
+            return partial;
+        },
+        [&](EquivalencePartial& partial, size_t begin, size_t end) {
+            Classifier classifier;
+            std::vector<uint32_t> hashes(threads_per_block);
+
+            for (auto workgroup = begin; workgroup < end; ++workgroup) {
+                auto workgroup_counters =
+                    &counters[workgroup * threads_per_block * bb_count];
+
+                // Hashed once, for the waves and the workgroup
+                hashThreads(workgroup_counters, threads_per_block, bb_count,
+                            hashes.data());
+
+                for (auto w = 0u; w < waves_per_block; ++w) {
+                    auto first_thread = w * wave_size;
+                    auto lanes =
+                        std::min(wave_size, threads_per_block - first_thread);
+
+                    classifier.classify(
+                        &workgroup_counters[first_thread * bb_count],
+                        &hashes[first_thread], lanes, bb_count);
+                    classifier.accumulate(partial.waves, lanes, bb_count);
+                }
+
+                classifier.classify(workgroup_counters, hashes.data(),
+                                    threads_per_block, bb_count);
+                report.workgroup_classes[workgroup] = classifier.accumulate(
+                    partial.workgroups, threads_per_block, bb_count);
+            }
+        },
+        [&](const EquivalencePartial& partial) {
+            report.waves.merge(partial.waves);
+            report.workgroups.merge(partial.workgroups);
+        },
+        threads);
+
+    return report;
+}
+
+} // namespace hip
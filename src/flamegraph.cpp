@@ -0,0 +1,143 @@
+/** \file flamegraph.cpp
+ * \brief Folded stacks of the basic blocks of a kernel
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/flamegraph.hpp"
+#include "hip_instrumentation/cpu_reductions.hpp"
+#include "hip_instrumentation/loops.hpp"
+#include "hip_instrumentation/source_map.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace hip {
+
+namespace {
+
+/** \fn sanitize
+ * \brief Replaces the characters with a meaning in the folded format : ';'
+ * separates the frames, the last space precedes the weight
+ */
+std::string sanitize(std::string frame) {
+    std::replace_if(
+        frame.begin(), frame.end(),
+        [](char c) { return c == ';' || c == ' ' || c == '\n'; }, '_');
+    return frame;
+}
+
+/** \fn sourceRange
+ * \brief "file:first-last" frame of a block, or its raw location if it can't
+ * be parsed
+ */
+std::string sourceRange(const BasicBlock& block) {
+    auto begin = SourceLocation::parse(*block.begin_loc);
+    auto end = SourceLocation::parse(*block.end_loc);
+
+    if (!begin) {
+        return sanitize(*block.begin_loc);
+    }
+
+    std::stringstream ss;
+    ss << begin->file << ':' << begin->line;
+    if (end && end->file == begin->file && end->line != begin->line) {
+        ss << '-' << end->line;
+    }
+
+    return sanitize(ss.str());
+}
+
+uint64_t blockWeight(const BasicBlock& block, uint64_t count,
+                     FlameWeight weight) {
+    switch (weight) {
+    case FlameWeight::Flops:
+        return count * block.flops;
+    case FlameWeight::Bytes:
+        return count * (static_cast<uint64_t>(block.floating_ld) +
+                        block.floating_st);
+    default:
+        return count;
+    }
+}
+
+} // namespace
+
+std::string FoldedStack::line() const {
+    std::stringstream ss;
+    for (auto i = 0u; i < frames.size(); ++i) {
+        ss << (i ? ";" : "") << frames[i];
+    }
+    ss << ' ' << weight;
+
+    return ss.str();
+}
+
+std::vector<FoldedStack> foldStacks(const std::string& kernel,
+                                    const std::vector<uint64_t>& counts,
+                                    const std::vector<BasicBlock>& blocks,
+                                    FlameWeight weight, bool loops) {
+    std::vector<Loop> kernel_loops;
+    std::vector<BasicBlock> normalized;
+
+    if (loops && !blocks.empty()) {
+        normalized = BasicBlock::normalized(blocks);
+        kernel_loops = findLoops(normalized);
+
+        // Outermost first
+        std::stable_sort(kernel_loops.begin(), kernel_loops.end(),
+                         [](const auto& lhs, const auto& rhs) {
+                             return lhs.depth < rhs.depth;
+                         });
+    }
+
+    auto kernel_frame = sanitize(kernel);
+
+    std::vector<FoldedStack> stacks;
+    for (const auto& block : blocks) {
+        if (block.id >= counts.size()) {
+            continue;
+        }
+
+        auto value = blockWeight(block, counts[block.id], weight);
+        if (value == 0u) {
+            continue;
+        }
+
+        FoldedStack stack{{kernel_frame}, value};
+
+        for (const auto& loop : kernel_loops) {
+            if (std::binary_search(loop.body.begin(), loop.body.end(),
+                                   block.id)) {
+                stack.frames.emplace_back(
+                    "loop@" + sourceRange(normalized[loop.header]));
+            }
+        }
+
+        stack.frames.emplace_back(sourceRange(block));
+        stack.frames.emplace_back("bb_" + std::to_string(block.id));
+
+        stacks.emplace_back(std::move(stack));
+    }
+
+    return stacks;
+}
+
+std::vector<FoldedStack> foldStacks(const std::string& kernel,
+                                    const uint8_t* counters, size_t size,
+                                    uint32_t bb_count,
+                                    const std::vector<BasicBlock>& blocks,
+                                    FlameWeight weight, bool loops,
+                                    unsigned int threads) {
+    auto counts = cpu::reduceCounts(counters, size, bb_count, threads);
+    return foldStacks(kernel, counts, blocks, weight, loops);
+}
+
+void writeFoldedStacks(std::ostream& out,
+                       const std::vector<FoldedStack>& stacks) {
+    for (const auto& stack : stacks) {
+        out << stack.line() << '\n';
+    }
+}
+
+} // namespace hip
@@ -7,57 +7,47 @@
 #include <chrono>
 #include <numeric>
 
+#include "hip_instrumentation/compaction_kernels.hpp"
 #include "hip_instrumentation/gpu_info.hpp"
 #include "hip_instrumentation/hip_instrumentation.hpp"
 #include "hip_instrumentation/hip_utils.hpp"
+#include "hip_instrumentation/metrics_kernels.hpp"
 #include "hip_instrumentation/reduction_kernels.hpp"
+#include "hip_instrumentation/signature_kernels.hpp"
 
-unsigned int hip::Instrumenter::reduceFlops(const counter_t* device_ptr,
-                                            hipStream_t stream) const {
+std::vector<hip::BlockUsage>
+hip::Instrumenter::reduceBlockUsage(const counter_t* device_ptr,
+                                    hipStream_t stream) const {
+    using namespace hip::reduction;
 
-    if (blocks.empty()) {
-        // The block database has to be loaded prior to reduction!
-        throw std::runtime_error("BasicBlock::normalized : Empty vector");
-    }
-
-    unsigned int num_blocks = 128u; // Ultimately, how many last reductions will
-                                    // we have to do on the cpu
-    unsigned int threads_per_block = 128u;
+    auto bb_count = kernel_info.basic_blocks;
+    auto size = kernel_info.instr_size;
 
-    // ----- Malloc & memcopy ----- //
+    // Launch geometry
 
-    // Temporary buffer
-    auto buf_size = num_blocks * threads_per_block * kernel_info.basic_blocks *
-                    sizeof(hip::BlockUsage);
+    unsigned int num_blocks = gridSize(size, bb_count);
+    size_t shared_size = bb_count * sizeof(unsigned long long);
 
-    hip::BlockUsage* buffer_ptr;
-    hip::check(hipMalloc(&buffer_ptr, buf_size));
+    int device;
+    hipDeviceProp_t properties;
+    hip::check(hipGetDevice(&device));
+    hip::check(hipGetDeviceProperties(&properties, device));
 
-    // Output buffer
+    if (shared_size > properties.sharedMemPerBlock) {
+        throw std::runtime_error("hip::Instrumenter::reduceBlockUsage() : Too "
+                                 "many basic blocks for the shared memory");
+    }
 
-    std::vector<hip::BlockUsage> output(num_blocks * kernel_info.basic_blocks,
-                                        {0u, 0u});
+    // ----- Malloc & memcopy ----- //
 
+    std::vector<hip::BlockUsage> output(bb_count);
     auto output_size = output.size() * sizeof(hip::BlockUsage);
 
     hip::BlockUsage* output_ptr;
-    hip::check(hipMalloc(&output_ptr, buf_size));
-
-    // Launch geometry
-
-    hip::LaunchGeometry geometry{kernel_info.total_threads_per_blocks,
-                                 kernel_info.total_blocks,
-                                 kernel_info.basic_blocks};
-
-    // Basic blocks
-    auto blocks_info = hip::BasicBlock::normalized(blocks);
-    auto blocks_info_size = blocks_info.size() * sizeof(hip::BasicBlock);
-
-    hip::BasicBlock* blocks_info_ptr;
-    hip::check(hipMalloc(&blocks_info_ptr, blocks_info_size));
+    hip::check(hipMalloc(&output_ptr, output_size));
+    hip::check(hipMemsetAsync(output_ptr, 0, output_size, stream));
 
-    hip::check(hipMemcpy(blocks_info_ptr, blocks_info.data(), blocks_info_size,
-                         hipMemcpyHostToDevice));
+    auto blocks_info_ptr = deviceBlocksInfo();
 
     // ----- Synchronization ----- //
     if (!stream) {
@@ -66,9 +56,9 @@ unsigned int hip::Instrumenter::reduceFlops(const counter_t* device_ptr,
 
     // ----- Launch kernel ----- //
 
-    ::hip::
-        reduceFlops<<<dim3(num_blocks), dim3(threads_per_block), 0, stream>>>(
-            device_ptr, geometry, blocks_info_ptr, buffer_ptr, output_ptr);
+    ::hip::reduceFlops<<<dim3(num_blocks), dim3(threads_per_block),
+                         shared_size, stream>>>(device_ptr, size, bb_count,
+                                                blocks_info_ptr, output_ptr);
 
     // ----- Fetch back data ----- //
 
@@ -78,33 +68,167 @@ unsigned int hip::Instrumenter::reduceFlops(const counter_t* device_ptr,
         hip::check(hipStreamSynchronize(stream));
     }
 
-    hip::check(hipMemcpy(output.data(), output_ptr,
-                         output.size() * sizeof(hip::BlockUsage),
+    hip::check(hipMemcpy(output.data(), output_ptr, output_size,
                          hipMemcpyDeviceToHost));
 
     // ----- Free device memory ----- //
 
     hip::check(hipFree(output_ptr));
-    hip::check(hipFree(buffer_ptr));
-    hip::check(hipFree(blocks_info_ptr));
-
-    // ----- Final reduction ----- //
 
-    unsigned int flops = 0u;
-    for (auto i = 0u; i < num_blocks; ++i) {
-        for (auto bb = 0u; bb < kernel_info.basic_blocks; ++bb) {
-            auto block_output = output[i * kernel_info.basic_blocks + bb];
+    return output;
+}
 
-            // std::cout << i << ' ' << bb << " : " << block_output.count <<
-            // '\n';
+uint64_t hip::Instrumenter::reduceFlops(const counter_t* device_ptr,
+                                        hipStream_t stream) const {
+    auto usage = reduceBlockUsage(device_ptr, stream);
 
-            flops += block_output.flops;
-        }
+    uint64_t flops = 0u;
+    for (const auto& block_usage : usage) {
+        flops += block_usage.flops;
     }
 
     return flops;
 }
 
+// Every metric at once, usable without compiling the device code
+template std::vector<hip::AllMetrics> hip::Instrumenter::reduce<
+    hip::metrics::Count, hip::metrics::Flops, hip::metrics::FloatingLoads,
+    hip::metrics::FloatingStores, hip::metrics::SumOfSquares,
+    hip::metrics::Min, hip::metrics::Max>(const counter_t* device_ptr,
+                                          hipStream_t stream) const;
+
+void hip::Instrumenter::fromDeviceSparse(void* device_ptr) {
+    using namespace hip::compaction;
+
+    // Same as fromDevice, the method is executed right after the kernel
+    stamp_end = getRoctracerStamp();
+
+    auto counters = static_cast<const counter_t*>(device_ptr);
+    auto size = kernel_info.instr_size;
+    auto nb_tiles = (size + tile_size - 1) / tile_size;
+
+    // ----- Prefix sum ----- //
+
+    uint32_t* tile_offsets;
+    uint32_t* total_ptr;
+    hip::check(hipMalloc(&tile_offsets, nb_tiles * sizeof(uint32_t)));
+    hip::check(hipMalloc(&total_ptr, sizeof(uint32_t)));
+
+    countNonZero<<<nb_tiles, threads_per_block>>>(counters, size,
+                                                  tile_offsets);
+    scanTiles<<<1, scan_threads>>>(tile_offsets, nb_tiles, total_ptr);
+
+    uint32_t total;
+    hip::check(hipMemcpy(&total, total_ptr, sizeof(uint32_t),
+                         hipMemcpyDeviceToHost));
+
+    // ----- Scatter ----- //
+
+    sparse_counters.indices.resize(total);
+    sparse_counters.counts.resize(total);
+
+    if (total != 0u) {
+        uint32_t* indices_ptr;
+        counter_t* counts_ptr;
+        hip::check(hipMalloc(&indices_ptr, total * sizeof(uint32_t)));
+        hip::check(hipMalloc(&counts_ptr, total * sizeof(counter_t)));
+
+        scatterNonZero<<<nb_tiles, threads_per_block>>>(
+            counters, size, tile_offsets, indices_ptr, counts_ptr);
+
+        hip::check(hipMemcpy(sparse_counters.indices.data(), indices_ptr,
+                             total * sizeof(uint32_t), hipMemcpyDeviceToHost));
+        hip::check(hipMemcpy(sparse_counters.counts.data(), counts_ptr,
+                             total * sizeof(counter_t),
+                             hipMemcpyDeviceToHost));
+
+        hip::check(hipFree(indices_ptr));
+        hip::check(hipFree(counts_ptr));
+    }
+
+    hip::check(hipFree(tile_offsets));
+    hip::check(hipFree(total_ptr));
+
+    dense_up_to_date = false;
+    signature_trace = {};
+
+    traceLaunch("fromDeviceSparse");
+    recordLaunch(counters);
+}
+
+void hip::Instrumenter::fromDeviceSignatures(void* device_ptr,
+                                             SignatureBuffers buffers) {
+    using namespace hip::signatures;
+
+    stamp_end = getRoctracerStamp();
+
+    auto total_blocks = kernel_info.total_blocks;
+    auto threads = kernel_info.total_threads_per_blocks;
+    auto bb_count = kernel_info.basic_blocks;
+
+    auto& trace = signature_trace;
+
+    // ----- Dictionary offsets ----- //
+
+    std::vector<uint32_t> counts(total_blocks);
+    hip::check(hipMemcpy(counts.data(), buffers.counts,
+                         total_blocks * sizeof(uint32_t),
+                         hipMemcpyDeviceToHost));
+
+    trace.offsets.resize(total_blocks + 1);
+    trace.offsets[0] = 0u;
+    std::partial_sum(counts.begin(), counts.end(), trace.offsets.begin() + 1);
+
+    auto nb_signatures = trace.offsets.back();
+
+    uint32_t* offsets_ptr;
+    hip::check(
+        hipMalloc(&offsets_ptr, trace.offsets.size() * sizeof(uint32_t)));
+    hip::check(hipMemcpy(offsets_ptr, trace.offsets.data(),
+                         trace.offsets.size() * sizeof(uint32_t),
+                         hipMemcpyHostToDevice));
+
+    // ----- Pack & fetch dictionaries ----- //
+
+    auto dictionary_size = nb_signatures * bb_count * sizeof(counter_t);
+
+    counter_t* packed_ptr;
+    hip::check(hipMalloc(&packed_ptr, dictionary_size));
+
+    auto counters = static_cast<counter_t*>(device_ptr);
+
+    packDictionaries<<<total_blocks, threads_per_block>>>(
+        counters, offsets_ptr, threads, bb_count, packed_ptr);
+
+    trace.dictionary.resize(nb_signatures * bb_count);
+    trace.thread_signatures.resize(total_blocks * threads);
+
+    hip::check(hipMemcpy(trace.dictionary.data(), packed_ptr, dictionary_size,
+                         hipMemcpyDeviceToHost));
+    hip::check(hipMemcpy(trace.thread_signatures.data(), buffers.indices,
+                         trace.thread_signatures.size() *
+                             sizeof(signature_index_t),
+                         hipMemcpyDeviceToHost));
+
+    // ----- Reconstruct full counters ----- //
+
+    expandDictionaries<<<total_blocks, threads_per_block>>>(
+        packed_ptr, offsets_ptr, buffers.indices, threads, bb_count, counters);
+
+    expandSignatures(trace, threads, bb_count, host_counters.data());
+    dense_up_to_date = true;
+
+    hip::check(hipDeviceSynchronize());
+
+    hip::check(hipFree(offsets_ptr));
+    hip::check(hipFree(packed_ptr));
+    hip::check(hipFree(buffers.counts));
+    hip::check(hipFree(buffers.indices));
+
+    traceLaunch("fromDeviceSignatures");
+    recordLaunch(counters);
+}
+
 namespace hip {
 namespace benchmark {
 
@@ -6,7 +6,13 @@
 
 #include "hip_instrumentation/gpu_info.hpp"
 
+#include <fstream>
 #include <sstream>
+#include <stdexcept>
+
+// Jsoncpp (shipped with ubuntu & debian)
+
+#include <json/json.h>
 
 std::string hip::GpuInfo::json() const {
     std::stringstream ss;
@@ -38,6 +44,34 @@ std::string hip::GpuInfo::json() const {
     return ss.str();
 }
 
+hip::GpuInfo hip::GpuInfo::fromJson(const std::string& filename) {
+    Json::Value root;
+
+    std::ifstream file_in(filename);
+    if (!file_in.is_open()) {
+        throw std::runtime_error("hip::GpuInfo::fromJson() : Could not open " +
+                                 filename);
+    }
+
+    file_in >> root;
+
+    GpuInfo gpu_info{root.get("name", "").asString()};
+
+    for (const auto& roof : root["memory_roofs"]) {
+        gpu_info.memory_roofs.push_back(
+            {roof.get("name", "").asString(),
+             roof.get("peak_bandwidth", 0.).asDouble()});
+    }
+
+    for (const auto& roof : root["compute_roofs"]) {
+        gpu_info.compute_roofs.push_back(
+            {roof.get("name", "").asString(),
+             roof.get("peak_flops_s", 0.).asDouble()});
+    }
+
+    return gpu_info;
+}
+
 void hip::GpuInfo::benchmark() {
     // Memory benchmarks
 
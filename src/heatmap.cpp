@@ -0,0 +1,336 @@
+/** \file heatmap.cpp
+ * \brief Heatmap of the counters of a trace
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/heatmap.hpp"
+#include "hip_instrumentation/parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+namespace hip {
+
+// ----- Image ----- //
+
+namespace {
+
+/** \fn crc32
+ * \brief CRC-32 (ISO 3309) of a PNG chunk, continued from crc
+ */
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0u) {
+    static const auto table = []() {
+        std::array<uint32_t, 256> table;
+        for (auto n = 0u; n < table.size(); ++n) {
+            uint32_t c = n;
+            for (auto k = 0u; k < 8u; ++k) {
+                c = (c & 1u) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+        return table;
+    }();
+
+    crc = ~crc;
+    for (auto i = 0u; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xffu] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+/** \fn adler32
+ * \brief Checksum of the zlib stream
+ */
+uint32_t adler32(const uint8_t* data, size_t size) {
+    constexpr uint32_t modulo = 65521u;
+    uint32_t a = 1u, b = 0u;
+
+    for (auto i = 0u; i < size; ++i) {
+        a = (a + data[i]) % modulo;
+        b = (b + a) % modulo;
+    }
+
+    return (b << 16) | a;
+}
+
+void appendBigEndian(std::vector<uint8_t>& buffer, uint32_t value) {
+    for (auto shift : {24, 16, 8, 0}) {
+        buffer.emplace_back((value >> shift) & 0xffu);
+    }
+}
+
+void writeChunk(std::ofstream& out, const char* type,
+                const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk;
+    chunk.reserve(data.size() + 12u);
+
+    appendBigEndian(chunk, data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+
+    // The CRC covers the type and the data
+    appendBigEndian(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+
+    out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+std::ofstream openImage(const std::string& filename, const char* method) {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error(std::string("hip::Image::") + method +
+                                 "() : Could not open " + filename);
+    }
+
+    return out;
+}
+
+} // namespace
+
+void Image::writePpm(const std::string& filename) const {
+    auto out = openImage(filename, "writePpm");
+
+    out << "P6\n" << width << ' ' << height << "\n255\n";
+    out.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+}
+
+void Image::writePng(const std::string& filename) const {
+    auto out = openImage(filename, "writePng");
+
+    constexpr uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a,
+                                     '\n'};
+    out.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    std::vector<uint8_t> header;
+    appendBigEndian(header, width);
+    appendBigEndian(header, height);
+    // 8 bits per channel, RGB, deflate, adaptive filtering, no interlacing
+    header.insert(header.end(), {8u, 2u, 0u, 0u, 0u});
+    writeChunk(out, "IHDR", header);
+
+    // Scanlines, each preceded by its filter type (none)
+    auto stride = static_cast<size_t>(width) * 3u;
+    std::vector<uint8_t> raw;
+    raw.reserve(height * (stride + 1u));
+
+    for (auto y = 0u; y < height; ++y) {
+        raw.emplace_back(0u);
+        raw.insert(raw.end(), rgb.begin() + y * stride,
+                   rgb.begin() + (y + 1) * stride);
+    }
+
+    // zlib stream of stored (uncompressed) deflate blocks
+    constexpr size_t max_block = 65535u;
+
+    std::vector<uint8_t> data{0x78, 0x01};
+    data.reserve(raw.size() + raw.size() / max_block * 5u + 16u);
+
+    size_t offset = 0u;
+    do {
+        auto size = std::min(max_block, raw.size() - offset);
+        auto last = offset + size == raw.size();
+
+        data.emplace_back(last ? 1u : 0u);
+        data.emplace_back(size & 0xffu);
+        data.emplace_back(size >> 8);
+        data.emplace_back(~size & 0xffu);
+        data.emplace_back((~size >> 8) & 0xffu);
+        data.insert(data.end(), raw.begin() + offset,
+                    raw.begin() + offset + size);
+
+        offset += size;
+    } while (offset < raw.size());
+
+    appendBigEndian(data, adler32(raw.data(), raw.size()));
+    writeChunk(out, "IDAT", data);
+
+    writeChunk(out, "IEND", {});
+}
+
+void Image::write(const std::string& filename) const {
+    auto ppm = filename.size() >= 4u &&
+               filename.compare(filename.size() - 4u, 4u, ".ppm") == 0;
+
+    if (ppm) {
+        writePpm(filename);
+    } else {
+        writePng(filename);
+    }
+}
+
+// ----- HeatmapReducer ----- //
+
+HeatmapReducer::HeatmapReducer(uint32_t total_blocks,
+                               uint32_t threads_per_block, uint32_t bb_count,
+                               Rows rows, uint32_t max_rows,
+                               uint32_t max_columns, unsigned int threads)
+    : threads_per_block(threads_per_block), bb_count(bb_count),
+      row_kind(rows), threads(threads) {
+    if (max_rows == 0u || max_columns == 0u) {
+        throw std::runtime_error(
+            "hip::HeatmapReducer::HeatmapReducer() : Empty heatmap");
+    }
+
+    source_rows = total_blocks;
+    if (row_kind == Rows::Threads) {
+        source_rows *= threads_per_block;
+    }
+
+    height = static_cast<uint32_t>(std::min<uint64_t>(source_rows, max_rows));
+    width = std::min(bb_count, max_columns);
+
+    column_of.resize(bb_count);
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        column_of[bb] = static_cast<uint64_t>(bb) * width / bb_count;
+    }
+
+    sums.assign(static_cast<size_t>(height) * width, 0u);
+}
+
+void HeatmapReducer::reduce(const TraceChunk& chunk) {
+    if (height == 0u || width == 0u || chunk.workgroups == 0u) {
+        return;
+    }
+
+    // Trace rows of the chunk
+    uint64_t rows_per_workgroup =
+        row_kind == Rows::Threads ? threads_per_block : 1u;
+    uint64_t first = chunk.first_workgroup * rows_per_workgroup;
+    uint64_t end = first + chunk.workgroups * rows_per_workgroup;
+    uint64_t row_size = bb_count * (threads_per_block / rows_per_workgroup);
+
+    auto rowOf = [&](uint64_t source) {
+        return static_cast<uint32_t>(source * height / source_rows);
+    };
+
+    // Row tiles : each task accumulates a slice of the chunk in its own rows,
+    // merged afterwards
+    auto workers = threads ? threads : hardwareThreads();
+    auto tasks = std::min<uint64_t>(end - first, workers * 4u);
+    auto rows_per_task = (end - first + tasks - 1) / tasks;
+
+    struct Partial {
+        uint32_t first_row = 0u;
+        std::vector<uint64_t> sums;
+    };
+    std::vector<Partial> partials(tasks);
+
+    parallelFor(
+        tasks,
+        [&](size_t task) {
+            auto begin = first + task * rows_per_task;
+            auto task_end = std::min(begin + rows_per_task, end);
+            if (begin >= task_end) {
+                return;
+            }
+
+            auto& partial = partials[task];
+            partial.first_row = rowOf(begin);
+            partial.sums.assign(
+                static_cast<size_t>(rowOf(task_end - 1) - partial.first_row +
+                                    1u) *
+                    width,
+                0u);
+
+            for (auto source = begin; source < task_end; ++source) {
+                auto row = &partial.sums[static_cast<size_t>(
+                                             rowOf(source) -
+                                             partial.first_row) *
+                                         width];
+                auto counters = &chunk.counters[(source - first) * row_size];
+
+                // A workgroup row covers all the threads of the workgroup
+                for (auto i = 0u; i < row_size; ++i) {
+                    row[column_of[i % bb_count]] += counters[i];
+                }
+            }
+        },
+        threads);
+
+    for (const auto& partial : partials) {
+        auto offset = static_cast<size_t>(partial.first_row) * width;
+        for (auto i = 0u; i < partial.sums.size(); ++i) {
+            sums[offset + i] += partial.sums[i];
+        }
+    }
+}
+
+double HeatmapReducer::cell(uint32_t row, uint32_t column) const {
+    auto rows = sourceBegin(row + 1, source_rows, height) -
+                sourceBegin(row, source_rows, height);
+    auto blocks = sourceBegin(column + 1, bb_count, width) -
+                  sourceBegin(column, bb_count, width);
+
+    return static_cast<double>(sums[static_cast<size_t>(row) * width +
+                                    column]) /
+           (rows * blocks);
+}
+
+namespace {
+
+/** \fn colormap
+ * \brief Maps a value in [0, 1] to a color, from black to yellow through
+ * purple and orange (inferno-like)
+ */
+std::array<uint8_t, 3> colormap(double value) {
+    constexpr std::array<std::array<double, 3>, 5> stops{{{0., 0., 4.},
+                                                          {87., 16., 110.},
+                                                          {188., 55., 84.},
+                                                          {249., 142., 9.},
+                                                          {252., 255., 164.}}};
+
+    value = std::clamp(value, 0., 1.) * (stops.size() - 1u);
+    auto i = std::min<size_t>(value, stops.size() - 2u);
+    auto t = value - i;
+
+    std::array<uint8_t, 3> ret;
+    for (auto c = 0u; c < 3u; ++c) {
+        ret[c] = static_cast<uint8_t>(
+            std::lround(stops[i][c] + t * (stops[i + 1][c] - stops[i][c])));
+    }
+
+    return ret;
+}
+
+} // namespace
+
+Image HeatmapReducer::image(bool log_scale, uint32_t cell_width,
+                            uint32_t cell_height) const {
+    cell_width = std::max(cell_width, 1u);
+    cell_height = std::max(cell_height, 1u);
+
+    std::vector<double> values(sums.size());
+    for (auto row = 0u; row < height; ++row) {
+        for (auto column = 0u; column < width; ++column) {
+            auto value = cell(row, column);
+            values[static_cast<size_t>(row) * width + column] =
+                log_scale ? std::log1p(value) : value;
+        }
+    }
+
+    auto max = values.empty() ? 0.
+                              : *std::max_element(values.begin(), values.end());
+
+    Image image{width * cell_width, height * cell_height, {}};
+    image.rgb.resize(static_cast<size_t>(image.width) * image.height * 3u);
+
+    for (auto y = 0u; y < image.height; ++y) {
+        auto row = y / cell_height;
+        auto pixel = &image.rgb[static_cast<size_t>(y) * image.width * 3u];
+
+        for (auto x = 0u; x < image.width; ++x, pixel += 3) {
+            auto value = values[static_cast<size_t>(row) * width +
+                                x / cell_width];
+            auto color = colormap(max > 0. ? value / max : 0.);
+            std::copy(color.begin(), color.end(), pixel);
+        }
+    }
+
+    return image;
+}
+
+} // namespace hip
@@ -6,10 +6,20 @@
 
 #include "hip_instrumentation/hip_instrumentation.hpp"
 #include "hip_instrumentation/hip_utils.hpp"
+#include "hip_instrumentation/online_stats.hpp"
+#include "hip_instrumentation/summary_store.hpp"
+#include "hip_instrumentation/timeline.hpp"
+#include "hip_instrumentation/trace_reader.hpp"
 
+#include <algorithm>
+#include <cctype>
 #include <chrono>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
 
 // Jsoncpp (shipped with ubuntu & debian)
@@ -36,7 +46,8 @@ void KernelInfo::dump() const {
               << "\tTotal blocks : " << total_blocks << '\n'
               << "\tTotal threads : " << total_threads_per_blocks << '\n'
               << "\tBasic blocks : " << basic_blocks << '\n'
-              << "\tInstr size : " << instr_size << '\n';
+              << "\tInstr size : " << instr_size << '\n'
+              << "\tWave size : " << wave_size << '\n';
 }
 
 std::string KernelInfo::json() {
@@ -51,7 +62,8 @@ std::string KernelInfo::json() {
     ss << "{ \"name\": \"" << name << "\", \"bblocks\": " << basic_blocks
        << ",\"geometry\": {\"threads\": {\"x\": " << t_x << ", \"y\": " << t_y
        << ", \"z\": " << t_z << "}, \"blocks\": {\"x\": " << b_x
-       << ", \"y\": " << b_y << ", \"z\": " << b_z << "}}}";
+       << ", \"y\": " << b_y << ", \"z\": " << b_z
+       << "}}, \"wave_size\": " << wave_size << "}";
 
     return ss.str();
 }
@@ -77,8 +89,10 @@ KernelInfo KernelInfo::fromJson(const std::string& filename) {
     dim3 threads = dim3FromJson(geometry.get("threads", Json::Value()));
     unsigned int bblocks = root.get("bblocks", 0u).asUInt();
     std::string kernel_name = root.get("name", "").asString();
+    unsigned int wave_size =
+        root.get("wave_size", KernelInfo::default_wave_size).asUInt();
 
-    return {kernel_name, bblocks, blocks, threads};
+    return {kernel_name, bblocks, blocks, threads, wave_size};
 }
 
 Instrumenter::Instrumenter(KernelInfo& ki)
@@ -91,6 +105,18 @@ Instrumenter::Instrumenter(KernelInfo& ki)
                 .count();
 }
 
+Instrumenter::~Instrumenter() {
+    // Can't throw in a destructor, ignore the return values. The runtime
+    // might also have been torn down if the instrumenter is static
+    if (graph_device_counters) {
+        (void)hipFree(graph_device_counters);
+    }
+
+    if (graph_staging) {
+        (void)hipHostFree(graph_staging);
+    }
+}
+
 uint64_t getRoctracerStamp() {
     uint64_t rt_timestamp, ret;
 
@@ -108,7 +134,49 @@ uint64_t getRoctracerStamp() {
     return ret;
 }
 
+SignatureBuffers Instrumenter::toDeviceSignatures() {
+    SignatureBuffers buffers;
+
+    hip::check(hipMalloc(&buffers.counts,
+                         kernel_info.total_blocks * sizeof(uint32_t)));
+    hip::check(hipMalloc(&buffers.indices,
+                         kernel_info.total_blocks *
+                             kernel_info.total_threads_per_blocks *
+                             sizeof(signature_index_t)));
+
+    return buffers;
+}
+
+uint64_t* Instrumenter::toDeviceCoverage() {
+    auto begin = getRoctracerStamp();
+
+    uint64_t* coverage_device;
+    auto size = kernel_info.coverage_size * sizeof(uint64_t);
+
+    hip::check(hipMalloc(&coverage_device, size));
+    hip::check(hipMemset(coverage_device, 0u, size));
+
+    stamp_begin = getRoctracerStamp();
+    traceUpload("toDeviceCoverage", begin);
+
+    return coverage_device;
+}
+
+void Instrumenter::fromDeviceCoverage(const uint64_t* device_ptr) {
+    stamp_end = getRoctracerStamp();
+
+    host_coverage.resize(kernel_info.coverage_size);
+
+    hip::check(hipMemcpy(host_coverage.data(), device_ptr,
+                         host_coverage.size() * sizeof(uint64_t),
+                         hipMemcpyDeviceToHost));
+
+    traceLaunch("fromDeviceCoverage");
+}
+
 Instrumenter::counter_t* Instrumenter::toDevice() {
+    auto begin = getRoctracerStamp();
+
     counter_t* data_device;
     auto size = kernel_info.instr_size * sizeof(counter_t);
 
@@ -124,6 +192,7 @@ Instrumenter::counter_t* Instrumenter::toDevice() {
     // executed right before the kernel launch
 
     stamp_begin = getRoctracerStamp();
+    traceUpload("toDevice", begin);
 
     return data_device;
 }
@@ -137,6 +206,261 @@ void Instrumenter::fromDevice(void* device_ptr) {
     hip::check(hipMemcpy(host_counters.data(), device_ptr,
                          kernel_info.instr_size * sizeof(counter_t),
                          hipMemcpyDeviceToHost));
+
+    dense_up_to_date = true;
+    signature_trace = {};
+
+    traceLaunch("fromDevice");
+    recordLaunch(static_cast<const counter_t*>(device_ptr));
+}
+
+void Instrumenter::traceUpload(const char* name, uint64_t begin) const {
+    if (auto* timeline = TimelineWriter::global()) {
+        auto kernel = TimelineWriter::quoted(kernel_info.name);
+
+        timeline->complete(name, "instrumentation", begin, stamp_begin,
+                           timeline->hostThread(), {{"kernel", kernel}});
+    }
+}
+
+void Instrumenter::traceLaunch(const char* transfer) const {
+    if (auto* timeline = TimelineWriter::global()) {
+        auto end = getRoctracerStamp();
+
+        timeline->async(
+            kernel_info.name, "kernel", stamp_begin, stamp_end,
+            timeline->nextId(),
+            {{"blocks", std::to_string(kernel_info.total_blocks)},
+             {"threads_per_block",
+              std::to_string(kernel_info.total_threads_per_blocks)},
+             {"basic_blocks", std::to_string(kernel_info.basic_blocks)}});
+
+        auto kernel = TimelineWriter::quoted(kernel_info.name);
+
+        timeline->complete(transfer, "instrumentation", stamp_end, end,
+                           timeline->hostThread(), {{"kernel", kernel}});
+    }
+}
+
+void Instrumenter::appendSummary(SummaryWriter& store) const {
+    auto totals = launchTotals(nullptr);
+
+    store.append(summary::kernelId(kernel_info.name), stamp_begin, stamp_end,
+                 totals.data());
+}
+
+std::vector<uint64_t>
+Instrumenter::launchTotals(const counter_t* device_ptr) const {
+    // Reduce on the device if the counters are still there, which requires
+    // the block database
+    if (device_ptr && !blocks.empty()) {
+        auto usage = reduceBlockUsage(device_ptr);
+
+        std::vector<uint64_t> totals(usage.size());
+        std::transform(usage.begin(), usage.end(), totals.begin(),
+                       [](const auto& block) { return block.count; });
+
+        return totals;
+    }
+
+    const auto& counters = data();
+    return cpu::reduceCounts(counters.data(), counters.size(),
+                             kernel_info.basic_blocks);
+}
+
+void Instrumenter::recordLaunch(const counter_t* device_ptr) const {
+    static const char* directory = std::getenv(summary_env_var);
+    auto* stats = StatsRegistry::global();
+
+    if (!directory && !stats) {
+        return;
+    }
+
+    auto totals = launchTotals(device_ptr);
+
+    if (stats) {
+        stats->add(kernel_info.name, totals.data(), totals.size());
+    }
+
+    if (!directory) {
+        return;
+    }
+
+    // One store per kernel, flushed at exit
+    static std::map<std::string, std::unique_ptr<SummaryWriter>> stores;
+    static std::mutex stores_mutex;
+
+    std::scoped_lock lock(stores_mutex);
+
+    auto& store = stores[kernel_info.name];
+    if (!store) {
+        auto filename = kernel_info.name;
+        std::replace_if(
+            filename.begin(), filename.end(),
+            [](char c) { return !std::isalnum(static_cast<unsigned char>(c)); },
+            '_');
+
+        store = std::make_unique<SummaryWriter>(std::string(directory) + '/' +
+                                                    filename + ".hipsum",
+                                                kernel_info.basic_blocks);
+    }
+
+    store->append(summary::kernelId(kernel_info.name), stamp_begin, stamp_end,
+                  totals.data());
+}
+
+const std::vector<Instrumenter::counter_t>& Instrumenter::data() const {
+    if (!dense_up_to_date) {
+        expandSparse();
+    }
+
+    return host_counters;
+}
+
+void Instrumenter::expandSparse() const {
+    expandCounters(sparse_counters, host_counters.data(),
+                   host_counters.size());
+
+    dense_up_to_date = true;
+}
+
+CounterMonitor::live_counter_t*
+Instrumenter::startMonitor(std::chrono::microseconds interval) {
+    if (!monitor) {
+        monitor = std::make_unique<CounterMonitor>(kernel_info.basic_blocks,
+                                                   interval);
+    }
+
+    monitor->start();
+    monitor_begin = getRoctracerStamp();
+
+    return monitor->devicePtr();
+}
+
+void Instrumenter::stopMonitor() {
+    if (monitor) {
+        monitor->stop();
+
+        // The live totals are the only device-side records of the kernel
+        if (auto* timeline = TimelineWriter::global()) {
+            for (const auto& snapshot : monitor->snapshots()) {
+                uint64_t executions = 0u;
+                for (auto total : snapshot.totals) {
+                    executions += total;
+                }
+
+                timeline->counter(kernel_info.name + " executions",
+                                  monitor_begin + snapshot.elapsed * 1000u,
+                                  {{"executions", executions}});
+            }
+        }
+    }
+}
+
+Instrumenter::counter_t* Instrumenter::allocDevice() {
+    if (graph_device_counters) {
+        return graph_device_counters;
+    }
+
+    auto size = kernel_info.instr_size * sizeof(counter_t);
+
+    // Allocations are illegal in the default (global) capture mode, switch to
+    // relaxed mode for this thread and restore it afterwards
+    hipStreamCaptureMode mode = hipStreamCaptureModeRelaxed;
+    hip::check(hipThreadExchangeStreamCaptureMode(&mode));
+
+    hip::check(hipMalloc(&graph_device_counters, size));
+    hip::check(hipHostMalloc(&graph_staging, size, hipHostMallocDefault));
+
+    hip::check(hipThreadExchangeStreamCaptureMode(&mode));
+
+    return graph_device_counters;
+}
+
+void Instrumenter::recordToDevice(hipStream_t stream) {
+    if (!graph_device_counters) {
+        throw std::runtime_error("hip::Instrumenter::recordToDevice() : "
+                                 "Device counters were not allocated");
+    }
+
+    hip::check(hipMemsetAsync(graph_device_counters, 0u,
+                              kernel_info.instr_size * sizeof(counter_t),
+                              stream));
+
+    // Stamp the launch from a host node, so it is the time of the replay and
+    // not of the capture
+    hip::check(hipLaunchHostFunc(
+        stream,
+        [](void* instrumenter) {
+            static_cast<Instrumenter*>(instrumenter)->stamp_begin =
+                getRoctracerStamp();
+        },
+        this));
+}
+
+void Instrumenter::recordFromDevice(hipStream_t stream) {
+    if (!graph_device_counters) {
+        throw std::runtime_error("hip::Instrumenter::recordFromDevice() : "
+                                 "Device counters were not allocated");
+    }
+
+    hip::check(hipMemcpyAsync(graph_staging, graph_device_counters,
+                              kernel_info.instr_size * sizeof(counter_t),
+                              hipMemcpyDeviceToHost, stream));
+
+    // Update the host counters once the copy has completed. Recorded as a
+    // host node when captured, so every replay refreshes the counters
+    hip::check(hipLaunchHostFunc(
+        stream,
+        [](void* instrumenter) {
+            static_cast<Instrumenter*>(instrumenter)->fetchStaging();
+        },
+        this));
+}
+
+void Instrumenter::fetchStaging() {
+    if (!graph_staging) {
+        throw std::runtime_error("hip::Instrumenter::fetchStaging() : "
+                                 "Staging buffer was not allocated");
+    }
+
+    stamp_end = getRoctracerStamp();
+
+    std::copy(graph_staging, graph_staging + kernel_info.instr_size,
+              host_counters.begin());
+
+    dense_up_to_date = true;
+    signature_trace = {};
+
+    traceLaunch("fetchStaging");
+
+    // No HIP calls in a host function : the totals are reduced on the host
+    recordLaunch(nullptr);
+}
+
+Instrumenter& GraphInstrumenters::get(dim3 blocks, dim3 threads) {
+    geometry_t geometry{blocks.x,  blocks.y,  blocks.z,
+                        threads.x, threads.y, threads.z};
+
+    std::scoped_lock lock(mutex);
+
+    auto& instrumenter = instrumenters[geometry];
+    if (!instrumenter) {
+        // The instrumenter copies the kernel info
+        KernelInfo kernel_info(name, basic_blocks, blocks, threads,
+                               hip::waveSize());
+        instrumenter = std::make_unique<Instrumenter>(kernel_info);
+    }
+
+    return *instrumenter;
+}
+
+std::vector<ProgressSnapshot> Instrumenter::snapshots() const {
+    if (!monitor) {
+        return {};
+    }
+
+    return monitor->snapshots();
 }
 
 std::string Instrumenter::autoFilenamePrefix() const {
@@ -157,6 +481,8 @@ void Instrumenter::dumpCsv(const std::string& filename_in) {
         filename = filename_in;
     }
 
+    const auto& counters = data();
+
     std::ofstream out(filename);
     out << csv_header << '\n';
 
@@ -169,7 +495,7 @@ void Instrumenter::dumpCsv(const std::string& filename_in) {
                              thread * kernel_info.basic_blocks + bblock;
 
                 out << block << ',' << thread << ',' << bblock << ','
-                    << static_cast<unsigned int>(host_counters[index]) << '\n';
+                    << static_cast<unsigned int>(counters[index]) << '\n';
             }
         }
     }
@@ -177,10 +503,6 @@ void Instrumenter::dumpCsv(const std::string& filename_in) {
     out.close();
 }
 
-/** \brief Small header to validate the trace type
- */
-constexpr auto hiptrace_name = "hiptrace";
-
 void Instrumenter::dumpBin(const std::string& filename_in) {
     std::string filename;
 
@@ -209,8 +531,138 @@ void Instrumenter::dumpBin(const std::string& filename_in) {
 
     // Write binary dump of counters
 
-    out.write(reinterpret_cast<const char*>(host_counters.data()),
-              host_counters.size() * sizeof(counter_t));
+    const auto& counters = data();
+
+    out.write(reinterpret_cast<const char*>(counters.data()),
+              counters.size() * sizeof(counter_t));
+
+    out.close();
+
+    std::ofstream db(filename + ".json");
+    db << kernel_info.json();
+    db.close();
+}
+
+void Instrumenter::dumpSparseBin(const std::string& filename_in) {
+    std::string filename;
+
+    if (filename_in.empty()) {
+        filename = autoFilenamePrefix() + ".hiptrace";
+    } else {
+        filename = filename_in;
+    }
+
+    std::ofstream out(filename, std::ios::binary);
+
+    if (!out.is_open()) {
+        throw std::runtime_error(
+            "Instrumenter::dumpSparseBin() : Could not open output file " +
+            filename);
+    }
+
+    // The counters were fetched in their dense form, compact them first
+    if (dense_up_to_date) {
+        sparse_counters =
+            compactCounters(host_counters.data(), host_counters.size());
+    }
+
+    // Write header, same as the dense trace with the number of entries
+
+    out << hiptrace_sparse_name << ',' << kernel_info.name << ','
+        << kernel_info.instr_size << ',' << stamp << ',' << stamp_begin << ','
+        << stamp_end << ',' << static_cast<unsigned int>(sizeof(counter_t))
+        << ',' << sparse_counters.size() << '\n';
+
+    // Indices, then values
+
+    out.write(reinterpret_cast<const char*>(sparse_counters.indices.data()),
+              sparse_counters.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(sparse_counters.counts.data()),
+              sparse_counters.size() * sizeof(counter_t));
+
+    out.close();
+
+    std::ofstream db(filename + ".json");
+    db << kernel_info.json();
+    db.close();
+}
+
+void Instrumenter::dumpSignatures(const std::string& filename_in) {
+    std::string filename;
+
+    if (filename_in.empty()) {
+        filename = autoFilenamePrefix() + ".hiptrace";
+    } else {
+        filename = filename_in;
+    }
+
+    std::ofstream out(filename, std::ios::binary);
+
+    if (!out.is_open()) {
+        throw std::runtime_error(
+            "Instrumenter::dumpSignatures() : Could not open output file " +
+            filename);
+    }
+
+    // The counters were not deduplicated on the device, do it now
+    if (signature_trace.offsets.empty()) {
+        const auto& counters = data();
+        signature_trace = deduplicateSignatures(
+            counters.data(), kernel_info.total_blocks,
+            kernel_info.total_threads_per_blocks, kernel_info.basic_blocks);
+    }
+
+    // Write header, same as the dense trace with the number of signatures
+
+    out << hiptrace_signatures_name << ',' << kernel_info.name << ','
+        << kernel_info.instr_size << ',' << stamp << ',' << stamp_begin << ','
+        << stamp_end << ',' << static_cast<unsigned int>(sizeof(counter_t))
+        << ',' << signature_trace.offsets.back() << '\n';
+
+    // Offsets, dictionaries, then per-thread indices
+
+    out.write(reinterpret_cast<const char*>(signature_trace.offsets.data()),
+              signature_trace.offsets.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(signature_trace.dictionary.data()),
+              signature_trace.dictionary.size() * sizeof(counter_t));
+    out.write(reinterpret_cast<const char*>(
+                  signature_trace.thread_signatures.data()),
+              signature_trace.thread_signatures.size() *
+                  sizeof(signature_index_t));
+
+    out.close();
+
+    std::ofstream db(filename + ".json");
+    db << kernel_info.json();
+    db.close();
+}
+
+void Instrumenter::dumpCoverage(const std::string& filename_in) {
+    std::string filename;
+
+    if (filename_in.empty()) {
+        filename = autoFilenamePrefix() + ".hiptrace";
+    } else {
+        filename = filename_in;
+    }
+
+    std::ofstream out(filename, std::ios::binary);
+
+    if (!out.is_open()) {
+        throw std::runtime_error(
+            "Instrumenter::dumpCoverage() : Could not open output file " +
+            filename);
+    }
+
+    // Write header, the "counters" are the 64-bit coverage words
+
+    out << hiptrace_coverage_name << ',' << kernel_info.name << ','
+        << kernel_info.instr_size << ',' << stamp << ',' << stamp_begin << ','
+        << stamp_end << ',' << static_cast<unsigned int>(sizeof(uint64_t))
+        << ',' << host_coverage.size() << '\n';
+
+    out.write(reinterpret_cast<const char*>(host_coverage.data()),
+              host_coverage.size() * sizeof(uint64_t));
 
     out.close();
 
@@ -262,6 +714,7 @@ size_t Instrumenter::loadCsv(const std::string& filename) {
 
         host_counters[line_no] =
             static_cast<counter_t>(std::atol(tokens[3].c_str()));
+        dense_up_to_date = true;
 
         std::cout << static_cast<unsigned int>(host_counters[line_no]) << '\n';
         ++line_no;
@@ -273,44 +726,42 @@ size_t Instrumenter::loadCsv(const std::string& filename) {
     return line_no;
 }
 
-bool Instrumenter::parseHeader(const std::string& header) {
-    std::stringstream ss;
-    ss << header;
-
-    auto get_token = [&]() -> std::string {
-        std::string buf;
-        if (!std::getline(ss, buf, ',')) {
-            throw std::runtime_error("hip::Instrumenter::parseHeader() : Could "
-                                     "not read token from header : " +
-                                     header);
-        }
-
-        return std::move(buf);
-    };
-
-    auto trace_type = get_token();
-    if (trace_type != hiptrace_name) {
+bool Instrumenter::parseHeader(const std::string& header, TraceFormat& format,
+                               size_t& entries) {
+    auto parsed = TraceHeader::parse(header);
+
+    if (parsed.type == hiptrace_name) {
+        format = TraceFormat::Dense;
+    } else if (parsed.type == hiptrace_sparse_name) {
+        format = TraceFormat::Sparse;
+    } else if (parsed.type == hiptrace_signatures_name) {
+        format = TraceFormat::Signatures;
+    } else if (parsed.type == hiptrace_coverage_name) {
+        format = TraceFormat::Coverage;
+    } else {
         return false;
     }
 
-    auto kernel_name =
-        get_token(); // Is a different kernel name a reason to fail?
+    // Is a different kernel name a reason to fail?
 
-    auto instr_size = std::stoul(get_token());
-    if (instr_size != kernel_info.instr_size) {
+    if (parsed.instr_size != kernel_info.instr_size) {
         return false;
         //"hip::Instrumenter::parseHeader() : Incompatible counter number,
         // faulty database?"
     }
 
-    auto stamp_in = std::stoull(get_token());
-    stamp = stamp_in;
+    stamp = parsed.stamp;
+    stamp_begin = parsed.stamp_begin;
+    stamp_end = parsed.stamp_end;
 
-    auto counter_size = std::stoul(get_token());
-    if (counter_size != kernel_info.instr_size) {
+    auto expected_size = format == TraceFormat::Coverage ? sizeof(uint64_t)
+                                                         : sizeof(counter_t);
+    if (parsed.counter_size != expected_size) {
         return false;
     }
 
+    entries = parsed.entries;
+
     return true;
 }
 
@@ -329,18 +780,157 @@ size_t Instrumenter::loadBin(const std::string& filename) {
             "hip::Instrumenter::loadBin() : Could not read header " + filename);
     }
 
-    if (!parseHeader(buffer)) {
+    TraceFormat format;
+    size_t entries;
+    if (!parseHeader(buffer, format, entries)) {
         throw std::runtime_error(
             "hip::Instrumenter::loadBin() : Incompatible header : " + buffer);
     }
 
+    if (format == TraceFormat::Coverage) {
+        if (entries != kernel_info.coverage_size) {
+            throw std::runtime_error("hip::Instrumenter::loadBin() : "
+                                     "Incompatible coverage trace " +
+                                     filename);
+        }
+
+        host_coverage.resize(entries);
+        in.read(reinterpret_cast<char*>(host_coverage.data()),
+                entries * sizeof(uint64_t));
+
+        return in.gcount() / sizeof(uint64_t);
+    } else if (format == TraceFormat::Signatures) {
+        auto& trace = signature_trace;
+        trace.offsets.resize(kernel_info.total_blocks + 1);
+        trace.dictionary.resize(entries * kernel_info.basic_blocks);
+        trace.thread_signatures.resize(kernel_info.total_blocks *
+                                       kernel_info.total_threads_per_blocks);
+
+        in.read(reinterpret_cast<char*>(trace.offsets.data()),
+                trace.offsets.size() * sizeof(uint32_t));
+        in.read(reinterpret_cast<char*>(trace.dictionary.data()),
+                trace.dictionary.size() * sizeof(counter_t));
+        in.read(reinterpret_cast<char*>(trace.thread_signatures.data()),
+                trace.thread_signatures.size() * sizeof(signature_index_t));
+
+        if (!in || trace.offsets.back() != entries) {
+            throw std::runtime_error(
+                "hip::Instrumenter::loadBin() : Truncated signature trace " +
+                filename);
+        }
+
+        // Every offset is then within the dictionary, and the per-block
+        // signature counts can't underflow
+        if (!std::is_sorted(trace.offsets.begin(), trace.offsets.end())) {
+            throw std::runtime_error(
+                "hip::Instrumenter::loadBin() : Corrupted signature offsets " +
+                filename);
+        }
+
+        expandSignatures(trace, kernel_info.total_threads_per_blocks,
+                         kernel_info.basic_blocks, host_counters.data());
+        dense_up_to_date = true;
+
+        return entries;
+    } else if (format == TraceFormat::Sparse) {
+        // Sparse trace, the dense counters are expanded when needed
+        sparse_counters.indices.resize(entries);
+        sparse_counters.counts.resize(entries);
+
+        in.read(reinterpret_cast<char*>(sparse_counters.indices.data()),
+                entries * sizeof(uint32_t));
+        in.read(reinterpret_cast<char*>(sparse_counters.counts.data()),
+                entries * sizeof(counter_t));
+
+        if (!in) {
+            throw std::runtime_error(
+                "hip::Instrumenter::loadBin() : Truncated sparse trace " +
+                filename);
+        }
+
+        dense_up_to_date = false;
+        signature_trace = {};
+
+        return entries;
+    }
+
     // Ugly cast, but works
     in.read(reinterpret_cast<char*>(host_counters.data()),
             host_counters.size() * sizeof(counter_t));
 
+    dense_up_to_date = true;
+    signature_trace = {};
+
     return in.gcount();
 }
 
+std::vector<BlockUsage> Instrumenter::reduceBlockUsage() const {
+    const auto& counters = data();
+
+    if (!hip::hasDevice()) {
+        if (blocks.empty()) {
+            throw std::runtime_error("hip::Instrumenter::reduceBlockUsage() : "
+                                     "Empty block database");
+        }
+
+        return cpu::reduceBlockUsage(counters.data(), counters.size(),
+                                     BasicBlock::normalized(blocks),
+                                     kernel_info.basic_blocks);
+    }
+
+    counter_t* device_ptr;
+    hip::check(hipMalloc(&device_ptr, counters.size() * sizeof(counter_t)));
+    hip::check(hipMemcpy(device_ptr, counters.data(),
+                         counters.size() * sizeof(counter_t),
+                         hipMemcpyHostToDevice));
+
+    std::vector<BlockUsage> usage;
+    try {
+        usage = reduceBlockUsage(device_ptr);
+    } catch (...) {
+        (void)hipFree(device_ptr);
+        throw;
+    }
+
+    hip::check(hipFree(device_ptr));
+
+    return usage;
+}
+
+const DeviceBlockInfo* Instrumenter::deviceBlocksInfo() const {
+    if (block_table.empty()) {
+        // The block database has to be loaded prior to reduction!
+        throw std::runtime_error(
+            "hip::Instrumenter::deviceBlocksInfo() : Empty block database");
+    }
+
+    // One immutable entry per device and distinct table, shared by all the
+    // instrumenters and never released (the device memory is reclaimed along
+    // with the context) : a table can't change under an in-flight reduction
+    static std::map<std::pair<int, std::string>, const DeviceBlockInfo*> cache;
+    static std::mutex cache_mutex;
+
+    int device;
+    hip::check(hipGetDevice(&device));
+
+    auto table_size = block_table.size() * sizeof(DeviceBlockInfo);
+    std::string key(reinterpret_cast<const char*>(block_table.data()),
+                    table_size);
+
+    std::scoped_lock lock(cache_mutex);
+    auto& entry = cache[{device, std::move(key)}];
+
+    if (!entry) {
+        DeviceBlockInfo* table;
+        hip::check(hipMalloc(&table, table_size));
+        hip::check(hipMemcpy(table, block_table.data(), table_size,
+                             hipMemcpyHostToDevice));
+        entry = table;
+    }
+
+    return entry;
+}
+
 const std::vector<hip::BasicBlock>&
 Instrumenter::loadDatabase(const std::string& filename_in) {
     std::string filename;
@@ -352,6 +942,7 @@ Instrumenter::loadDatabase(const std::string& filename_in) {
     }
 
     blocks = BasicBlock::fromJsonArray(filename);
+    block_table = DeviceBlockInfo::table(blocks, kernel_info.basic_blocks);
 
     return blocks;
 }
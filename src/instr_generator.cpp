@@ -51,6 +51,16 @@ void InstrGenerator::setGeometry(const clang::CallExpr& kernel_call,
 
     threads = getExprText(threads_expr, source_manager);
     llvm::errs() << threads << '\n';
+
+    // The stream is the fourth launch parameter, which might be omitted
+    stream = "nullptr";
+    if (kernel_call.getNumArgs() > 3) {
+        auto stream_expr = kernel_call.getArg(3);
+        if (!llvm::isa<clang::CXXDefaultArgExpr>(stream_expr)) {
+            stream = getExprText(stream_expr, source_manager);
+            llvm::errs() << stream << '\n';
+        }
+    }
 }
 
 std::string InstrGenerator::generateBlockCode(unsigned int id) const {
@@ -108,8 +118,10 @@ std::string InstrGenerator::generateInstrumentationInit() const {
 
     ss << "/* Instrumentation variables, hipMalloc, etc. */\n\n";
 
+    // The wavefront analyses of the trace need the real wavefront size
     ss << "hip::KernelInfo _" << kernel_name << "_info(\"" << kernel_name
-       << "\", " << bb_count << ", " << blocks << ", " << threads << ");\n";
+       << "\", " << bb_count << ", " << blocks << ", " << threads
+       << ", hip::waveSize());\n";
 
     ss << "hip::Instrumenter _" << kernel_name << "_instr(_" << kernel_name
        << "_info);\n";
@@ -135,8 +147,9 @@ std::string InstrGenerator::generateInstrumentationFinalize() const {
     ss << "\n\n/* Finalize instrumentation : copy back data */\n";
 
     ss << "hip::check(hipDeviceSynchronize());\n"
-       << "_" << kernel_name << "_instr.fromDevice(_" << kernel_name
-       << "_ptr);\n";
+       << "_" << kernel_name << "_instr."
+       << (sparse_readback ? "fromDeviceSparse" : "fromDevice") << "(_"
+       << kernel_name << "_ptr);\n";
 
     return ss.str();
 }
@@ -147,4 +160,318 @@ std::string MultipleExecutionInstrGenerator::generatePostKernel() const {
     return "";
 }
 
+// ----- LiveInstrGenerator ----- //
+
+LiveInstrGenerator::LiveInstrGenerator(unsigned int period,
+                                       unsigned int interval_us)
+    : flush_period(period), sampling_interval(interval_us) {
+    // The counters are 8-bit wide : the flush condition relies on the
+    // wrap-around, so the period has to divide 256
+    if (period == 0u || period > 256u || (period & (period - 1u)) != 0u) {
+        throw std::runtime_error("LiveInstrGenerator : flush period has to be "
+                                 "a power of two, at most 256");
+    }
+}
+
+std::string LiveInstrGenerator::generateBlockCode(unsigned int id) const {
+    std::stringstream ss;
+    ss << InstrGenerator::generateBlockCode(id);
+
+    // Flush every flush_period executions. System-scope atomics are required
+    // for the host to observe the update while the kernel is running
+    ss << "if ((_bb_counters[" << bb_count << "][threadIdx.x] & "
+       << flush_period - 1u << "u) == 0u) { atomicAdd_system(&_live_ptr["
+       << bb_count << "], " << flush_period << "ull); }\n";
+
+    return ss.str();
+}
+
+std::string LiveInstrGenerator::generateInstrumentationParms() const {
+    std::stringstream ss;
+    ss << InstrGenerator::generateInstrumentationParms()
+       << ", unsigned long long* _live_ptr";
+
+    return ss.str();
+}
+
+std::string LiveInstrGenerator::generateInstrumentationCommit() const {
+    std::stringstream ss;
+
+    // Flush the executions since the last periodic flush, so the final totals
+    // are exact
+    ss << "/* Finalize live instrumentation : flush the remainders */\n";
+
+    ss << "    for (auto i = 0u; i < _bb_count; ++i) {\n"
+          "        unsigned long long _remainder =\n"
+          "            _bb_counters[i][threadIdx.x] & "
+       << flush_period - 1u
+       << "u;\n"
+          "        if (_remainder != 0u) { "
+          "atomicAdd_system(&_live_ptr[i], _remainder); }\n"
+          "    }\n";
+
+    ss << InstrGenerator::generateInstrumentationCommit();
+
+    return ss.str();
+}
+
+std::string LiveInstrGenerator::generateInstrumentationInit() const {
+    std::stringstream ss;
+    ss << InstrGenerator::generateInstrumentationInit();
+
+    ss << "auto _" << kernel_name << "_live_ptr = _" << kernel_name
+       << "_instr.startMonitor(std::chrono::microseconds("
+       << sampling_interval << "));\n\n";
+
+    return ss.str();
+}
+
+std::string LiveInstrGenerator::generateInstrumentationLaunchParms() const {
+    std::stringstream ss;
+    ss << InstrGenerator::generateInstrumentationLaunchParms() << ", _"
+       << kernel_name << "_live_ptr";
+
+    return ss.str();
+}
+
+std::string LiveInstrGenerator::generateInstrumentationFinalize() const {
+    std::stringstream ss;
+    ss << InstrGenerator::generateInstrumentationFinalize();
+
+    ss << "_" << kernel_name << "_instr.stopMonitor();\n";
+
+    return ss.str();
+}
+
+// ----- SignatureInstrGenerator ----- //
+
+std::string SignatureInstrGenerator::generateInstrumentationParms() const {
+    std::stringstream ss;
+    ss << InstrGenerator::generateInstrumentationParms()
+       << ", uint32_t* _sig_counts, uint16_t* _sig_indices";
+
+    return ss.str();
+}
+
+std::string SignatureInstrGenerator::generateInstrumentationCommit() const {
+    std::stringstream ss;
+
+    ss << "/* Finalize instrumentation : deduplicate signatures */\n";
+
+    // Hash of the counter vector, see hip::hashCounters
+
+    ss << "    __shared__ uint32_t _sig_hash[64];\n"
+          "    __shared__ uint8_t _sig_unique[64];\n"
+          "    __shared__ uint16_t _sig_slot[64];\n"
+          "    uint32_t _hash = 2166136261u;\n"
+          "    for (auto i = 0u; i < _bb_count; ++i) {\n"
+          "        _hash = (_hash ^ _bb_counters[i][threadIdx.x]) * "
+          "16777619u;\n"
+          "    }\n"
+          "    _sig_hash[threadIdx.x] = _hash;\n"
+          "    __syncthreads();\n";
+
+    // The representative of a signature is the first thread holding it
+
+    ss << "    unsigned int _owner = threadIdx.x;\n"
+          "    for (auto t = 0u; t < threadIdx.x && _owner == threadIdx.x; "
+          "++t) {\n"
+          "        if (_sig_hash[t] == _hash) {\n"
+          "            bool _same = true;\n"
+          "            for (auto i = 0u; i < _bb_count && _same; ++i) {\n"
+          "                _same = _bb_counters[i][t] == "
+          "_bb_counters[i][threadIdx.x];\n"
+          "            }\n"
+          "            if (_same) { _owner = t; }\n"
+          "        }\n"
+          "    }\n"
+          "    _sig_unique[threadIdx.x] = _owner == threadIdx.x;\n"
+          "    __syncthreads();\n";
+
+    // Representatives write their signature in the dictionary, in order of
+    // first occurrence
+
+    ss << "    if (_owner == threadIdx.x) {\n"
+          "        uint16_t _slot = 0u;\n"
+          "        for (auto t = 0u; t < threadIdx.x; ++t) { _slot += "
+          "_sig_unique[t]; }\n"
+          "        _sig_slot[threadIdx.x] = _slot;\n"
+          "        for (auto i = 0u; i < _bb_count; ++i) {\n"
+          "            _instr_ptr[(blockIdx.x * blockDim.x + _slot) * "
+          "_bb_count + i] = _bb_counters[i][threadIdx.x];\n"
+          "        }\n"
+          "    }\n"
+          "    __syncthreads();\n"
+          "    _sig_indices[blockIdx.x * blockDim.x + threadIdx.x] = "
+          "_sig_slot[_owner];\n"
+          "    if (threadIdx.x == 0) {\n"
+          "        uint32_t _unique = 0u;\n"
+          "        for (auto t = 0u; t < blockDim.x; ++t) { _unique += "
+          "_sig_unique[t]; }\n"
+          "        _sig_counts[blockIdx.x] = _unique;\n"
+          "    }\n";
+
+    return ss.str();
+}
+
+std::string SignatureInstrGenerator::generateInstrumentationInit() const {
+    std::stringstream ss;
+    ss << InstrGenerator::generateInstrumentationInit();
+
+    ss << "auto _" << kernel_name << "_sig = _" << kernel_name
+       << "_instr.toDeviceSignatures();\n\n";
+
+    return ss.str();
+}
+
+std::string
+SignatureInstrGenerator::generateInstrumentationLaunchParms() const {
+    std::stringstream ss;
+    ss << InstrGenerator::generateInstrumentationLaunchParms() << ", _"
+       << kernel_name << "_sig.counts, _" << kernel_name << "_sig.indices";
+
+    return ss.str();
+}
+
+std::string SignatureInstrGenerator::generateInstrumentationFinalize() const {
+    std::stringstream ss;
+
+    ss << "\n\n/* Finalize instrumentation : copy back signatures */\n";
+
+    ss << "hip::check(hipDeviceSynchronize());\n"
+       << "_" << kernel_name << "_instr.fromDeviceSignatures(_" << kernel_name
+       << "_ptr, _" << kernel_name << "_sig);\n";
+
+    return ss.str();
+}
+
+// ----- CoverageInstrGenerator ----- //
+
+std::string CoverageInstrGenerator::generateBlockCode(unsigned int id) const {
+    std::stringstream ss;
+    ss << "/* BB " << id << " (" << bb_count << ") */" << '\n';
+
+    // The first active lane commits the mask for the whole wavefront
+    ss << "{ auto _mask = __ballot(1); if (__lane_id() == __ffsll("
+          "static_cast<unsigned long long>(_mask)) - 1) { _bb_coverage["
+       << bb_count << "][threadIdx.x / warpSize] |= _mask; } }\n";
+
+    return ss.str();
+}
+
+std::string CoverageInstrGenerator::generateInstrumentationParms() const {
+    return ",/* Extra params */ uint64_t* _cov_ptr";
+}
+
+std::string CoverageInstrGenerator::generateInstrumentationLocals() const {
+    std::stringstream ss;
+
+    ss << "\n/* Instrumentation locals */\n";
+
+    ss << "__shared__ uint64_t _bb_coverage[" << bb_count << "][" << max_waves
+       << "];\n"
+       << "unsigned int _bb_count = " << bb_count << ";\n"
+       << "unsigned int _waves = (blockDim.x + warpSize - 1) / warpSize;\n"
+       << "for(auto i = threadIdx.x; i < _bb_count * _waves; i += blockDim.x) "
+          "{ _bb_coverage[i / _waves][i % _waves] = 0; }\n"
+       << "__syncthreads();\n";
+
+    return ss.str();
+}
+
+std::string CoverageInstrGenerator::generateInstrumentationCommit() const {
+    std::stringstream ss;
+
+    ss << "/* Finalize instrumentation */\n";
+
+    // Layout : [block][wave][basic block]
+
+    ss << "    __syncthreads();\n"
+          "    for (auto i = threadIdx.x; i < _bb_count * _waves; i += "
+          "blockDim.x) {\n"
+          "        auto _wave = i / _bb_count, _bb = i % _bb_count;\n"
+          "        _cov_ptr[(blockIdx.x * _waves + _wave) * _bb_count + _bb] = "
+          "_bb_coverage[_bb][_wave];\n"
+          "    }\n";
+
+    return ss.str();
+}
+
+std::string CoverageInstrGenerator::generateInstrumentationInit() const {
+    std::stringstream ss;
+
+    ss << "/* Instrumentation variables, hipMalloc, etc. */\n\n";
+
+    // The layout of the masks depends on the wavefront size of the device
+    ss << "hip::KernelInfo _" << kernel_name << "_info(\"" << kernel_name
+       << "\", " << bb_count << ", " << blocks << ", " << threads
+       << ", hip::waveSize());\n";
+
+    ss << "hip::Instrumenter _" << kernel_name << "_instr(_" << kernel_name
+       << "_info);\n";
+
+    ss << "auto _" << kernel_name << "_ptr = _" << kernel_name
+       << "_instr.toDeviceCoverage();\n\n";
+
+    return ss.str();
+}
+
+std::string
+CoverageInstrGenerator::generateInstrumentationLaunchParms() const {
+    std::stringstream ss;
+
+    ss << ",/* Extra parameters for kernel launch ( " << bb_count << " )*/ _"
+       << kernel_name << "_ptr";
+
+    return ss.str();
+}
+
+std::string CoverageInstrGenerator::generateInstrumentationFinalize() const {
+    std::stringstream ss;
+
+    ss << "\n\n/* Finalize instrumentation : copy back data */\n";
+
+    ss << "hip::check(hipDeviceSynchronize());\n"
+       << "_" << kernel_name << "_instr.fromDeviceCoverage(_" << kernel_name
+       << "_ptr);\n";
+
+    return ss.str();
+}
+
+// ----- GraphInstrGenerator ----- //
+
+std::string GraphInstrGenerator::generateInstrumentationInit() const {
+    std::stringstream ss;
+
+    ss << "/* Instrumentation variables, graph-safe */\n\n";
+
+    // Static : the buffers have to outlive the captured graph. One
+    // instrumenter per launch geometry, as the buffers are sized once
+
+    ss << "static hip::GraphInstrumenters _" << kernel_name << "_graph(\""
+       << kernel_name << "\", " << bb_count << ");\n";
+
+    ss << "auto& _" << kernel_name << "_instr = _" << kernel_name
+       << "_graph.get(" << blocks << ", " << threads << ");\n";
+
+    ss << "auto _" << kernel_name << "_ptr = _" << kernel_name
+       << "_instr.allocDevice();\n";
+
+    ss << "_" << kernel_name << "_instr.recordToDevice(" << stream
+       << ");\n\n";
+
+    return ss.str();
+}
+
+std::string GraphInstrGenerator::generateInstrumentationFinalize() const {
+    std::stringstream ss;
+
+    ss << "\n\n/* Finalize instrumentation : record the copy back */\n";
+
+    ss << "_" << kernel_name << "_instr.recordFromDevice(" << stream
+       << ");\n";
+
+    return ss.str();
+}
+
 }; // namespace hip
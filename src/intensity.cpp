@@ -0,0 +1,44 @@
+/** \file intensity.cpp
+ * \brief Arithmetic intensity of a kernel from its dynamic basic block counts
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/intensity.hpp"
+#include "hip_instrumentation/cpu_reductions.hpp"
+
+namespace hip {
+
+ArithmeticIntensity arithmeticIntensity(const std::vector<uint64_t>& counts,
+                                        const std::vector<BasicBlock>& blocks) {
+    auto bb_count = static_cast<uint32_t>(counts.size());
+    auto table = DeviceBlockInfo::table(blocks, bb_count);
+
+    ArithmeticIntensity ai;
+    ai.blocks.resize(bb_count);
+
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        auto& block = ai.blocks[bb];
+        block.count = counts[bb];
+        block.flops = counts[bb] * table[bb].flops;
+        block.bytes =
+            counts[bb] * (static_cast<uint64_t>(table[bb].floating_ld) +
+                          table[bb].floating_st);
+
+        ai.total.count += block.count;
+        ai.total.flops += block.flops;
+        ai.total.bytes += block.bytes;
+    }
+
+    return ai;
+}
+
+ArithmeticIntensity arithmeticIntensity(const uint8_t* counters, size_t size,
+                                        const std::vector<BasicBlock>& blocks,
+                                        uint32_t bb_count,
+                                        unsigned int threads) {
+    return arithmeticIntensity(
+        cpu::reduceCounts(counters, size, bb_count, threads), blocks);
+}
+
+} // namespace hip
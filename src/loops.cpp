@@ -0,0 +1,461 @@
+/** \file loops.cpp
+ * \brief Loop detection in the instrumented CFG and per-thread trip count
+ * distributions
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/loops.hpp"
+#include "hip_instrumentation/parallel.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+
+namespace hip {
+
+uint32_t LoopTrips::maxTrips() const {
+    for (auto trips = histogram.size(); trips > 0u; --trips) {
+        if (histogram[trips - 1]) {
+            return trips - 1;
+        }
+    }
+
+    return 0u;
+}
+
+void LoopTrips::merge(const LoopTrips& other) {
+    for (auto i = 0u; i < histogram.size(); ++i) {
+        histogram[i] += other.histogram[i];
+    }
+
+    threads += other.threads;
+    iterations += other.iterations;
+    waves += other.waves;
+    imbalanced_waves += other.imbalanced_waves;
+    issued += other.issued;
+    lane_slots += other.lane_slots;
+}
+
+std::vector<size_t> LoopReport::worstLoops(size_t n) const {
+    std::vector<size_t> ids(trips.size());
+    std::iota(ids.begin(), ids.end(), 0u);
+
+    n = std::min(n, ids.size());
+    std::partial_sort(ids.begin(), ids.begin() + n, ids.end(),
+                      [&](auto lhs, auto rhs) {
+                          return trips[lhs].wastedSlots() >
+                                 trips[rhs].wastedSlots();
+                      });
+
+    ids.resize(n);
+    return ids;
+}
+
+// ----- Loop detection ----- //
+
+namespace {
+
+constexpr auto undefined = std::numeric_limits<uint32_t>::max();
+
+/** \fn predecessors
+ * \brief Reverses the successor lists. Successors out of range are ignored
+ */
+std::vector<std::vector<uint32_t>>
+predecessors(const std::vector<BasicBlock>& blocks) {
+    std::vector<std::vector<uint32_t>> preds(blocks.size());
+
+    for (auto bb = 0u; bb < blocks.size(); ++bb) {
+        for (auto succ : blocks[bb].successors) {
+            if (succ < blocks.size()) {
+                preds[succ].emplace_back(bb);
+            }
+        }
+    }
+
+    return preds;
+}
+
+/** \fn immediateDominators
+ * \brief Immediate dominator of every block (Cooper, Harvey & Kennedy), from a
+ * virtual root linked to the entry points of the CFG. Unreachable blocks are
+ * left undefined, the entry points are their own dominator
+ */
+std::vector<uint32_t>
+immediateDominators(const std::vector<BasicBlock>& blocks,
+                    const std::vector<std::vector<uint32_t>>& preds) {
+    auto n = static_cast<uint32_t>(blocks.size());
+    auto root = n;
+
+    std::vector<uint32_t> roots;
+    for (auto bb = 0u; bb < n; ++bb) {
+        if (preds[bb].empty()) {
+            roots.emplace_back(bb);
+        }
+    }
+
+    if (roots.empty() && n > 0u) {
+        roots.emplace_back(0u);
+    }
+
+    auto successors = [&](uint32_t bb) -> const std::vector<uint32_t>& {
+        return bb == root ? roots : blocks[bb].successors;
+    };
+
+    // Reverse post-order, iterative depth-first search
+    std::vector<uint32_t> post_order;
+    std::vector<uint32_t> order(n + 1, undefined);
+    std::vector<bool> visited(n + 1, false);
+    std::vector<std::pair<uint32_t, size_t>> stack{{root, 0u}};
+    visited[root] = true;
+
+    while (!stack.empty()) {
+        auto& [bb, next] = stack.back();
+        const auto& succs = successors(bb);
+
+        if (next < succs.size()) {
+            auto succ = succs[next++];
+            if (succ < n && !visited[succ]) {
+                visited[succ] = true;
+                stack.emplace_back(succ, 0u);
+            }
+        } else {
+            order[bb] = post_order.size();
+            post_order.emplace_back(bb);
+            stack.pop_back();
+        }
+    }
+
+    std::vector<uint32_t> idom(n + 1, undefined);
+    idom[root] = root;
+
+    auto intersect = [&](uint32_t lhs, uint32_t rhs) {
+        while (lhs != rhs) {
+            while (order[lhs] < order[rhs]) {
+                lhs = idom[lhs];
+            }
+            while (order[rhs] < order[lhs]) {
+                rhs = idom[rhs];
+            }
+        }
+        return lhs;
+    };
+
+    auto block_preds = [&](uint32_t bb) {
+        auto ret = preds[bb];
+        if (std::find(roots.begin(), roots.end(), bb) != roots.end()) {
+            ret.emplace_back(root);
+        }
+        return ret;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (auto it = post_order.rbegin(); it != post_order.rend(); ++it) {
+            auto bb = *it;
+            if (bb == root) {
+                continue;
+            }
+
+            auto new_idom = undefined;
+            for (auto pred : block_preds(bb)) {
+                if (idom[pred] == undefined) {
+                    continue;
+                }
+                new_idom =
+                    new_idom == undefined ? pred : intersect(pred, new_idom);
+            }
+
+            if (idom[bb] != new_idom) {
+                idom[bb] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    // Hide the virtual root
+    idom.pop_back();
+    for (auto bb = 0u; bb < n; ++bb) {
+        if (idom[bb] == root) {
+            idom[bb] = bb;
+        }
+    }
+
+    return idom;
+}
+
+bool dominates(const std::vector<uint32_t>& idom, uint32_t dominator,
+               uint32_t bb) {
+    if (idom[bb] == undefined) {
+        return false;
+    }
+
+    while (bb != dominator) {
+        if (idom[bb] == bb) {
+            return false;
+        }
+        bb = idom[bb];
+    }
+
+    return true;
+}
+
+} // namespace
+
+std::vector<Loop> findLoops(const std::vector<BasicBlock>& blocks) {
+    auto preds = predecessors(blocks);
+    auto idom = immediateDominators(blocks, preds);
+
+    // Back edges, grouped by header
+    std::map<uint32_t, std::vector<uint32_t>> latches;
+    for (auto bb = 0u; bb < blocks.size(); ++bb) {
+        for (auto succ : blocks[bb].successors) {
+            if (succ < blocks.size() && dominates(idom, succ, bb)) {
+                latches[succ].emplace_back(bb);
+            }
+        }
+    }
+
+    std::vector<Loop> loops;
+    for (auto& [header, header_latches] : latches) {
+        Loop loop{header, {header}, std::move(header_latches), {}, 0u};
+
+        // Natural loop : blocks reaching a latch without going through the
+        // header
+        std::vector<bool> in_loop(blocks.size(), false);
+        in_loop[header] = true;
+
+        std::vector<uint32_t> stack;
+        for (auto latch : loop.latches) {
+            if (!in_loop[latch]) {
+                in_loop[latch] = true;
+                stack.emplace_back(latch);
+            }
+        }
+
+        while (!stack.empty()) {
+            auto bb = stack.back();
+            stack.pop_back();
+            loop.body.emplace_back(bb);
+
+            for (auto pred : preds[bb]) {
+                if (!in_loop[pred]) {
+                    in_loop[pred] = true;
+                    stack.emplace_back(pred);
+                }
+            }
+        }
+
+        std::sort(loop.body.begin(), loop.body.end());
+
+        loop.unconditional_latches =
+            std::all_of(loop.latches.begin(), loop.latches.end(),
+                        [&](auto latch) {
+                            return blocks[latch].successors.size() == 1u;
+                        });
+
+        for (auto pred : preds[header]) {
+            if (!in_loop[pred]) {
+                loop.entries.emplace_back(pred);
+            }
+        }
+
+        loops.emplace_back(std::move(loop));
+    }
+
+    // Nesting depth : number of loops containing the header
+    for (auto& loop : loops) {
+        for (const auto& other : loops) {
+            loop.depth += std::binary_search(other.body.begin(),
+                                             other.body.end(), loop.header);
+        }
+    }
+
+    return loops;
+}
+
+// ----- Trip counts ----- //
+
+namespace {
+
+/** \struct LoopPartial
+ * \brief Accumulators of a task
+ */
+struct LoopPartial {
+    std::vector<LoopTrips> trips;
+    std::vector<WaveImbalance> waves;
+};
+
+bool worseWave(const WaveImbalance& lhs, const WaveImbalance& rhs) {
+    if (lhs.wastedSlots() != rhs.wastedSlots()) {
+        return lhs.wastedSlots() > rhs.wastedSlots();
+    }
+
+    // Total order, so that the kept waves do not depend on the scheduling
+    return std::tie(lhs.loop, lhs.workgroup, lhs.wave) <
+           std::tie(rhs.loop, rhs.workgroup, rhs.wave);
+}
+
+/** \fn keepWorst
+ * \brief Keeps the n worst wavefronts of waves, in order
+ */
+void keepWorst(std::vector<WaveImbalance>& waves, size_t n) {
+    n = std::min(n, waves.size());
+    std::partial_sort(waves.begin(), waves.begin() + n, waves.end(),
+                      worseWave);
+    waves.resize(n);
+}
+
+/** \fn threadTrips
+ * \brief Trip count of a thread, or undefined if it did not enter the loop
+ */
+uint32_t threadTrips(const uint8_t* counters, const Loop& loop) {
+    uint32_t header = counters[loop.header];
+    uint32_t entered = 0u;
+
+    if (loop.unconditional_latches) {
+        // Every other execution of the header comes from outside of the loop.
+        // Computed on 8 bits, as the counters themselves may have wrapped
+        uint8_t back_edges = 0u;
+        for (auto latch : loop.latches) {
+            back_edges += counters[latch];
+        }
+
+        entered = static_cast<uint8_t>(counters[loop.header] - back_edges);
+    } else if (loop.entries.empty()) {
+        // The header is an entry point of the kernel, entered once
+        entered = header != 0u;
+    } else {
+        for (auto entry : loop.entries) {
+            entered += counters[entry];
+        }
+    }
+
+    if (entered == 0u) {
+        return undefined;
+    }
+
+    return (header + entered / 2u) / entered;
+}
+
+} // namespace
+
+LoopReport analyzeLoops(const uint8_t* counters, uint32_t total_blocks,
+                        uint32_t threads_per_block, uint32_t bb_count,
+                        const std::vector<BasicBlock>& blocks,
+                        uint32_t wave_size, size_t kept_waves,
+                        unsigned int threads) {
+    if (wave_size == 0u) {
+        throw std::runtime_error(
+            "hip::analyzeLoops() : Invalid wavefront size");
+    }
+
+    if (blocks.size() > bb_count) {
+        throw std::runtime_error("hip::analyzeLoops() : More blocks in the "
+                                 "database than in the trace");
+    }
+
+    LoopReport report;
+    report.loops = findLoops(blocks);
+    report.trips.resize(report.loops.size());
+
+    if (total_blocks == 0u || report.loops.empty()) {
+        return report;
+    }
+
+    auto waves_per_block = (threads_per_block + wave_size - 1) / wave_size;
+
+    parallelReduce(
+        total_blocks,
+        [&]() {
+            LoopPartial partial;
+            partial.trips.resize(report.loops.size());
+            return partial;
+        },
+        [&](LoopPartial& partial, size_t begin, size_t end) {
+            for (auto workgroup = begin; workgroup < end; ++workgroup) {
+                for (auto w = 0u; w < waves_per_block; ++w) {
+                    auto first_thread = w * wave_size;
+                    auto lanes =
+                        std::min(wave_size, threads_per_block - first_thread);
+
+                    auto wave_counters =
+                        &counters[(workgroup * threads_per_block +
+                                   first_thread) *
+                                  bb_count];
+
+                    for (auto l = 0u; l < report.loops.size(); ++l) {
+                        const auto& loop = report.loops[l];
+                        auto& trips = partial.trips[l];
+
+                        auto min = undefined;
+                        uint32_t max = 0u;
+                        uint64_t sum = 0u;
+
+                        for (auto lane = 0u; lane < lanes; ++lane) {
+                            auto trip = threadTrips(
+                                &wave_counters[lane * bb_count], loop);
+                            if (trip == undefined) {
+                                continue;
+                            }
+
+                            ++trips.threads;
+                            ++trips.histogram[std::min(trip, 255u)];
+                            trips.iterations += trip;
+
+                            min = std::min(min, trip);
+                            max = std::max(max, trip);
+                            sum += trip;
+                        }
+
+                        if (min == undefined) {
+                            continue;
+                        }
+
+                        ++trips.waves;
+                        trips.issued += max;
+                        trips.lane_slots += static_cast<uint64_t>(max) * lanes;
+
+                        WaveImbalance wave{
+                            l,   static_cast<uint32_t>(workgroup), w, min,
+                            max, lanes,                            sum};
+
+                        if (min != max) {
+                            ++trips.imbalanced_waves;
+                        }
+
+                        if (wave.wastedSlots() > 0u) {
+                            partial.waves.emplace_back(wave);
+                        }
+                    }
+                }
+
+                if (partial.waves.size() > 2u * kept_waves) {
+                    keepWorst(partial.waves, kept_waves);
+                }
+            }
+
+            keepWorst(partial.waves, kept_waves);
+        },
+        [&](const LoopPartial& partial) {
+            for (auto l = 0u; l < partial.trips.size(); ++l) {
+                report.trips[l].merge(partial.trips[l]);
+            }
+
+            report.worst_waves.insert(report.worst_waves.end(),
+                                      partial.waves.begin(),
+                                      partial.waves.end());
+        },
+        threads);
+
+    keepWorst(report.worst_waves, kept_waves);
+
+    return report;
+}
+
+} // namespace hip
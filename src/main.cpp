@@ -17,9 +17,12 @@
 
 #include "actions_processor.h"
 #include "callbacks.h"
+#include "instr_generator.h"
 #include "llvm_ir_consumer.h"
 #include "matchers.h"
 
+#include <stdexcept>
+
 // ----- Statics ----- //
 
 #ifdef ROCM_PATH
@@ -46,6 +49,44 @@ static llvm::cl::opt<std::string>
                   llvm::cl::value_desc("database"),
                   llvm::cl::init(hip::default_database));
 
+enum class InstrumentationMode {
+    counters,
+    live,
+    signatures,
+    coverage,
+    graph
+};
+
+static llvm::cl::opt<InstrumentationMode> instrumentation_mode(
+    "mode", llvm::cl::desc("Instrumentation mode"),
+    llvm::cl::values(
+        clEnumValN(InstrumentationMode::counters, "counters",
+                   "Per-thread basic block counters (default)"),
+        clEnumValN(InstrumentationMode::live, "live",
+                   "Counters, with live sampling of per-block totals"),
+        clEnumValN(InstrumentationMode::signatures, "signatures",
+                   "Counters deduplicated per workgroup on the device"),
+        clEnumValN(InstrumentationMode::coverage, "coverage",
+                   "One bit per thread and basic block (executed or not)"),
+        clEnumValN(InstrumentationMode::graph, "graph",
+                   "Counters, compatible with stream capture (hipGraph)")),
+    llvm::cl::init(InstrumentationMode::counters));
+
+static llvm::cl::opt<unsigned int> live_period(
+    "live-period",
+    llvm::cl::desc("Live mode : basic block executions between two flushes"),
+    llvm::cl::value_desc("period"), llvm::cl::init(16u));
+
+static llvm::cl::opt<unsigned int> live_interval(
+    "live-interval",
+    llvm::cl::desc("Live mode : host sampling interval, in microseconds"),
+    llvm::cl::value_desc("interval"), llvm::cl::init(100000u));
+
+static llvm::cl::opt<bool> sparse_readback(
+    "sparse",
+    llvm::cl::desc("Compact the counters on the device before the transfer"),
+    llvm::cl::init(false));
+
 // ----- Utils ----- //
 
 void appendFlag(clang::tooling::CompilationDatabase& db_in,
@@ -61,6 +102,41 @@ void appendFlag(clang::tooling::CompilationDatabase& db_in,
     db.appendArgumentsAdjuster(adjuster);
 }
 
+std::unique_ptr<hip::InstrGenerator> makeInstrGenerator() {
+    std::unique_ptr<hip::InstrGenerator> instr_gen;
+
+    // The other modes have their own readback, which ignores the flag
+    if (sparse_readback.getValue() &&
+        instrumentation_mode.getValue() != InstrumentationMode::counters &&
+        instrumentation_mode.getValue() != InstrumentationMode::live) {
+        throw std::runtime_error("makeInstrGenerator() : -sparse is only "
+                                 "supported by the counters and live modes");
+    }
+
+    switch (instrumentation_mode.getValue()) {
+    case InstrumentationMode::live:
+        instr_gen = std::make_unique<hip::LiveInstrGenerator>(
+            live_period.getValue(), live_interval.getValue());
+        break;
+    case InstrumentationMode::signatures:
+        instr_gen = std::make_unique<hip::SignatureInstrGenerator>();
+        break;
+    case InstrumentationMode::coverage:
+        instr_gen = std::make_unique<hip::CoverageInstrGenerator>();
+        break;
+    case InstrumentationMode::graph:
+        instr_gen = std::make_unique<hip::GraphInstrGenerator>();
+        break;
+    case InstrumentationMode::counters:
+    default:
+        instr_gen = std::make_unique<hip::InstrGenerator>();
+    }
+
+    instr_gen->sparse_readback = sparse_readback.getValue();
+
+    return instr_gen;
+}
+
 void saveDatabase(const std::vector<hip::BasicBlock>& blocks,
                   const std::string& database_filename) {
     std::error_code err;
@@ -96,8 +172,8 @@ int main(int argc, const char** argv) {
     auto kernel_call_matcher = hip::kernelCallMatcher(kernel_name.getValue());
 
     // Instrument basic blocks
-    auto kernel_instrumenter =
-        hip::makeCfgInstrumenter(kernel_name.getValue(), blocks);
+    auto kernel_instrumenter = hip::makeCfgInstrumenter(
+        kernel_name.getValue(), blocks, makeInstrGenerator());
 
     /* auto kernel_call_instrumenter = hip::makeCudaCallInstrumenter(
         kernel_name.getValue(), output_file.getValue()); */
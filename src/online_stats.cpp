@@ -0,0 +1,120 @@
+/** \file online_stats.cpp
+ * \brief Online statistics of the basic block counts across launches
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/online_stats.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+#include <json/json.h>
+
+namespace hip {
+
+void RunningStats::merge(const RunningStats& other) {
+    if (other.n == 0u) {
+        return;
+    }
+
+    auto total = n + other.n;
+    auto delta = other.mean - mean;
+
+    m2 += other.m2 + delta * delta * (static_cast<double>(n) * other.n / total);
+    mean += delta * other.n / total;
+    n = total;
+
+    min = other.min < min ? other.min : min;
+    max = other.max > max ? other.max : max;
+}
+
+void KernelStats::add(const uint64_t* totals, size_t bb_count) {
+    if (blocks.empty()) {
+        blocks.resize(bb_count);
+    } else if (blocks.size() != bb_count) {
+        throw std::runtime_error("hip::KernelStats::add() : Inconsistent "
+                                 "number of basic blocks");
+    }
+
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        blocks[bb].add(totals[bb]);
+    }
+}
+
+void StatsRegistry::add(const std::string& kernel, const uint64_t* totals,
+                        size_t bb_count) {
+    std::scoped_lock lock(mutex);
+    stats[kernel].add(totals, bb_count);
+}
+
+std::map<std::string, KernelStats> StatsRegistry::kernels() const {
+    std::scoped_lock lock(mutex);
+    return stats;
+}
+
+std::string StatsRegistry::json() const {
+    Json::Value root(Json::objectValue);
+
+    for (const auto& [kernel, kernel_stats] : kernels()) {
+        Json::Value value;
+        value["launches"] = Json::UInt64(kernel_stats.launches());
+        value["blocks"] = Json::Value(Json::arrayValue);
+
+        for (auto bb = 0u; bb < kernel_stats.blocks.size(); ++bb) {
+            const auto& block = kernel_stats.blocks[bb];
+
+            Json::Value block_value;
+            block_value["id"] = bb;
+            block_value["mean"] = block.mean;
+            block_value["variance"] = block.variance();
+            block_value["stddev"] = block.stddev();
+            block_value["min"] = Json::UInt64(block.n ? block.min : 0u);
+            block_value["max"] = Json::UInt64(block.max);
+            value["blocks"].append(block_value);
+        }
+
+        root[kernel] = value;
+    }
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "    ";
+    return Json::writeString(builder, root);
+}
+
+StatsRegistry* StatsRegistry::global() {
+    /** \brief Writes the statistics when destroyed, at exit
+     */
+    struct GlobalRegistry {
+        std::string filename;
+        StatsRegistry registry;
+
+        ~GlobalRegistry() {
+            std::ofstream out(filename);
+            if (!out.is_open()) {
+                // Can't throw in a destructor
+                std::cerr << "hip::StatsRegistry::global() : Could not open "
+                          << filename << '\n';
+                return;
+            }
+
+            out << registry.json() << '\n';
+        }
+    };
+
+    static std::unique_ptr<GlobalRegistry> global = []() {
+        std::unique_ptr<GlobalRegistry> ret;
+        if (const char* env = std::getenv(stats_env_var)) {
+            ret = std::make_unique<GlobalRegistry>();
+            ret->filename = env;
+        }
+        return ret;
+    }();
+
+    return global ? &global->registry : nullptr;
+}
+
+} // namespace hip
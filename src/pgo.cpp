@@ -0,0 +1,228 @@
+/** \file pgo.cpp
+ * \brief Profile-guided optimization feedback from the measured counts
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/pgo.hpp"
+#include "hip_instrumentation/source_map.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include <json/json.h>
+
+namespace hip {
+
+std::vector<EdgeCount> inferEdgeCounts(const std::vector<BasicBlock>& blocks,
+                                       const std::vector<uint64_t>& counts) {
+    auto count = [&](uint32_t bb) -> uint64_t {
+        return bb < counts.size() ? counts[bb] : 0u;
+    };
+
+    std::vector<EdgeCount> edges;
+    std::vector<std::vector<size_t>> outgoing(blocks.size()),
+        incoming(blocks.size());
+
+    // The exit is a sink : its inflow is not constrained, so it has no
+    // incoming set
+    for (auto bb = 0u; bb < blocks.size(); ++bb) {
+        for (auto succ : blocks[bb].successors) {
+            if (succ < blocks.size()) {
+                outgoing[bb].emplace_back(edges.size());
+                incoming[succ].emplace_back(edges.size());
+                edges.push_back({bb, succ, 0u, false});
+            } else if (succ == BasicBlock::exit_block) {
+                outgoing[bb].emplace_back(edges.size());
+                edges.push_back({bb, succ, 0u, false});
+            }
+        }
+    }
+
+    // The entries of the kernel are also entered from outside of the CFG, so
+    // their incoming edges do not add up to their count. As in findLoops, the
+    // entries are the blocks without predecessors, or block 0 if there is none
+    auto has_roots = std::any_of(incoming.begin(), incoming.end(),
+                                 [](const auto& set) { return set.empty(); });
+
+    // Solves the only unknown edge of a set whose sum is the count of the
+    // block, returns true if an edge was solved
+    auto solve = [&](const std::vector<size_t>& set, uint64_t total) {
+        uint64_t known = 0u;
+        size_t unknown = 0u, last = 0u;
+
+        for (auto e : set) {
+            if (edges[e].exact) {
+                known += edges[e].count;
+            } else {
+                ++unknown;
+                last = e;
+            }
+        }
+
+        if (unknown != 1u) {
+            return false;
+        }
+
+        edges[last].count = total > known ? total - known : 0u;
+        edges[last].exact = true;
+        return true;
+    };
+
+    bool progress = true;
+    while (progress) {
+        progress = false;
+
+        for (auto bb = 0u; bb < blocks.size(); ++bb) {
+            if (!outgoing[bb].empty()) {
+                progress |= solve(outgoing[bb], count(bb));
+            }
+
+            if (!incoming[bb].empty() && (has_roots || bb != 0u)) {
+                progress |= solve(incoming[bb], count(bb));
+            }
+        }
+    }
+
+    // Estimates : split the remaining outgoing flow of every block
+    for (auto bb = 0u; bb < blocks.size(); ++bb) {
+        uint64_t known = 0u, weights = 0u;
+        std::vector<size_t> unknown;
+
+        for (auto e : outgoing[bb]) {
+            if (edges[e].exact) {
+                known += edges[e].count;
+            } else {
+                unknown.emplace_back(e);
+                weights += count(edges[e].to);
+            }
+        }
+
+        if (unknown.empty()) {
+            continue;
+        }
+
+        auto remaining = count(bb) > known ? count(bb) - known : 0u;
+        uint64_t assigned = 0u;
+
+        for (auto i = 0u; i < unknown.size(); ++i) {
+            auto& edge = edges[unknown[i]];
+
+            if (i + 1u == unknown.size()) {
+                edge.count = remaining - assigned;
+            } else if (weights == 0u) {
+                edge.count = remaining / unknown.size();
+            } else {
+                edge.count = std::llround(static_cast<double>(remaining) *
+                                          count(edge.to) / weights);
+                edge.count = std::min(edge.count, remaining - assigned);
+            }
+
+            assigned += edge.count;
+        }
+    }
+
+    return edges;
+}
+
+std::string BranchWeights::metadata() const {
+    uint64_t max = 0u;
+    for (const auto& edge : edges) {
+        max = std::max(max, edge.count);
+    }
+
+    constexpr uint64_t max_weight = std::numeric_limits<uint32_t>::max();
+    auto scale = max > max_weight ? (max + max_weight - 1) / max_weight : 1u;
+
+    std::stringstream ss;
+    ss << "!{!\"branch_weights\"";
+    for (const auto& edge : edges) {
+        ss << ", i32 " << edge.count / scale;
+    }
+    ss << '}';
+
+    return ss.str();
+}
+
+std::vector<BranchWeights> branchWeights(const std::vector<EdgeCount>& edges) {
+    std::vector<BranchWeights> ret;
+
+    // Edges are grouped by source block
+    for (auto begin = edges.begin(); begin != edges.end();) {
+        auto end = std::find_if(begin, edges.end(), [&](const auto& edge) {
+            return edge.from != begin->from;
+        });
+
+        if (std::distance(begin, end) > 1) {
+            ret.push_back({begin->from, {begin, end}});
+        }
+
+        begin = end;
+    }
+
+    return ret;
+}
+
+std::string branchWeightsJson(const std::vector<BranchWeights>& weights,
+                              const std::vector<BasicBlock>& blocks,
+                              const std::vector<uint64_t>& counts) {
+    Json::Value root(Json::arrayValue);
+
+    for (const auto& branch : weights) {
+        Json::Value value;
+        value["block"] = branch.block;
+        value["count"] = Json::UInt64(
+            branch.block < counts.size() ? counts[branch.block] : 0u);
+
+        if (branch.block < blocks.size()) {
+            value["begin"] = *blocks[branch.block].begin_loc;
+            value["end"] = *blocks[branch.block].end_loc;
+        }
+
+        value["successors"] = Json::Value(Json::arrayValue);
+        for (const auto& edge : branch.edges) {
+            Json::Value successor;
+            successor["block"] = edge.to == BasicBlock::exit_block
+                                     ? Json::Value("exit")
+                                     : Json::Value(edge.to);
+            successor["count"] = Json::UInt64(edge.count);
+            successor["exact"] = edge.exact;
+            value["successors"].append(successor);
+        }
+
+        value["metadata"] = branch.metadata();
+        root.append(value);
+    }
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "    ";
+    return Json::writeString(builder, root);
+}
+
+void writeSampleProfile(std::ostream& out, const std::string& function,
+                        const std::string& file, uint32_t function_line,
+                        const std::vector<BasicBlock>& blocks,
+                        const std::vector<uint64_t>& counts, uint64_t entries) {
+    SourceMap source_map(blocks);
+    auto stats = source_map.lineStats(file, counts);
+
+    std::stringstream body;
+    uint64_t total = 0u;
+
+    for (auto line = std::max(function_line, 1u); line < stats.size();
+         ++line) {
+        if (source_map.blockAt(file, line) == SourceMap::no_block) {
+            continue;
+        }
+
+        body << ' ' << line - function_line << ": " << stats[line].executions
+             << '\n';
+        total += stats[line].executions;
+    }
+
+    out << function << ':' << total << ':' << entries << '\n' << body.str();
+}
+
+} // namespace hip
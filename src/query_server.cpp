@@ -0,0 +1,678 @@
+/** \file query_server.cpp
+ * \brief Long-running local analysis server
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/query_server.hpp"
+#include "hip_instrumentation/hip_instrumentation.hpp"
+#include "hip_instrumentation/parallel.hpp"
+#include "hip_instrumentation/streaming.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <json/json.h>
+
+namespace hip {
+
+namespace {
+
+/** \class WorkgroupCountReducer
+ * \brief Sums the counters of the threads of each workgroup
+ */
+class WorkgroupCountReducer : public ChunkReducer {
+  public:
+    WorkgroupCountReducer(uint32_t threads_per_block, uint32_t bb_count,
+                          std::vector<uint32_t>& output, unsigned int threads)
+        : threads_per_block(threads_per_block), bb_count(bb_count),
+          output(output), threads(threads) {}
+
+    void reduce(const TraceChunk& chunk) override {
+        parallelFor(
+            chunk.workgroups,
+            [&](size_t wg) {
+                auto dst = &output[(chunk.first_workgroup + wg) * bb_count];
+                auto src = &chunk.counters[wg * threads_per_block * bb_count];
+
+                for (auto t = 0u; t < threads_per_block; ++t) {
+                    for (auto bb = 0u; bb < bb_count; ++bb) {
+                        dst[bb] += src[t * bb_count + bb];
+                    }
+                }
+            },
+            threads);
+    }
+
+  private:
+    uint32_t threads_per_block;
+    uint32_t bb_count;
+    std::vector<uint32_t>& output;
+    unsigned int threads;
+};
+
+/** \brief Number of wavefronts kept in the divergence index
+ */
+constexpr size_t indexed_waves = 256u;
+
+/** \brief Longest accepted request, the connection is closed beyond
+ */
+constexpr size_t max_request_size = 64u * 1024u;
+
+/** \brief Connections without any request for this long are closed
+ */
+constexpr auto idle_timeout = std::chrono::minutes(5);
+
+/** \brief Longest a worker waits for a client to read a response
+ */
+constexpr auto send_timeout = std::chrono::seconds(10);
+
+/** \brief Poll timeout of the listening thread, bounds the idle timeout
+ * accuracy
+ */
+constexpr int poll_interval_ms = 1000;
+
+std::string toString(const Json::Value& value) {
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "";
+    return Json::writeString(builder, value);
+}
+
+std::string errorResponse(const std::string& message) {
+    Json::Value root;
+    root["error"] = message;
+    return toString(root);
+}
+
+size_t parseCount(const std::string& word) {
+    if (word.empty() ||
+        !std::all_of(word.begin(), word.end(),
+                     [](char c) { return c >= '0' && c <= '9'; })) {
+        throw std::runtime_error("Invalid number : " + word);
+    }
+
+    return std::stoull(word);
+}
+
+} // namespace
+
+// ----- TraceIndex ----- //
+
+std::shared_ptr<const TraceIndex> TraceIndex::build(
+    const std::string& kernel_info_file, const std::string& hiptrace,
+    const std::string& database, unsigned int threads) {
+    auto kernel_info = KernelInfo::fromJson(kernel_info_file);
+
+    auto index = std::make_shared<TraceIndex>();
+    index->kernel = kernel_info.name;
+    index->total_blocks = kernel_info.total_blocks;
+    index->threads_per_block = kernel_info.total_threads_per_blocks;
+    index->bb_count = kernel_info.basic_blocks;
+
+    index->blocks = BasicBlock::normalized(BasicBlock::fromJsonArray(
+        database.empty() ? BasicBlock::getEnvDatabaseFile(kernel_info.name)
+                         : database));
+
+    TraceChunkReader reader(hiptrace);
+    if (reader.size() != kernel_info.instr_size) {
+        throw std::runtime_error("hip::TraceIndex::build() : Trace " +
+                                 hiptrace +
+                                 " incompatible with the kernel info");
+    }
+
+    auto bb_count = index->bb_count;
+    index->workgroup_counts.resize(
+        static_cast<size_t>(index->total_blocks) * bb_count, 0u);
+
+    CountReducer counts(bb_count, threads);
+    WorkgroupCountReducer workgroups(index->threads_per_block, bb_count,
+                                     index->workgroup_counts, threads);
+    DivergenceReducer divergence(index->threads_per_block, bb_count,
+                                 kernel_info.wave_size, indexed_waves,
+                                 threads);
+
+    StreamingAnalysis(reader, index->threads_per_block, bb_count)
+        .add(counts)
+        .add(workgroups)
+        .add(divergence)
+        .run();
+
+    index->counts = counts.counts();
+    index->divergence = divergence.report();
+
+    auto blockFlops = [&](uint32_t bb) -> uint64_t {
+        return bb < index->blocks.size() ? index->blocks[bb].flops : 0u;
+    };
+
+    index->flops.resize(bb_count);
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        index->flops[bb] = index->counts[bb] * blockFlops(bb);
+    }
+
+    index->workgroup_flops.resize(index->total_blocks);
+    for (auto wg = 0u; wg < index->total_blocks; ++wg) {
+        uint64_t flops = 0u;
+        for (auto bb = 0u; bb < bb_count; ++bb) {
+            flops += static_cast<uint64_t>(
+                         index->workgroup_counts[wg * bb_count + bb]) *
+                     blockFlops(bb);
+        }
+        index->workgroup_flops[wg] = flops;
+    }
+
+    return index;
+}
+
+// ----- QueryServer ----- //
+
+QueryServer::QueryServer(const std::string& path, unsigned int workers,
+                         const std::string& root, unsigned int mode)
+    : socket_path(path), worker_count(workers ? workers : hardwareThreads()),
+      socket_mode(mode) {
+    if (!root.empty()) {
+        std::error_code err;
+        data_root = std::filesystem::canonical(root, err);
+
+        if (err) {
+            throw std::runtime_error(
+                "hip::QueryServer::QueryServer() : Invalid data root " + root +
+                " : " + err.message());
+        }
+    }
+}
+
+QueryServer::~QueryServer() { stop(); }
+
+void QueryServer::load(const std::string& name,
+                       const std::string& kernel_info,
+                       const std::string& hiptrace,
+                       const std::string& database) {
+    // Built outside of the lock, the other traces can still be queried
+    auto index = TraceIndex::build(kernel_info, hiptrace, database);
+
+    std::unique_lock lock(traces_mutex);
+    traces[name] = std::move(index);
+}
+
+std::shared_ptr<const TraceIndex>
+QueryServer::find(const std::string& name) const {
+    std::shared_lock lock(traces_mutex);
+
+    auto it = traces.find(name);
+    if (it == traces.end()) {
+        throw std::runtime_error("Unknown trace : " + name);
+    }
+
+    return it->second;
+}
+
+std::string QueryServer::resolve(const std::string& path) const {
+    if (data_root.empty()) {
+        throw std::runtime_error("Loading traces is disabled on this server");
+    }
+
+    // Resolves the symbolic links, which could point outside of the root
+    auto resolved = std::filesystem::weakly_canonical(data_root / path);
+    auto relative = resolved.lexically_relative(data_root);
+
+    if (relative.empty() || *relative.begin() == "..") {
+        throw std::runtime_error("Path outside of the data root : " + path);
+    }
+
+    return resolved.string();
+}
+
+std::string QueryServer::handle(const std::string& request) {
+    std::istringstream ss(request);
+    std::vector<std::string> words;
+    for (std::string word; ss >> word;) {
+        words.emplace_back(word);
+    }
+
+    if (words.empty()) {
+        return errorResponse("Empty request");
+    }
+
+    auto arg = [&](size_t i, const std::string& default_value = "") {
+        if (i < words.size()) {
+            return words[i];
+        } else if (default_value.empty()) {
+            throw std::runtime_error("Missing argument for " + words[0]);
+        }
+        return default_value;
+    };
+
+    try {
+        const auto& command = words[0];
+        Json::Value root;
+
+        if (command == "load") {
+            load(arg(1), resolve(arg(2)), resolve(arg(3)),
+                 words.size() > 4 ? resolve(words[4]) : std::string());
+
+            auto index = find(arg(1));
+            root["loaded"] = arg(1);
+            root["kernel"] = index->kernel;
+            root["workgroups"] = index->total_blocks;
+        } else if (command == "unload") {
+            std::unique_lock lock(traces_mutex);
+            if (traces.erase(arg(1)) == 0u) {
+                throw std::runtime_error("Unknown trace : " + arg(1));
+            }
+
+            root["unloaded"] = arg(1);
+        } else if (command == "list") {
+            std::shared_lock lock(traces_mutex);
+
+            root["traces"] = Json::Value(Json::arrayValue);
+            for (const auto& [name, index] : traces) {
+                Json::Value trace;
+                trace["name"] = name;
+                trace["kernel"] = index->kernel;
+                trace["workgroups"] = index->total_blocks;
+                trace["threads_per_block"] = index->threads_per_block;
+                trace["basic_blocks"] = index->bb_count;
+                root["traces"].append(trace);
+            }
+        } else if (command == "top") {
+            auto index = find(arg(1));
+            auto n = parseCount(arg(2, "10"));
+            auto key = arg(3, "count");
+
+            const auto& div = index->divergence.blocks;
+            auto value = [&](uint32_t bb) -> uint64_t {
+                if (key == "count") {
+                    return index->counts[bb];
+                } else if (key == "flops") {
+                    return index->flops[bb];
+                } else if (key == "wasted") {
+                    return div[bb].wastedSlots();
+                }
+                throw std::runtime_error("Unknown sort key : " + key);
+            };
+
+            std::vector<uint32_t> ids(index->bb_count);
+            std::iota(ids.begin(), ids.end(), 0u);
+
+            n = std::min(n, ids.size());
+            std::partial_sort(
+                ids.begin(), ids.begin() + n, ids.end(),
+                [&](auto lhs, auto rhs) { return value(lhs) > value(rhs); });
+
+            root["blocks"] = Json::Value(Json::arrayValue);
+            for (auto i = 0u; i < n; ++i) {
+                auto bb = ids[i];
+
+                Json::Value block;
+                block["id"] = bb;
+                block["count"] = Json::UInt64(index->counts[bb]);
+                block["flops"] = Json::UInt64(index->flops[bb]);
+                block["efficiency"] = div[bb].efficiency();
+                block["wasted"] = Json::UInt64(div[bb].wastedSlots());
+
+                if (bb < index->blocks.size()) {
+                    block["begin"] = *index->blocks[bb].begin_loc;
+                    block["end"] = *index->blocks[bb].end_loc;
+                }
+
+                root["blocks"].append(block);
+            }
+        } else if (command == "workgroup") {
+            auto index = find(arg(1));
+            auto wg = parseCount(arg(2));
+            if (wg >= index->total_blocks) {
+                throw std::runtime_error("Workgroup out of bounds");
+            }
+
+            root["workgroup"] = Json::UInt64(wg);
+            root["flops"] = Json::UInt64(index->workgroup_flops[wg]);
+            root["counts"] = Json::Value(Json::arrayValue);
+
+            for (auto bb = 0u; bb < index->bb_count; ++bb) {
+                root["counts"].append(
+                    index->workgroup_counts[wg * index->bb_count + bb]);
+            }
+        } else if (command == "workgroups") {
+            auto index = find(arg(1));
+            const auto& flops = index->workgroup_flops;
+
+            std::vector<uint32_t> ids(index->total_blocks);
+            std::iota(ids.begin(), ids.end(), 0u);
+
+            auto n = std::min(parseCount(arg(2, "10")), ids.size());
+            std::partial_sort(
+                ids.begin(), ids.begin() + n, ids.end(),
+                [&](auto lhs, auto rhs) { return flops[lhs] > flops[rhs]; });
+
+            root["workgroups"] = Json::Value(Json::arrayValue);
+            for (auto i = 0u; i < n; ++i) {
+                Json::Value wg;
+                wg["workgroup"] = ids[i];
+                wg["flops"] = Json::UInt64(flops[ids[i]]);
+                root["workgroups"].append(wg);
+            }
+        } else if (command == "divergence") {
+            auto index = find(arg(1));
+            const auto& report = index->divergence;
+            auto n = std::min(parseCount(arg(2, "10")), report.waves.size());
+
+            root["efficiency"] = report.total.efficiency();
+            root["active_fraction"] = report.total.activeFraction();
+            root["wasted"] = Json::UInt64(report.total.wastedSlots());
+            root["waves"] = Json::Value(Json::arrayValue);
+
+            for (auto i = 0u; i < n; ++i) {
+                const auto& wave = report.waves[i];
+
+                Json::Value value;
+                value["workgroup"] = wave.workgroup;
+                value["wave"] = wave.wave;
+                value["efficiency"] = wave.efficiency();
+                value["paths"] = wave.distinct_vectors;
+                value["lanes"] = wave.lanes;
+                value["wasted"] = Json::UInt64(wave.wastedSlots());
+                root["waves"].append(value);
+            }
+        } else {
+            throw std::runtime_error("Unknown request : " + command);
+        }
+
+        return toString(root);
+    } catch (const std::exception& e) {
+        return errorResponse(e.what());
+    }
+}
+
+void QueryServer::serve() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error(
+            "hip::QueryServer::serve() : Socket path too long");
+    }
+    std::strcpy(address.sun_path, socket_path.c_str());
+
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        throw std::runtime_error(
+            "hip::QueryServer::serve() : Could not create socket : " +
+            std::string(std::strerror(errno)));
+    }
+
+    // Remove a stale socket from a previous run
+    ::unlink(socket_path.c_str());
+
+    // Restrict the permissions before listening, no one else can connect in
+    // between
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&address),
+               sizeof(address)) < 0 ||
+        ::chmod(socket_path.c_str(), static_cast<mode_t>(socket_mode)) < 0 ||
+        ::listen(listen_fd, SOMAXCONN) < 0 ||
+        ::pipe2(wake_pipe, O_CLOEXEC | O_NONBLOCK) < 0) {
+        auto error = std::string(std::strerror(errno));
+        ::close(listen_fd);
+        throw std::runtime_error(
+            "hip::QueryServer::serve() : Could not listen on " + socket_path +
+            " : " + error);
+    }
+
+    running = true;
+    for (auto i = 0u; i < worker_count; ++i) {
+        workers.emplace_back([this]() { work(); });
+    }
+
+    std::vector<pollfd> fds;
+
+    while (running) {
+        // Only the idle connections are read from, the requests of a
+        // connection are answered one at a time and in order
+        fds.clear();
+        fds.push_back({wake_pipe[0], POLLIN, 0});
+        fds.push_back({listen_fd, POLLIN, 0});
+        for (const auto& [fd, connection] : connections) {
+            if (!connection.busy && !connection.eof && !connection.overflow) {
+                fds.push_back({fd, POLLIN, 0});
+            }
+        }
+
+        if (::poll(fds.data(), fds.size(), poll_interval_ms) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break; // Unrecoverable
+        }
+
+        if (fds[0].revents & POLLIN) {
+            char buffer[64];
+            while (::read(wake_pipe[0], buffer, sizeof(buffer)) > 0) {
+            }
+        }
+
+        if (fds[1].revents & POLLIN) {
+            auto fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+
+            if (fd >= 0) {
+                // A client which doesn't read its responses can't hold a
+                // worker forever
+                timeval timeout{};
+                timeout.tv_sec = send_timeout.count();
+                ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                             sizeof(timeout));
+
+                connections[fd].last_activity =
+                    std::chrono::steady_clock::now();
+            } else if (errno != EINTR && errno != ECONNABORTED) {
+                break; // Unrecoverable
+            }
+        }
+
+        std::vector<int> closed;
+
+        for (auto i = 2u; i < fds.size(); ++i) {
+            if (fds[i].revents && !receive(fds[i].fd, connections[fds[i].fd])) {
+                closed.emplace_back(fds[i].fd);
+            }
+        }
+
+        {
+            std::scoped_lock lock(queue_mutex);
+            for (auto [fd, sent] : answered) {
+                connections[fd].busy = false;
+                if (!sent) {
+                    closed.emplace_back(fd);
+                }
+            }
+            answered.clear();
+        }
+
+        for (auto fd : closed) {
+            ::close(fd);
+            connections.erase(fd);
+        }
+
+        for (auto it = connections.begin(); it != connections.end();) {
+            if (dispatch(it->first, it->second)) {
+                ++it;
+            } else {
+                ::close(it->first);
+                it = connections.erase(it);
+            }
+        }
+    }
+
+    stop();
+
+    // Unblocks the workers still sending a response
+    for (const auto& [fd, connection] : connections) {
+        ::shutdown(fd, SHUT_RDWR);
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    for (const auto& [fd, connection] : connections) {
+        ::close(fd);
+    }
+    connections.clear();
+
+    {
+        std::scoped_lock lock(queue_mutex);
+        requests = {};
+        answered.clear();
+
+        ::close(wake_pipe[0]);
+        ::close(wake_pipe[1]);
+        wake_pipe[0] = wake_pipe[1] = -1;
+    }
+
+    ::close(listen_fd);
+    listen_fd = -1;
+    ::unlink(socket_path.c_str());
+}
+
+void QueryServer::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+
+    wake();
+    queue_cv.notify_all();
+}
+
+void QueryServer::wake() {
+    std::scoped_lock lock(queue_mutex);
+
+    // Full pipe : the listening thread is already being woken up
+    if (wake_pipe[1] >= 0) {
+        char byte = 0;
+        (void)::write(wake_pipe[1], &byte, 1u);
+    }
+}
+
+bool QueryServer::receive(int fd, Connection& connection) {
+    char buffer[4096];
+
+    auto received = ::recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (received < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    } else if (received == 0) {
+        connection.eof = true;
+        return true;
+    }
+
+    connection.pending.append(buffer, received);
+    connection.last_activity = std::chrono::steady_clock::now();
+
+    // No end of line in sight, the client is misbehaving. Drop the partial
+    // request, the previous ones are still answered
+    auto last = connection.pending.rfind('\n');
+    auto partial = last == std::string::npos
+                       ? connection.pending.size()
+                       : connection.pending.size() - last - 1u;
+
+    if (partial > max_request_size) {
+        connection.pending.resize(connection.pending.size() - partial);
+        connection.overflow = true;
+    }
+
+    return true;
+}
+
+bool QueryServer::dispatch(int fd, Connection& connection) {
+    if (connection.busy) {
+        return true;
+    }
+
+    auto end = connection.pending.find('\n');
+
+    if (end == std::string::npos) {
+        if (connection.overflow) {
+            auto response = errorResponse("Request too long") + '\n';
+            ::send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+            return false;
+        }
+
+        return !connection.eof && std::chrono::steady_clock::now() -
+                                          connection.last_activity <
+                                      idle_timeout;
+    }
+
+    auto request = connection.pending.substr(0, end);
+    connection.pending.erase(0, end + 1);
+
+    if (!request.empty() && request.back() == '\r') {
+        request.pop_back();
+    }
+
+    if (request == "quit") {
+        return false;
+    }
+
+    connection.busy = true;
+    connection.last_activity = std::chrono::steady_clock::now();
+
+    std::scoped_lock lock(queue_mutex);
+    requests.push({fd, std::move(request)});
+    queue_cv.notify_one();
+
+    return true;
+}
+
+void QueryServer::work() {
+    while (true) {
+        Request request;
+
+        {
+            std::unique_lock lock(queue_mutex);
+            queue_cv.wait(lock,
+                          [&]() { return !requests.empty() || !running; });
+
+            if (!running) {
+                return;
+            }
+
+            request = std::move(requests.front());
+            requests.pop();
+        }
+
+        auto response = handle(request.line) + '\n';
+
+        auto sent = true;
+        for (size_t offset = 0u; sent && offset < response.size();) {
+            auto ret = ::send(request.fd, response.data() + offset,
+                              response.size() - offset, MSG_NOSIGNAL);
+            if (ret > 0) {
+                offset += ret;
+            } else if (ret < 0 && errno == EINTR) {
+                continue;
+            } else {
+                sent = false;
+            }
+        }
+
+        {
+            std::scoped_lock lock(queue_mutex);
+            answered.emplace_back(request.fd, sent);
+        }
+
+        wake();
+    }
+}
+
+} // namespace hip
@@ -0,0 +1,392 @@
+/** \file roofline.cpp
+ * \brief Roofline model of an instrumented kernel
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/roofline.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace hip {
+
+namespace {
+
+std::string escapeJson(const std::string& str) {
+    std::string ret;
+    for (auto c : str) {
+        if (c == '"' || c == '\\') {
+            ret += '\\';
+        }
+        ret += c;
+    }
+    return ret;
+}
+
+std::string escapeXml(const std::string& str) {
+    std::string ret;
+    for (auto c : str) {
+        switch (c) {
+        case '<':
+            ret += "&lt;";
+            break;
+        case '>':
+            ret += "&gt;";
+            break;
+        case '&':
+            ret += "&amp;";
+            break;
+        case '"':
+            ret += "&quot;";
+            break;
+        default:
+            ret += c;
+        }
+    }
+    return ret;
+}
+
+double highestMemoryRoof(const std::vector<RoofPlacement>& roofs) {
+    auto peak = 0.;
+    for (const auto& roof : roofs) {
+        if (roof.memory) {
+            peak = std::max(peak, roof.peak);
+        }
+    }
+    return peak;
+}
+
+double highestComputeRoof(const std::vector<RoofPlacement>& roofs) {
+    auto peak = 0.;
+    for (const auto& roof : roofs) {
+        if (!roof.memory) {
+            peak = std::max(peak, roof.peak);
+        }
+    }
+    return peak;
+}
+
+/** \fn placeBlocks
+ * \brief Per basic block roofline. Times are computed rather than FLOP/s, so
+ * blocks without memory accesses or floating point operations are handled
+ */
+std::vector<BlockRoofline> placeBlocks(const Roofline& model,
+                                       const ArithmeticIntensity& ai) {
+    auto max_bw = highestMemoryRoof(model.roofs);
+    auto max_compute = highestComputeRoof(model.roofs);
+
+    std::vector<BlockRoofline> blocks;
+    auto total_time = 0.;
+
+    for (auto bb = 0u; bb < ai.blocks.size(); ++bb) {
+        const auto& block = ai.blocks[bb];
+        if (block.flops == 0u && block.bytes == 0u) {
+            continue;
+        }
+
+        auto compute_time = block.flops / max_compute;
+        auto memory_time = block.bytes / max_bw;
+
+        BlockRoofline placement{};
+        placement.id = bb;
+        placement.flops = block.flops;
+        placement.bytes = block.bytes;
+        placement.intensity = block.intensity();
+        placement.memory_bound = memory_time > compute_time;
+
+        // Time at the highest roofs, scaled to the kernel duration below
+        placement.time = std::max(compute_time, memory_time);
+        total_time += placement.time;
+
+        blocks.push_back(placement);
+    }
+
+    for (auto& block : blocks) {
+        block.time_share = block.time / total_time;
+        block.time = block.time_share * model.duration;
+        block.flops_s = block.flops / block.time;
+
+        // The nearest roof above is the one which would take the longest, yet
+        // is faster than the block
+        auto roof_time = 0.;
+        for (const auto& roof : model.roofs) {
+            auto work = roof.memory ? block.bytes : block.flops;
+            if (work == 0u || roof.peak <= 0.) {
+                continue;
+            }
+
+            auto time = work / roof.peak;
+            if (time <= block.time && time > roof_time) {
+                roof_time = time;
+                block.nearest_roof = roof.name;
+            }
+        }
+
+        if (roof_time > 0.) {
+            block.speedup = block.time / roof_time;
+            block.time_saved = block.time - roof_time;
+        } else {
+            block.speedup = 1.;
+            block.time_saved = 0.;
+        }
+    }
+
+    return blocks;
+}
+
+} // namespace
+
+std::vector<size_t> Roofline::sortedBlocks(BlockOrder order) const {
+    auto key = [&](size_t i) {
+        switch (order) {
+        case BlockOrder::Speedup:
+            return blocks[i].speedup;
+        case BlockOrder::TimeShare:
+            return blocks[i].time_share;
+        default:
+            return blocks[i].time_saved;
+        }
+    };
+
+    std::vector<size_t> indices(blocks.size());
+    std::iota(indices.begin(), indices.end(), 0u);
+    std::stable_sort(indices.begin(), indices.end(),
+                     [&](auto lhs, auto rhs) { return key(lhs) > key(rhs); });
+
+    return indices;
+}
+
+Roofline roofline(const GpuInfo& gpu_info, const std::string& kernel,
+                  const ArithmeticIntensity& ai, double duration) {
+    if (gpu_info.memory_roofs.empty() || gpu_info.compute_roofs.empty()) {
+        throw std::runtime_error(
+            "hip::roofline() : The GPU info needs memory and compute roofs");
+    }
+
+    if (duration <= 0.) {
+        throw std::runtime_error("hip::roofline() : Invalid kernel duration");
+    }
+
+    Roofline model;
+    model.kernel = kernel;
+    model.gpu = gpu_info.id;
+    model.duration = duration;
+    model.flops = ai.total.flops;
+    model.bytes = ai.total.bytes;
+    model.intensity = ai.total.intensity();
+    model.flops_s = model.flops / duration;
+    model.bandwidth = model.bytes / duration;
+
+    for (const auto& roof : gpu_info.memory_roofs) {
+        auto bound = roof.peak_bandwidth * model.intensity;
+        model.roofs.push_back({roof.name, true, roof.peak_bandwidth, bound,
+                               bound > 0. ? model.flops_s / bound : 0.});
+    }
+
+    for (const auto& roof : gpu_info.compute_roofs) {
+        auto bound = roof.peak_flops_s;
+        model.roofs.push_back({roof.name, false, roof.peak_flops_s, bound,
+                               bound > 0. ? model.flops_s / bound : 0.});
+    }
+
+    auto memory_bound = highestMemoryRoof(model.roofs) * model.intensity;
+    auto compute_bound = highestComputeRoof(model.roofs);
+
+    model.memory_bound = memory_bound < compute_bound;
+    model.attainable = std::min(memory_bound, compute_bound);
+
+    model.blocks = placeBlocks(model, ai);
+
+    return model;
+}
+
+std::string Roofline::json() const {
+    std::stringstream ss;
+
+    ss << "{\"kernel\":\"" << escapeJson(kernel) << "\",\"gpu\":\""
+       << escapeJson(gpu) << "\",\"duration\":" << duration
+       << ",\"flops\":" << flops << ",\"bytes\":" << bytes
+       << ",\"intensity\":" << intensity << ",\"flops_s\":" << flops_s
+       << ",\"bandwidth\":" << bandwidth << ",\"attainable\":" << attainable
+       << ",\"bound\":\"" << (memory_bound ? "memory" : "compute")
+       << "\",\"roofs\":[";
+
+    for (const auto& roof : roofs) {
+        ss << "{\"name\":\"" << escapeJson(roof.name) << "\",\"type\":\""
+           << (roof.memory ? "memory" : "compute")
+           << "\",\"peak\":" << roof.peak << ",\"bound\":" << roof.bound
+           << ",\"fraction\":" << roof.fraction << "},";
+    }
+
+    if (!roofs.empty()) {
+        ss.seekp(-1, ss.cur);
+    }
+
+    ss << "],\"blocks\":[";
+
+    for (const auto& block : blocks) {
+        ss << "{\"id\":" << block.id << ",\"flops\":" << block.flops
+           << ",\"bytes\":" << block.bytes
+           << ",\"intensity\":" << block.intensity
+           << ",\"time_share\":" << block.time_share
+           << ",\"time\":" << block.time << ",\"flops_s\":" << block.flops_s
+           << ",\"bound\":\"" << (block.memory_bound ? "memory" : "compute")
+           << "\",\"nearest_roof\":\"" << escapeJson(block.nearest_roof)
+           << "\",\"speedup\":" << block.speedup
+           << ",\"time_saved\":" << block.time_saved << "},";
+    }
+
+    if (!blocks.empty()) {
+        ss.seekp(-1, ss.cur);
+    }
+
+    ss << "]}";
+
+    return ss.str();
+}
+
+std::string Roofline::svg() const {
+    constexpr auto width = 800., height = 500., margin = 70.;
+    constexpr auto plot_w = width - 2 * margin, plot_h = height - 2 * margin;
+
+    auto max_bw = highestMemoryRoof(roofs);
+    auto max_compute = highestComputeRoof(roofs);
+    auto min_bw = max_bw;
+    for (const auto& roof : roofs) {
+        if (roof.memory && roof.peak > 0.) {
+            min_bw = std::min(min_bw, roof.peak);
+        }
+    }
+
+    auto ridge = max_compute / max_bw;
+
+    // Axes bounds, in log space
+    auto x_lo = ridge, x_hi = ridge, y_lo = max_compute;
+    auto include = [&](double x, double y) {
+        if (x > 0. && y > 0.) {
+            x_lo = std::min(x_lo, x);
+            x_hi = std::max(x_hi, x);
+            y_lo = std::min(y_lo, y);
+        }
+    };
+
+    include(intensity, flops_s);
+    for (const auto& block : blocks) {
+        include(block.intensity, block.flops_s);
+    }
+
+    x_lo /= 16.;
+    x_hi *= 16.;
+    y_lo = std::min(y_lo, min_bw * x_lo) / 2.;
+    auto y_hi = max_compute * 2.;
+
+    auto px = [&](double x) {
+        return margin + (std::log10(x) - std::log10(x_lo)) /
+                            (std::log10(x_hi) - std::log10(x_lo)) * plot_w;
+    };
+    auto py = [&](double y) {
+        return margin + plot_h -
+               (std::log10(y) - std::log10(y_lo)) /
+                   (std::log10(y_hi) - std::log10(y_lo)) * plot_h;
+    };
+
+    std::stringstream ss;
+
+    ss << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << width
+       << "\" height=\"" << height << "\" font-family=\"sans-serif\" "
+       << "font-size=\"11\">\n"
+       << "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n"
+       << "<text x=\"" << width / 2 << "\" y=\"" << margin / 2
+       << "\" text-anchor=\"middle\" font-size=\"14\">"
+       << escapeXml(kernel + " on " + gpu) << "</text>\n";
+
+    // Grid & ticks on powers of 10
+
+    for (auto e = std::ceil(std::log10(x_lo)); e <= std::log10(x_hi); ++e) {
+        auto x = px(std::pow(10., e));
+        ss << "<line x1=\"" << x << "\" y1=\"" << margin << "\" x2=\"" << x
+           << "\" y2=\"" << margin + plot_h << "\" stroke=\"#ddd\"/>\n"
+           << "<text x=\"" << x << "\" y=\"" << margin + plot_h + 15
+           << "\" text-anchor=\"middle\">1e" << static_cast<int>(e)
+           << "</text>\n";
+    }
+
+    for (auto e = std::ceil(std::log10(y_lo)); e <= std::log10(y_hi); ++e) {
+        auto y = py(std::pow(10., e));
+        ss << "<line x1=\"" << margin << "\" y1=\"" << y << "\" x2=\""
+           << margin + plot_w << "\" y2=\"" << y << "\" stroke=\"#ddd\"/>\n"
+           << "<text x=\"" << margin - 5 << "\" y=\"" << y + 4
+           << "\" text-anchor=\"end\">1e" << static_cast<int>(e)
+           << "</text>\n";
+    }
+
+    ss << "<rect x=\"" << margin << "\" y=\"" << margin << "\" width=\""
+       << plot_w << "\" height=\"" << plot_h
+       << "\" fill=\"none\" stroke=\"black\"/>\n"
+       << "<text x=\"" << width / 2 << "\" y=\"" << height - 20
+       << "\" text-anchor=\"middle\">Arithmetic intensity (FLOPs/byte)</text>\n"
+       << "<text transform=\"translate(20," << height / 2
+       << ") rotate(-90)\" text-anchor=\"middle\">FLOP/s</text>\n";
+
+    // Roofs : slanted up to the highest compute roof, flat from the highest
+    // memory roof
+
+    for (const auto& roof : roofs) {
+        if (roof.peak <= 0.) {
+            continue;
+        }
+
+        double x1, y1, x2, y2;
+        if (roof.memory) {
+            x1 = x_lo;
+            y1 = roof.peak * x_lo;
+            x2 = std::min(x_hi, max_compute / roof.peak);
+            y2 = roof.peak * x2;
+        } else {
+            x1 = std::max(x_lo, roof.peak / max_bw);
+            y1 = y2 = roof.peak;
+            x2 = x_hi;
+        }
+
+        auto color = roof.memory ? "#1f77b4" : "#d62728";
+
+        ss << "<line x1=\"" << px(x1) << "\" y1=\"" << py(y1) << "\" x2=\""
+           << px(x2) << "\" y2=\"" << py(y2) << "\" stroke=\"" << color
+           << "\" stroke-width=\"2\"/>\n"
+           << "<text x=\"" << px(x2) - 5 << "\" y=\"" << py(y2) - 5
+           << "\" text-anchor=\"end\" fill=\"" << color << "\">"
+           << escapeXml(roof.name) << "</text>\n";
+    }
+
+    // Basic blocks, if they can be placed on the plot
+
+    for (const auto& block : blocks) {
+        if (block.intensity < x_lo || block.intensity > x_hi ||
+            block.flops_s < y_lo || block.flops_s > y_hi) {
+            continue;
+        }
+
+        ss << "<circle cx=\"" << px(block.intensity) << "\" cy=\""
+           << py(block.flops_s) << "\" r=\"3\" fill=\"#2ca02c\">"
+           << "<title>bblock " << block.id << "</title></circle>\n";
+    }
+
+    // Kernel
+
+    if (intensity > 0. && flops_s > 0.) {
+        ss << "<circle cx=\"" << px(intensity) << "\" cy=\"" << py(flops_s)
+           << "\" r=\"5\" fill=\"black\"/>\n"
+           << "<text x=\"" << px(intensity) + 8 << "\" y=\""
+           << py(flops_s) + 4 << "\">" << escapeXml(kernel) << "</text>\n";
+    }
+
+    ss << "</svg>\n";
+
+    return ss.str();
+}
+
+} // namespace hip
@@ -0,0 +1,91 @@
+/** \file signatures.cpp
+ * \brief Control-path signatures : deduplication of the per-thread counter
+ * vectors within a workgroup
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/signatures.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace hip {
+
+SignatureTrace deduplicateSignatures(const uint8_t* counters,
+                                     uint32_t total_blocks,
+                                     uint32_t threads_per_block,
+                                     uint32_t bb_count) {
+    SignatureTrace trace;
+    trace.offsets.reserve(total_blocks + 1);
+    trace.thread_signatures.reserve(total_blocks * threads_per_block);
+    trace.offsets.emplace_back(0u);
+
+    // Hash -> signatures with this hash, in the current workgroup
+    std::unordered_multimap<uint32_t, signature_index_t> known;
+
+    for (auto block = 0u; block < total_blocks; ++block) {
+        known.clear();
+        signature_index_t unique = 0u;
+
+        // End of the dictionary, incremented for every new signature
+        trace.offsets.emplace_back(trace.offsets.back());
+
+        for (auto thread = 0u; thread < threads_per_block; ++thread) {
+            auto thread_counters =
+                &counters[(block * threads_per_block + thread) * bb_count];
+            auto hash = hashCounters(thread_counters, bb_count);
+
+            // Look for an identical signature, the hash might collide
+            auto [begin, end] = known.equal_range(hash);
+            auto match = std::find_if(begin, end, [&](const auto& candidate) {
+                return std::memcmp(
+                           trace.signature(block, candidate.second, bb_count),
+                           thread_counters, bb_count) == 0;
+            });
+
+            if (match != end) {
+                trace.thread_signatures.emplace_back(match->second);
+            } else {
+                trace.dictionary.insert(trace.dictionary.end(),
+                                        thread_counters,
+                                        thread_counters + bb_count);
+                known.emplace(hash, unique);
+                trace.thread_signatures.emplace_back(unique);
+                ++unique;
+                ++trace.offsets.back();
+            }
+        }
+    }
+
+    return trace;
+}
+
+void expandSignatures(const SignatureTrace& trace, uint32_t threads_per_block,
+                      uint32_t bb_count, uint8_t* output) {
+    auto total_blocks = static_cast<uint32_t>(trace.offsets.size() - 1);
+
+    if (trace.thread_signatures.size() != total_blocks * threads_per_block) {
+        throw std::runtime_error("hip::expandSignatures() : Incompatible "
+                                 "geometry for the signature trace");
+    }
+
+    for (auto block = 0u; block < total_blocks; ++block) {
+        for (auto thread = 0u; thread < threads_per_block; ++thread) {
+            auto id = block * threads_per_block + thread;
+            auto index = trace.thread_signatures[id];
+
+            if (index >= trace.signatureCount(block)) {
+                throw std::runtime_error(
+                    "hip::expandSignatures() : Signature index out of bounds");
+            }
+
+            auto signature = trace.signature(block, index, bb_count);
+            std::copy(signature, signature + bb_count, &output[id * bb_count]);
+        }
+    }
+}
+
+} // namespace hip
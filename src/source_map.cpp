@@ -0,0 +1,148 @@
+/** \file source_map.cpp
+ * \brief Maps the basic blocks back to the source lines
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/source_map.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+namespace hip {
+
+std::optional<SourceLocation>
+SourceLocation::parse(const std::string& location) {
+    // Drop the trailing information, e.g. " <Spelling=...>". The path itself
+    // may contain spaces
+    std::string_view loc(location);
+    auto suffix = loc.rfind(" <");
+    if (suffix != std::string_view::npos && loc.back() == '>') {
+        loc = loc.substr(0, suffix);
+    }
+
+    auto col_sep = loc.rfind(':');
+    if (col_sep == std::string_view::npos || col_sep == 0u) {
+        return std::nullopt;
+    }
+
+    auto line_sep = loc.rfind(':', col_sep - 1);
+    if (line_sep == std::string_view::npos || line_sep == 0u) {
+        return std::nullopt;
+    }
+
+    SourceLocation ret;
+    ret.file = loc.substr(0, line_sep);
+
+    auto parse_uint = [](std::string_view str, uint32_t& value) {
+        auto [ptr, err] =
+            std::from_chars(str.data(), str.data() + str.size(), value);
+        return err == std::errc() && ptr == str.data() + str.size();
+    };
+
+    if (!parse_uint(loc.substr(line_sep + 1, col_sep - line_sep - 1),
+                    ret.line) ||
+        !parse_uint(loc.substr(col_sep + 1), ret.column)) {
+        return std::nullopt;
+    }
+
+    return ret;
+}
+
+SourceMap::SourceMap(const std::vector<BasicBlock>& blocks) {
+    uint32_t bb_count = 0u;
+    for (const auto& block : blocks) {
+        bb_count = std::max(bb_count, block.id + 1);
+    }
+    table = DeviceBlockInfo::table(blocks, bb_count);
+
+    struct Interval {
+        uint32_t first, last, block;
+    };
+
+    std::map<std::string, std::vector<Interval>> intervals;
+
+    for (const auto& block : blocks) {
+        auto begin = SourceLocation::parse(*block.begin_loc);
+        auto end = SourceLocation::parse(*block.end_loc);
+
+        if (!begin || !end || begin->file != end->file ||
+            end->line < begin->line) {
+            continue;
+        }
+
+        intervals[begin->file].push_back({begin->line, end->line, block.id});
+    }
+
+    for (auto& [file, file_intervals] : intervals) {
+        auto& file_map = file_maps[file];
+
+        uint32_t last_line = 0u;
+        for (const auto& interval : file_intervals) {
+            last_line = std::max(last_line, interval.last);
+            file_map.begins.emplace_back(interval.first, interval.block);
+        }
+
+        // Paint the longest intervals first, so the innermost blocks own the
+        // lines
+        std::stable_sort(file_intervals.begin(), file_intervals.end(),
+                         [](const auto& lhs, const auto& rhs) {
+                             return lhs.last - lhs.first > rhs.last - rhs.first;
+                         });
+
+        file_map.owners.assign(last_line + 1, no_block);
+        for (const auto& interval : file_intervals) {
+            std::fill(file_map.owners.begin() + interval.first,
+                      file_map.owners.begin() + interval.last + 1,
+                      interval.block);
+        }
+
+        std::sort(file_map.begins.begin(), file_map.begins.end());
+    }
+}
+
+std::vector<std::string> SourceMap::files() const {
+    std::vector<std::string> ret;
+    for (const auto& [file, file_map] : file_maps) {
+        ret.push_back(file);
+    }
+    return ret;
+}
+
+uint32_t SourceMap::blockAt(const std::string& file, uint32_t line) const {
+    auto it = file_maps.find(file);
+    if (it == file_maps.end() || line >= it->second.owners.size()) {
+        return no_block;
+    }
+
+    return it->second.owners[line];
+}
+
+std::vector<LineStats>
+SourceMap::lineStats(const std::string& file,
+                     const std::vector<uint64_t>& counts) const {
+    auto it = file_maps.find(file);
+    if (it == file_maps.end()) {
+        return {};
+    }
+
+    const auto& file_map = it->second;
+    std::vector<LineStats> stats(file_map.owners.size());
+
+    for (auto line = 0u; line < file_map.owners.size(); ++line) {
+        auto block = file_map.owners[line];
+        if (block != no_block && block < counts.size()) {
+            stats[line].executions = counts[block];
+        }
+    }
+
+    for (auto [line, block] : file_map.begins) {
+        if (block < counts.size() && block < table.size()) {
+            stats[line].flops += counts[block] * table[block].flops;
+        }
+    }
+
+    return stats;
+}
+
+} // namespace hip
@@ -0,0 +1,136 @@
+/** \file streaming.cpp
+ * \brief Out-of-core analysis of dense traces
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/streaming.hpp"
+#include "hip_instrumentation/cpu_reductions.hpp"
+
+#include <algorithm>
+#include <future>
+#include <stdexcept>
+
+namespace hip {
+
+StreamingAnalysis::StreamingAnalysis(TraceChunkReader& reader,
+                                     uint32_t threads_per_block,
+                                     uint32_t bb_count, size_t chunk_size)
+    : reader(reader), threads_per_block(threads_per_block),
+      bb_count(bb_count) {
+    auto workgroup_size = static_cast<size_t>(threads_per_block) * bb_count;
+    if (workgroup_size == 0u) {
+        throw std::runtime_error(
+            "hip::StreamingAnalysis::StreamingAnalysis() : Empty workgroups");
+    }
+
+    chunk_workgroups = static_cast<uint32_t>(
+        std::max<size_t>(chunk_size / workgroup_size, 1u));
+}
+
+void StreamingAnalysis::run() {
+    auto workgroup_size = static_cast<size_t>(threads_per_block) * bb_count;
+
+    if (reader.size() % workgroup_size != 0u ||
+        reader.position() % workgroup_size != 0u) {
+        throw std::runtime_error("hip::StreamingAnalysis::run() : Trace not "
+                                 "made of whole workgroups");
+    }
+
+    std::array<std::vector<uint8_t>, 2> buffers;
+    for (auto& buffer : buffers) {
+        buffer.resize(chunk_workgroups * workgroup_size);
+    }
+
+    auto read = [&](unsigned int b) {
+        return reader.read(buffers[b].data(), buffers[b].size());
+    };
+
+    auto first_workgroup =
+        static_cast<uint32_t>(reader.position() / workgroup_size);
+    auto current = 0u;
+
+    // Declared after the buffers : the destructor waits for a pending read,
+    // before the buffers are released
+    auto pending = std::async(std::launch::async, read, current);
+
+    while (true) {
+        auto size = pending.get();
+        if (size == 0u) {
+            break;
+        }
+
+        // Read the next chunk while this one is being reduced
+        pending = std::async(std::launch::async, read, current ^ 1u);
+
+        TraceChunk chunk{buffers[current].data(), first_workgroup,
+                         static_cast<uint32_t>(size / workgroup_size), size};
+
+        for (auto* reducer : reducers) {
+            reducer->reduce(chunk);
+        }
+
+        first_workgroup += chunk.workgroups;
+        current ^= 1u;
+    }
+}
+
+// ----- Reducers ----- //
+
+void CountReducer::reduce(const TraceChunk& chunk) {
+    auto counts = cpu::reduceCounts(chunk.counters, chunk.size, bb_count,
+                                    threads);
+
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        totals[bb] += counts[bb];
+    }
+}
+
+void HistogramReducer::reduce(const TraceChunk& chunk) {
+    auto bb_count = histograms.size();
+
+    for (size_t row = 0u; row < chunk.size; row += bb_count) {
+        auto counters = &chunk.counters[row];
+
+        for (size_t bb = 0u; bb < bb_count; ++bb) {
+            ++histograms[bb][counters[bb]];
+        }
+    }
+}
+
+DivergenceReducer::DivergenceReducer(uint32_t threads_per_block,
+                                     uint32_t bb_count, uint32_t wave_size,
+                                     size_t kept_waves, unsigned int threads)
+    : threads_per_block(threads_per_block), bb_count(bb_count),
+      wave_size(wave_size), kept_waves(kept_waves), threads(threads) {
+    divergence.blocks.resize(bb_count);
+}
+
+void DivergenceReducer::reduce(const TraceChunk& chunk) {
+    auto partial =
+        analyzeDivergence(chunk.counters, chunk.workgroups, threads_per_block,
+                          bb_count, wave_size, threads);
+
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        divergence.blocks[bb].merge(partial.blocks[bb]);
+    }
+    divergence.total.merge(partial.total);
+
+    // Keep the worst waves of the chunk, then the worst overall
+    for (auto i : partial.worstWaves(kept_waves)) {
+        auto wave = partial.waves[i];
+        wave.workgroup += chunk.first_workgroup;
+        divergence.waves.emplace_back(wave);
+    }
+
+    std::stable_sort(divergence.waves.begin(), divergence.waves.end(),
+                     [](const auto& lhs, const auto& rhs) {
+                         return lhs.wastedSlots() > rhs.wastedSlots();
+                     });
+
+    if (divergence.waves.size() > kept_waves) {
+        divergence.waves.resize(kept_waves);
+    }
+}
+
+} // namespace hip
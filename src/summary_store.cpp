@@ -0,0 +1,341 @@
+/** \file summary_store.cpp
+ * \brief Time series of per-launch summaries
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/summary_store.hpp"
+#include "hip_instrumentation/signatures.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hip {
+
+namespace summary {
+
+uint32_t kernelId(const std::string& kernel_name) {
+    return hashCounters(reinterpret_cast<const uint8_t*>(kernel_name.data()),
+                        kernel_name.size());
+}
+
+} // namespace summary
+
+namespace {
+
+void readAt(int fd, void* buffer, size_t size, size_t offset,
+            const std::string& filename) {
+    if (::pread(fd, buffer, size, offset) != static_cast<ssize_t>(size)) {
+        throw std::runtime_error(
+            "hip::SummaryWriter::SummaryWriter() : Could not read " + filename);
+    }
+}
+
+} // namespace
+
+// ----- SummaryWriter ----- //
+
+SummaryWriter::SummaryWriter(const std::string& file, uint32_t bb,
+                             uint32_t rows_per_group_in)
+    : filename(file), bb_count(bb),
+      rows_per_group(summary::roundRows(rows_per_group_in)),
+      layout(bb, rows_per_group) {
+    fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(
+            "hip::SummaryWriter::SummaryWriter() : Could not open " +
+            filename + " : " + std::strerror(errno));
+    }
+
+    struct stat st;
+    ::fstat(fd, &st);
+    auto file_size = static_cast<size_t>(st.st_size);
+
+    if (file_size == 0u) {
+        summary::FileHeader header;
+        std::memcpy(header.magic, summary::magic, sizeof(header.magic));
+        header.bb_count = bb_count;
+        header.rows_per_group = rows_per_group;
+
+        if (::pwrite(fd, &header, sizeof(header), 0) !=
+            static_cast<ssize_t>(sizeof(header))) {
+            ::close(fd);
+            throw std::runtime_error(
+                "hip::SummaryWriter::SummaryWriter() : Could not write " +
+                filename);
+        }
+
+        resetGroup();
+        return;
+    }
+
+    // Existing store : resume after the last complete group
+
+    try {
+        summary::FileHeader header;
+        readAt(fd, &header, sizeof(header), 0u, filename);
+
+        if (std::memcmp(header.magic, summary::magic, sizeof(header.magic)) !=
+                0 ||
+            header.bb_count != bb_count) {
+            throw std::runtime_error(
+                "hip::SummaryWriter::SummaryWriter() : Incompatible store " +
+                filename);
+        }
+
+        rows_per_group = header.rows_per_group;
+        layout = summary::GroupLayout(bb_count, rows_per_group);
+
+        auto groups = (file_size - sizeof(header)) / layout.size;
+        resetGroup();
+
+        if (groups > 0u) {
+            // Reload the last group if it is partial, to keep filling it
+            std::vector<uint8_t> last(layout.size);
+            readAt(fd, last.data(), layout.size,
+                   sizeof(header) + (groups - 1) * layout.size, filename);
+
+            auto last_rows =
+                reinterpret_cast<summary::GroupHeader*>(last.data())->rows;
+
+            if (last_rows < rows_per_group) {
+                group = std::move(last);
+                rows = last_rows;
+                full_groups = groups - 1;
+            } else {
+                full_groups = groups;
+            }
+        }
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+SummaryWriter::~SummaryWriter() {
+    // Can't throw in a destructor
+    try {
+        flush();
+    } catch (...) {
+    }
+
+    ::close(fd);
+}
+
+void SummaryWriter::resetGroup() {
+    group.assign(layout.size, 0u);
+
+    auto& header = groupHeader();
+    header.min_stamp = std::numeric_limits<uint64_t>::max();
+    header.max_stamp = 0u;
+    rows = 0u;
+}
+
+void SummaryWriter::append(uint32_t kernel_id, uint64_t stamp_begin,
+                           uint64_t stamp_end, const uint64_t* totals) {
+    auto& header = groupHeader();
+    header.min_stamp = std::min(header.min_stamp, stamp_begin);
+    header.max_stamp = std::max(header.max_stamp, stamp_end);
+
+    column<uint64_t>(layout.begin_stamps)[rows] = stamp_begin;
+    column<uint64_t>(layout.end_stamps)[rows] = stamp_end;
+    column<uint32_t>(layout.kernel_ids)[rows] = kernel_id;
+
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        column<uint64_t>(layout.blockTotals(bb))[rows] = totals[bb];
+    }
+
+    ++rows;
+
+    if (rows == rows_per_group) {
+        flush();
+        ++full_groups;
+        resetGroup();
+    }
+}
+
+void SummaryWriter::flush() {
+    if (rows == 0u) {
+        return;
+    }
+
+    groupHeader().rows = rows;
+
+    auto offset = sizeof(summary::FileHeader) + full_groups * layout.size;
+    if (::pwrite(fd, group.data(), group.size(), offset) !=
+        static_cast<ssize_t>(group.size())) {
+        throw std::runtime_error(
+            "hip::SummaryWriter::flush() : Could not write to " + filename);
+    }
+}
+
+// ----- SummaryReader ----- //
+
+SummaryReader::SummaryReader(const std::string& filename)
+    : layout(0u, 0u) {
+    auto fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(
+            "hip::SummaryReader::SummaryReader() : Could not open " +
+            filename + " : " + std::strerror(errno));
+    }
+
+    struct stat st;
+    ::fstat(fd, &st);
+    mapping_size = static_cast<size_t>(st.st_size);
+
+    if (mapping_size < sizeof(summary::FileHeader)) {
+        ::close(fd);
+        throw std::runtime_error(
+            "hip::SummaryReader::SummaryReader() : Truncated store " +
+            filename);
+    }
+
+    auto ptr = ::mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping remains valid
+
+    if (ptr == MAP_FAILED) {
+        throw std::runtime_error(
+            "hip::SummaryReader::SummaryReader() : Could not map " + filename);
+    }
+    mapping = static_cast<const uint8_t*>(ptr);
+
+    const auto& header = *reinterpret_cast<const summary::FileHeader*>(mapping);
+    if (std::memcmp(header.magic, summary::magic, sizeof(header.magic)) != 0 ||
+        header.rows_per_group == 0u ||
+        header.rows_per_group != summary::roundRows(header.rows_per_group)) {
+        ::munmap(const_cast<uint8_t*>(mapping), mapping_size);
+        throw std::runtime_error(
+            "hip::SummaryReader::SummaryReader() : Not a summary store " +
+            filename);
+    }
+
+    bb_count = header.bb_count;
+    layout = summary::GroupLayout(bb_count, header.rows_per_group);
+
+    // A partially written group at the end is ignored
+    groups = (mapping_size - sizeof(summary::FileHeader)) / layout.size;
+    for (auto g = 0u; g < groups; ++g) {
+        records += groupHeader(g).rows;
+    }
+}
+
+SummaryReader::~SummaryReader() {
+    ::munmap(const_cast<uint8_t*>(mapping), mapping_size);
+}
+
+LaunchSummary SummaryReader::row(size_t g, uint32_t r) const {
+    LaunchSummary ret;
+    ret.kernel_id = column<uint32_t>(g, layout.kernel_ids)[r];
+    ret.stamp_begin = column<uint64_t>(g, layout.begin_stamps)[r];
+    ret.stamp_end = column<uint64_t>(g, layout.end_stamps)[r];
+
+    ret.totals.resize(bb_count);
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        ret.totals[bb] = column<uint64_t>(g, layout.blockTotals(bb))[r];
+    }
+
+    return ret;
+}
+
+LaunchSummary SummaryReader::at(size_t i) const {
+    // Every group but the last one is full
+    auto g = i / layout.rows;
+    auto r = static_cast<uint32_t>(i % layout.rows);
+
+    if (g >= groups || r >= groupHeader(g).rows) {
+        throw std::runtime_error("hip::SummaryReader::at() : Out of bounds");
+    }
+
+    return row(g, r);
+}
+
+template <typename Func>
+void SummaryReader::forEachRow(uint64_t begin, uint64_t end,
+                               Func&& func) const {
+    for (auto g = 0u; g < groups; ++g) {
+        const auto& header = groupHeader(g);
+
+        // Sparse index : every launch of the group began in [min, max]
+        if (header.rows == 0u || header.min_stamp >= end ||
+            header.max_stamp < begin) {
+            continue;
+        }
+
+        auto stamps = column<uint64_t>(g, layout.begin_stamps);
+        for (auto r = 0u; r < header.rows; ++r) {
+            if (stamps[r] >= begin && stamps[r] < end) {
+                func(g, r);
+            }
+        }
+    }
+}
+
+std::vector<LaunchSummary> SummaryReader::range(uint64_t begin,
+                                                uint64_t end) const {
+    std::vector<LaunchSummary> ret;
+    forEachRow(begin, end,
+               [&](size_t g, uint32_t r) { ret.emplace_back(row(g, r)); });
+
+    return ret;
+}
+
+std::vector<SummaryBucket> SummaryReader::downsample(uint64_t begin,
+                                                     uint64_t end,
+                                                     size_t buckets) const {
+    if (buckets == 0u || end <= begin) {
+        throw std::runtime_error(
+            "hip::SummaryReader::downsample() : Empty range");
+    }
+
+    auto width = (end - begin + buckets - 1) / buckets;
+
+    std::vector<SummaryBucket> ret(buckets);
+    for (auto i = 0u; i < buckets; ++i) {
+        ret[i].begin = begin + i * width;
+        ret[i].end = std::min(end, ret[i].begin + width);
+        ret[i].launches = 0u;
+        ret[i].duration = 0u;
+        ret[i].totals.assign(bb_count, 0u);
+    }
+
+    forEachRow(begin, end, [&](size_t g, uint32_t r) {
+        auto stamp_begin = column<uint64_t>(g, layout.begin_stamps)[r];
+        auto stamp_end = column<uint64_t>(g, layout.end_stamps)[r];
+        auto& bucket = ret[(stamp_begin - begin) / width];
+
+        ++bucket.launches;
+        bucket.duration += stamp_end > stamp_begin ? stamp_end - stamp_begin
+                                                   : 0u;
+
+        for (auto bb = 0u; bb < bb_count; ++bb) {
+            bucket.totals[bb] += column<uint64_t>(g, layout.blockTotals(bb))[r];
+        }
+    });
+
+    return ret;
+}
+
+std::pair<uint64_t, uint64_t> SummaryReader::stampRange() const {
+    auto min = std::numeric_limits<uint64_t>::max();
+    uint64_t max = 0u;
+
+    for (auto g = 0u; g < groups; ++g) {
+        const auto& header = groupHeader(g);
+        if (header.rows) {
+            min = std::min(min, header.min_stamp);
+            max = std::max(max, header.max_stamp);
+        }
+    }
+
+    return {records ? min : 0u, max};
+}
+
+} // namespace hip
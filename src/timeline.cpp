@@ -0,0 +1,244 @@
+/** \file timeline.cpp
+ * \brief Chrome trace event (JSON) export of the instrumented launches
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/timeline.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+
+#include <unistd.h>
+
+namespace hip {
+
+namespace {
+
+void appendEscaped(std::string& buffer, const std::string& str) {
+    for (auto c : str) {
+        switch (c) {
+        case '"':
+            buffer += "\\\"";
+            break;
+        case '\\':
+            buffer += "\\\\";
+            break;
+        case '\n':
+            buffer += "\\n";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) >= 0x20) {
+                buffer += c;
+            }
+        }
+    }
+}
+
+/** \fn appendStamp
+ * \brief Trace events are in microseconds, keep the ns as decimals
+ */
+void appendStamp(std::string& buffer, uint64_t stamp) {
+    auto ns = std::to_string(stamp % 1000u);
+
+    buffer += std::to_string(stamp / 1000u);
+    buffer += '.';
+    buffer.append(3 - ns.size(), '0');
+    buffer += ns;
+}
+
+} // namespace
+
+TimelineWriter::TimelineWriter(const std::string& file, size_t buffer_size)
+    : filename(file), out(file), capacity(buffer_size),
+      pid(static_cast<uint32_t>(::getpid())) {
+    if (!out.is_open()) {
+        throw std::runtime_error(
+            "hip::TimelineWriter::TimelineWriter() : Could not open file " +
+            filename);
+    }
+
+    buffer.reserve(capacity + 4096u);
+    buffer += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+}
+
+TimelineWriter::~TimelineWriter() {
+    // Can't throw in a destructor
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void TimelineWriter::beginEvent(const char* phase, const std::string& name,
+                                const std::string& category, uint64_t stamp) {
+    if (closed) {
+        throw std::runtime_error(
+            "hip::TimelineWriter::beginEvent() : Timeline already closed");
+    }
+
+    if (!first_event) {
+        buffer += ",\n";
+    }
+    first_event = false;
+
+    buffer += "{\"name\":\"";
+    appendEscaped(buffer, name);
+    buffer += "\",\"cat\":\"";
+    appendEscaped(buffer, category);
+    buffer += "\",\"ph\":\"";
+    buffer += phase;
+    buffer += "\",\"pid\":";
+    buffer += std::to_string(pid);
+    buffer += ",\"ts\":";
+    appendStamp(buffer, stamp);
+}
+
+void TimelineWriter::endEvent(const Args& args) {
+    if (!args.empty()) {
+        buffer += ",\"args\":{";
+        for (auto i = 0u; i < args.size(); ++i) {
+            if (i) {
+                buffer += ',';
+            }
+
+            buffer += '"';
+            appendEscaped(buffer, args[i].first);
+            buffer += "\":";
+            buffer += args[i].second;
+        }
+        buffer += '}';
+    }
+
+    buffer += '}';
+
+    if (buffer.size() >= capacity) {
+        writeBuffer();
+    }
+}
+
+void TimelineWriter::complete(const std::string& name,
+                              const std::string& category, uint64_t begin,
+                              uint64_t end, uint32_t tid, const Args& args) {
+    std::scoped_lock lock(mutex);
+
+    beginEvent("X", name, category, begin);
+    buffer += ",\"dur\":";
+    appendStamp(buffer, end > begin ? end - begin : 0u);
+    buffer += ",\"tid\":";
+    buffer += std::to_string(tid);
+    endEvent(args);
+}
+
+void TimelineWriter::async(const std::string& name,
+                           const std::string& category, uint64_t begin,
+                           uint64_t end, uint64_t id, const Args& args) {
+    std::scoped_lock lock(mutex);
+
+    auto id_str = std::to_string(id);
+
+    beginEvent("b", name, category, begin);
+    buffer += ",\"id\":" + id_str + ",\"tid\":0";
+    endEvent(args);
+
+    beginEvent("e", name, category, std::max(begin, end));
+    buffer += ",\"id\":" + id_str + ",\"tid\":0";
+    endEvent({});
+}
+
+void TimelineWriter::counter(
+    const std::string& name, uint64_t stamp,
+    const std::vector<std::pair<std::string, uint64_t>>& values) {
+    std::scoped_lock lock(mutex);
+
+    Args args;
+    args.reserve(values.size());
+    for (const auto& [key, value] : values) {
+        args.emplace_back(key, std::to_string(value));
+    }
+
+    beginEvent("C", name, "counter", stamp);
+    buffer += ",\"tid\":0";
+    endEvent(args);
+}
+
+void TimelineWriter::threadName(uint32_t tid, const std::string& name) {
+    std::scoped_lock lock(mutex);
+
+    beginEvent("M", "thread_name", "__metadata", 0u);
+    buffer += ",\"tid\":" + std::to_string(tid);
+    endEvent({{"name", quoted(name)}});
+}
+
+std::string TimelineWriter::quoted(const std::string& str) {
+    std::string ret = "\"";
+    appendEscaped(ret, str);
+    ret += '"';
+
+    return ret;
+}
+
+uint64_t TimelineWriter::nextId() {
+    std::scoped_lock lock(mutex);
+    return next_id++;
+}
+
+uint32_t TimelineWriter::hostThread() {
+    static std::atomic<uint32_t> next_thread{1u};
+    thread_local uint32_t tid = 0u;
+
+    if (tid == 0u) {
+        tid = next_thread++;
+        threadName(tid, "Host thread " + std::to_string(tid));
+    }
+
+    return tid;
+}
+
+void TimelineWriter::flush() {
+    std::scoped_lock lock(mutex);
+    writeBuffer();
+}
+
+void TimelineWriter::writeBuffer() {
+    out.write(buffer.data(), buffer.size());
+    out.flush();
+    buffer.clear();
+
+    if (!out) {
+        throw std::runtime_error(
+            "hip::TimelineWriter::flush() : Could not write to " + filename);
+    }
+}
+
+void TimelineWriter::close() {
+    std::scoped_lock lock(mutex);
+
+    if (closed) {
+        return;
+    }
+
+    buffer += "\n]}\n";
+    writeBuffer();
+    out.close();
+    closed = true;
+}
+
+TimelineWriter* TimelineWriter::global() {
+    // Destroyed (and closed) at exit
+    static std::unique_ptr<TimelineWriter> timeline = []() {
+        std::unique_ptr<TimelineWriter> ret;
+        if (const char* env = std::getenv(timeline_env_var)) {
+            ret = std::make_unique<TimelineWriter>(env);
+            ret->threadName(0u, "Kernels");
+        }
+        return ret;
+    }();
+
+    return timeline.get();
+}
+
+} // namespace hip
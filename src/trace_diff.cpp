@@ -0,0 +1,143 @@
+/** \file trace_diff.cpp
+ * \brief Differential comparison of two traces of the same kernel
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/trace_diff.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace hip {
+
+TraceDiff::TraceDiff(uint32_t bbs, uint32_t threads,
+                     const std::vector<BasicBlock>& blocks)
+    : bb_count(bbs), threads_per_block(threads), flops(bbs, 0u),
+      count_a(bbs, 0u), count_b(bbs, 0u), mean(bbs, 0.), m2(bbs, 0.),
+      deltas(bbs, 0) {
+    auto table = DeviceBlockInfo::table(blocks, bb_count);
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        flops[bb] = table[bb].flops;
+    }
+}
+
+void TraceDiff::addWorkgroups(const uint8_t* a, const uint8_t* b,
+                              size_t workgroups) {
+    auto workgroup_size = static_cast<size_t>(threads_per_block) * bb_count;
+
+    for (size_t wg = 0u; wg < workgroups; ++wg) {
+        auto wg_a = &a[wg * workgroup_size];
+        auto wg_b = &b[wg * workgroup_size];
+
+        std::fill(deltas.begin(), deltas.end(), 0);
+
+        // Widening subtraction, vectorized by the compiler
+        for (auto thread = 0u; thread < threads_per_block; ++thread) {
+            auto row_a = &wg_a[thread * bb_count];
+            auto row_b = &wg_b[thread * bb_count];
+
+            for (auto bb = 0u; bb < bb_count; ++bb) {
+                deltas[bb] += static_cast<int32_t>(row_b[bb]) -
+                              static_cast<int32_t>(row_a[bb]);
+            }
+
+            for (auto bb = 0u; bb < bb_count; ++bb) {
+                count_a[bb] += row_a[bb];
+                count_b[bb] += row_b[bb];
+            }
+        }
+
+        // Welford update with the workgroup as a sample
+
+        auto n = static_cast<double>(workgroup_flops.size() + 1);
+        int64_t wg_flops = 0;
+
+        for (auto bb = 0u; bb < bb_count; ++bb) {
+            auto x = static_cast<double>(deltas[bb]);
+            auto d = x - mean[bb];
+            mean[bb] += d / n;
+            m2[bb] += d * (x - mean[bb]);
+
+            wg_flops += static_cast<int64_t>(deltas[bb]) * flops[bb];
+        }
+
+        workgroup_flops.push_back(wg_flops);
+    }
+}
+
+std::vector<BlockDelta> TraceDiff::blocks() const {
+    std::vector<BlockDelta> ret(bb_count);
+    auto n = static_cast<double>(workgroup_flops.size());
+
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        auto& block = ret[bb];
+        block.id = bb;
+        block.count_a = count_a[bb];
+        block.count_b = count_b[bb];
+        block.mean = mean[bb];
+        block.stddev = n > 1. ? std::sqrt(m2[bb] / (n - 1.)) : 0.;
+        block.flops_delta = block.delta() * flops[bb];
+
+        if (block.mean == 0.) {
+            block.z = 0.;
+        } else if (block.stddev == 0.) {
+            block.z = std::copysign(std::numeric_limits<double>::infinity(),
+                                    block.mean);
+        } else {
+            block.z = block.mean / (block.stddev / std::sqrt(n));
+        }
+    }
+
+    return ret;
+}
+
+std::vector<BlockDelta> TraceDiff::significantBlocks(double z_threshold) const {
+    auto all = blocks();
+
+    std::vector<BlockDelta> ret;
+    std::copy_if(all.begin(), all.end(), std::back_inserter(ret),
+                 [&](const auto& block) {
+                     return block.delta() != 0 &&
+                            std::abs(block.z) >= z_threshold;
+                 });
+
+    std::stable_sort(ret.begin(), ret.end(), [](const auto& l, const auto& r) {
+        auto fl = std::abs(l.flops_delta), fr = std::abs(r.flops_delta);
+        if (fl != fr) {
+            return fl > fr;
+        }
+        return std::abs(l.delta()) > std::abs(r.delta());
+    });
+
+    return ret;
+}
+
+std::vector<WorkgroupDelta> TraceDiff::workgroups() const {
+    // Welford, as the sum of squares cancels catastrophically for large
+    // deltas with a small spread
+    double wg_mean = 0., wg_m2 = 0.;
+    for (auto wg = 0u; wg < workgroup_flops.size(); ++wg) {
+        auto x = static_cast<double>(workgroup_flops[wg]);
+        auto d = x - wg_mean;
+        wg_mean += d / (wg + 1u);
+        wg_m2 += d * (x - wg_mean);
+    }
+
+    auto n = static_cast<double>(workgroup_flops.size());
+    auto wg_stddev = n > 1. ? std::sqrt(wg_m2 / (n - 1.)) : 0.;
+
+    std::vector<WorkgroupDelta> ret;
+    ret.reserve(workgroup_flops.size());
+
+    for (auto wg = 0u; wg < workgroup_flops.size(); ++wg) {
+        auto z = wg_stddev > 0. ? (workgroup_flops[wg] - wg_mean) / wg_stddev
+                                : 0.;
+        ret.push_back({wg, workgroup_flops[wg], z});
+    }
+
+    return ret;
+}
+
+} // namespace hip
@@ -0,0 +1,98 @@
+/** \file trace_reader.cpp
+ * \brief Trace header parsing and chunked reading of dense traces
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/trace_reader.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace hip {
+
+TraceHeader TraceHeader::parse(const std::string& header) {
+    std::stringstream ss;
+    ss << header;
+
+    auto get_token = [&]() -> std::string {
+        std::string buf;
+        if (!std::getline(ss, buf, ',')) {
+            throw std::runtime_error("hip::TraceHeader::parse() : Could "
+                                     "not read token from header : " +
+                                     header);
+        }
+
+        return buf;
+    };
+
+    TraceHeader ret;
+
+    try {
+        ret.type = get_token();
+        ret.kernel = get_token();
+        ret.instr_size = std::stoul(get_token());
+        ret.stamp = std::stoull(get_token());
+        ret.stamp_begin = std::stoull(get_token());
+        ret.stamp_end = std::stoull(get_token());
+        ret.counter_size = std::stoul(get_token());
+
+        // Only the compressed formats have an entry count
+        std::string entries;
+        if (std::getline(ss, entries, ',')) {
+            ret.entries = std::stoul(entries);
+        } else {
+            ret.entries = ret.instr_size;
+        }
+    } catch (const std::logic_error& e) {
+        // std::invalid_argument, std::out_of_range from stoul
+        throw std::runtime_error(
+            "hip::TraceHeader::parse() : Malformed header : " + header);
+    }
+
+    return ret;
+}
+
+TraceChunkReader::TraceChunkReader(const std::string& file)
+    : filename(file), in(file, std::ios::binary) {
+    if (!in.is_open()) {
+        throw std::runtime_error(
+            "hip::TraceChunkReader::TraceChunkReader() : Could not open file " +
+            filename);
+    }
+
+    std::string buffer;
+    if (!std::getline(in, buffer)) {
+        throw std::runtime_error("hip::TraceChunkReader::TraceChunkReader() : "
+                                 "Could not read header " +
+                                 filename);
+    }
+
+    trace_header = TraceHeader::parse(buffer);
+
+    if (trace_header.type != hiptrace_name ||
+        trace_header.counter_size != sizeof(uint8_t)) {
+        throw std::runtime_error("hip::TraceChunkReader::TraceChunkReader() : "
+                                 "Not a dense trace : " +
+                                 filename);
+    }
+}
+
+size_t TraceChunkReader::read(uint8_t* buffer, size_t count) {
+    count = std::min(count, size() - pos);
+    if (count == 0u) {
+        return 0u;
+    }
+
+    in.read(reinterpret_cast<char*>(buffer), count);
+    if (static_cast<size_t>(in.gcount()) != count) {
+        throw std::runtime_error(
+            "hip::TraceChunkReader::read() : Truncated trace " + filename);
+    }
+
+    pos += count;
+    return count;
+}
+
+} // namespace hip
@@ -5,6 +5,7 @@
  */
 
 #include "hip_instrumentation/hip_instrumentation.hpp"
+#include "hip_instrumentation/intensity.hpp"
 
 #include "llvm/Support/CommandLine.h"
 
@@ -21,6 +22,10 @@ static llvm::cl::opt<std::string>
              llvm::cl::value_desc("database"),
              llvm::cl::init(hip::default_database));
 
+static llvm::cl::opt<bool>
+    per_block("b", llvm::cl::desc("Print the intensity of every basic block"),
+              llvm::cl::init(false));
+
 int main(int argc, char** argv) {
     llvm::cl::ParseCommandLineOptions(argc, argv);
 
@@ -38,20 +43,19 @@ int main(int argc, char** argv) {
     const auto& blocks = instrumenter.loadDatabase(database.getValue());
 
     // Compute AI
-    uint64_t total_flops = 0u;
-    uint64_t total_memory = 0u;
-
-    for (auto i = 0u; i < kernel_info.instr_size; ++i) {
-        auto bb = i % kernel_info.basic_blocks;
-        auto& block = blocks[bb];
-        total_flops += static_cast<uint64_t>(block.flops);
-        total_memory +=
-            static_cast<uint64_t>(block.floating_ld + block.floating_st);
+    const auto& counters = instrumenter.data();
+    auto ai = hip::arithmeticIntensity(counters.data(), counters.size(), blocks,
+                                       kernel_info.basic_blocks);
+
+    std::cout << "Kernel arithmetic intensity : " << ai.total.intensity()
+              << " FLOPs/byte (" << ai.total.flops << " FLOPs, "
+              << ai.total.bytes << " bytes)\n";
+
+    if (per_block.getValue()) {
+        for (auto bb = 0u; bb < ai.blocks.size(); ++bb) {
+            const auto& block = ai.blocks[bb];
+            std::cout << "  " << bb << " : " << block.intensity()
+                      << " FLOPs/byte, " << block.count << " executions\n";
+        }
     }
-
-    auto arithmetic_intensity =
-        static_cast<float>(total_flops) / static_cast<float>(total_memory);
-
-    std::cout << "Kernel arithmetic intensity : " << arithmetic_intensity
-              << " FLOPs/byte\n";
 }
@@ -0,0 +1,61 @@
+/** \file compaction.cpp
+ * \brief On-device counters compaction test case, compared to the host
+ * reference
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/hip_instrumentation.hpp"
+
+#include <iostream>
+#include <random>
+
+int main() {
+    hip::init();
+
+    // Unaligned geometry to exercise the partial tiles
+    hip::KernelInfo ki("compaction", 7, dim3(129), dim3(63));
+    hip::Instrumenter instrumenter(ki);
+
+    // Mostly zero counters, as in a real trace
+    std::vector<uint8_t> counters(ki.instr_size, 0u);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<unsigned int> dist(0u, 255u);
+
+    for (auto& c : counters) {
+        if (dist(gen) < 32u) {
+            c = static_cast<uint8_t>(dist(gen) | 1u);
+        }
+    }
+
+    uint8_t* device_counters;
+    hip::check(hipMalloc(&device_counters, counters.size()));
+    hip::check(hipMemcpy(device_counters, counters.data(), counters.size(),
+                         hipMemcpyHostToDevice));
+
+    instrumenter.fromDeviceSparse(device_counters);
+
+    hip::check(hipFree(device_counters));
+
+    // Compare with the host reference
+
+    auto reference = hip::compactCounters(counters.data(), counters.size());
+    const auto& sparse = instrumenter.sparseData();
+
+    std::cout << "Non-zero counters : " << sparse.size() << " / "
+              << counters.size() << '\n';
+
+    if (sparse.indices != reference.indices ||
+        sparse.counts != reference.counts) {
+        throw std::runtime_error("Sparse counters differ from the reference");
+    }
+
+    // Lazy expansion
+
+    if (instrumenter.data() != counters) {
+        throw std::runtime_error("Expanded counters differ from the original");
+    }
+
+    return 0;
+}
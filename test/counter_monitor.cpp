@@ -0,0 +1,109 @@
+/** \file counter_monitor.cpp
+ * \brief Live counters test case : emulates the periodic flushes of the
+ * instrumented kernel (see LiveInstrGenerator) and checks the snapshots of the
+ * monitor
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/counter_monitor.hpp"
+#include "hip_instrumentation/hip_utils.hpp"
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+int main() {
+    hip::init();
+
+    constexpr auto bb_count = 7u;
+    constexpr auto threads = 256u;
+    constexpr auto period = 16u;
+
+    std::mt19937 gen(42);
+    // Beyond 255 executions, to exercise the wrap-around of the counters
+    std::uniform_int_distribution<unsigned int> dist(0u, 1000u);
+
+    std::vector<uint64_t> expected(bb_count, 0u), live(bb_count, 0u),
+        flushed(bb_count, 0u);
+
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        for (auto t = 0u; t < threads; ++t) {
+            auto executions = dist(gen);
+            expected[bb] += executions;
+
+            // Generated block code : 8-bit counter, flush on every multiple
+            // of the period
+            uint8_t counter = 0u;
+            for (auto i = 0u; i < executions; ++i) {
+                ++counter;
+                if ((counter & (period - 1u)) == 0u) {
+                    live[bb] += period;
+                }
+            }
+
+            // Generated commit : flush the remainder
+            flushed[bb] = live[bb];
+            live[bb] += counter & (period - 1u);
+        }
+    }
+
+    using live_counter_t = hip::CounterMonitor::live_counter_t;
+    hip::CounterMonitor monitor(bb_count, std::chrono::microseconds(1000));
+
+    monitor.start();
+
+    // Periodic flushes only, then the commit
+    hip::check(hipMemcpy(monitor.devicePtr(), flushed.data(),
+                         bb_count * sizeof(live_counter_t),
+                         hipMemcpyHostToDevice));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    hip::check(hipMemcpy(monitor.devicePtr(), live.data(),
+                         bb_count * sizeof(live_counter_t),
+                         hipMemcpyHostToDevice));
+    hip::check(hipDeviceSynchronize());
+
+    monitor.stop();
+
+    auto snapshots = monitor.snapshots();
+    if (snapshots.size() < 2u) {
+        throw std::runtime_error("Expected several snapshots");
+    }
+
+    uint64_t last_elapsed = 0u;
+    for (const auto& snapshot : snapshots) {
+        if (snapshot.elapsed < last_elapsed) {
+            throw std::runtime_error("Snapshots are not ordered");
+        }
+        last_elapsed = snapshot.elapsed;
+
+        for (auto bb = 0u; bb < bb_count; ++bb) {
+            if (snapshot.totals[bb] > expected[bb]) {
+                throw std::runtime_error("Snapshot exceeds the real count");
+            }
+        }
+    }
+
+    auto final_snapshot = monitor.latest();
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        std::cout << bb << " : " << final_snapshot.totals[bb] << " / "
+                  << expected[bb] << '\n';
+    }
+
+    if (final_snapshot.totals != expected) {
+        throw std::runtime_error("Final snapshot differs from the real count");
+    }
+
+    // Restarting resets the counters and the history
+    monitor.start();
+    monitor.stop();
+
+    for (auto total : monitor.latest().totals) {
+        if (total != 0u) {
+            throw std::runtime_error("Counters were not reset");
+        }
+    }
+
+    return 0;
+}
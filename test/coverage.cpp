@@ -0,0 +1,50 @@
+/** \file coverage.cpp
+ * \brief Coverage bitmasks reductions test case
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/coverage.hpp"
+
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+int main() {
+    constexpr auto total_blocks = 16u;
+    constexpr auto threads = 96u; // Partial second wavefront
+    constexpr auto bb_count = 5u;
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<unsigned int> dist(0u, 3u);
+
+    std::vector<uint8_t> counters(total_blocks * threads * bb_count);
+    for (auto& c : counters) {
+        c = static_cast<uint8_t>(dist(gen));
+    }
+
+    auto coverage = hip::coverageFromCounters(counters.data(), total_blocks,
+                                              threads, bb_count);
+
+    // Reference : number of threads with a non-zero counter per bblock
+    std::vector<uint64_t> expected(bb_count, 0u);
+    for (auto i = 0u; i < counters.size(); ++i) {
+        expected[i % bb_count] += counters[i] != 0u;
+    }
+
+    if (hip::threadsPerBlock(coverage, bb_count) != expected) {
+        throw std::runtime_error("Unexpected per-block thread count");
+    }
+
+    auto lanes = hip::activeLanes(coverage);
+    auto total = std::accumulate(lanes.begin(), lanes.end(), 0ull);
+
+    std::cout << "Active (thread, bblock) pairs : " << total << '\n';
+
+    if (total != std::accumulate(expected.begin(), expected.end(), 0ull)) {
+        throw std::runtime_error("Unexpected active lanes count");
+    }
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+/** \file cpu_reductions.cpp
+ * \brief Multi-threaded host reduction test case, compared to a naive
+ * reduction
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/cpu_reductions.hpp"
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+int main() {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<unsigned int> dist(0u, 255u);
+
+    // Large enough to be split in several tasks, and not a multiple of the
+    // row width
+    std::vector<uint8_t> counters((1u << 24) + 4099u);
+    for (auto& c : counters) {
+        c = static_cast<uint8_t>(dist(gen));
+    }
+
+    for (auto bb_count : {1u, 3u, 13u, 64u, 100u, 1000u}) {
+        std::vector<hip::BasicBlock> blocks;
+        for (auto bb = 0u; bb < bb_count; ++bb) {
+            blocks.emplace_back(bb, bb, dist(gen), "", "");
+        }
+
+        auto usage = hip::cpu::reduceBlockUsage(counters.data(),
+                                                counters.size(), blocks,
+                                                bb_count);
+
+        std::vector<hip::BlockUsage> reference(bb_count, {0u, 0u});
+        for (auto i = 0u; i < counters.size(); ++i) {
+            reference[i % bb_count].count += counters[i];
+        }
+        for (auto bb = 0u; bb < bb_count; ++bb) {
+            reference[bb].flops = reference[bb].count * blocks[bb].flops;
+        }
+
+        std::cout << bb_count << " basic blocks : "
+                  << (usage == reference ? "ok" : "mismatch") << '\n';
+
+        if (usage != reference) {
+            throw std::runtime_error("Block usage differs from the reference");
+        }
+    }
+
+    return 0;
+}
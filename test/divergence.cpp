@@ -0,0 +1,92 @@
+/** \file divergence.cpp
+ * \brief Wavefront divergence report of a trace
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/divergence.hpp"
+#include "hip_instrumentation/hip_instrumentation.hpp"
+
+#include <iomanip>
+#include <iostream>
+
+#include "llvm/Support/CommandLine.h"
+
+static llvm::cl::opt<std::string>
+    kernel_geometry("k", llvm::cl::desc("Kernel launch geometry"),
+                    llvm::cl::value_desc("kernel_info"), llvm::cl::Required);
+
+static llvm::cl::opt<std::string> hiptrace("t", llvm::cl::desc("Hiptrace file"),
+                                           llvm::cl::value_desc("hiptrace"),
+                                           llvm::cl::Required);
+
+static llvm::cl::opt<std::string>
+    database("d", llvm::cl::desc("Hip-analyzer database"),
+             llvm::cl::value_desc("database"),
+             llvm::cl::init(hip::default_database));
+
+static llvm::cl::opt<unsigned int>
+    top("n", llvm::cl::desc("Number of basic blocks and wavefronts to report"),
+        llvm::cl::value_desc("count"), llvm::cl::init(10u));
+
+static llvm::cl::opt<unsigned int>
+    jobs("j", llvm::cl::desc("Analysis threads (0 : all hardware threads)"),
+         llvm::cl::value_desc("threads"), llvm::cl::init(0u));
+
+int main(int argc, char** argv) {
+    llvm::cl::ParseCommandLineOptions(argc, argv);
+
+    auto kernel_info = hip::KernelInfo::fromJson(kernel_geometry.getValue());
+    kernel_info.dump();
+
+    hip::Instrumenter instrumenter(kernel_info);
+    instrumenter.loadBin(hiptrace.getValue());
+
+    const auto& blocks = instrumenter.loadDatabase(database.getValue());
+    auto normalized = hip::BasicBlock::normalized(blocks);
+
+    auto report = hip::analyzeDivergence(
+        instrumenter.data().data(), kernel_info.total_blocks,
+        kernel_info.total_threads_per_blocks, kernel_info.basic_blocks,
+        kernel_info.wave_size, jobs.getValue());
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "Kernel SIMD efficiency : " << report.total.efficiency()
+              << ", active lanes : " << report.total.activeFraction()
+              << ", wasted lane slots : " << report.total.wastedSlots()
+              << "\n\nWorst basic blocks :\n";
+
+    for (auto bb : report.worstBlocks(top.getValue())) {
+        const auto& block = report.blocks[bb];
+        if (block.wastedSlots() == 0u) {
+            break;
+        }
+
+        std::cout << "  " << bb << " : efficiency " << block.efficiency()
+                  << ", active lanes " << block.activeFraction()
+                  << ", divergent waves " << block.divergent_waves << " / "
+                  << block.executed_waves << ", distinct counts "
+                  << static_cast<double>(block.distinct_counts) /
+                         block.executed_waves
+                  << ", wasted " << block.wastedSlots() << '\n';
+
+        if (bb < normalized.size()) {
+            std::cout << "      " << *normalized[bb].begin_loc << " -> "
+                      << *normalized[bb].end_loc << '\n';
+        }
+    }
+
+    std::cout << "\nWorst wavefronts :\n";
+
+    for (auto i : report.worstWaves(top.getValue())) {
+        const auto& wave = report.waves[i];
+        if (wave.wastedSlots() == 0u) {
+            break;
+        }
+
+        std::cout << "  block " << wave.workgroup << ", wave " << wave.wave
+                  << " : efficiency " << wave.efficiency() << ", paths "
+                  << wave.distinct_vectors << " / " << wave.lanes
+                  << ", wasted " << wave.wastedSlots() << '\n';
+    }
+}
@@ -0,0 +1,71 @@
+/** \file edge_counts.cpp
+ * \brief Edge count inference test case, with edges to the exit of the kernel
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/pgo.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+const hip::EdgeCount& findEdge(const std::vector<hip::EdgeCount>& edges,
+                               uint32_t from, uint32_t to) {
+    for (const auto& edge : edges) {
+        if (edge.from == from && edge.to == to) {
+            return edge;
+        }
+    }
+
+    throw std::runtime_error("Missing edge");
+}
+
+void expect(const hip::EdgeCount& edge, uint64_t count) {
+    std::cout << edge.from << " -> " << edge.to << " : " << edge.count
+              << (edge.exact ? " (exact)\n" : " (estimated)\n");
+
+    if (edge.count != count || !edge.exact) {
+        throw std::runtime_error("Unexpected edge count");
+    }
+}
+
+} // namespace
+
+int main() {
+    constexpr auto exit = hip::BasicBlock::exit_block;
+
+    // if (tid < n) { ... } : 0 -> 1 -> exit, 0 -> exit
+    {
+        std::vector<hip::BasicBlock> blocks;
+        blocks.emplace_back(0u, 0u, 0u, "", "");
+        blocks.emplace_back(1u, 1u, 0u, "", "");
+        blocks[0].successors = {1u, exit};
+        blocks[1].successors = {exit};
+
+        auto edges = hip::inferEdgeCounts(blocks, {100u, 60u});
+
+        expect(findEdge(edges, 0u, 1u), 60u);
+        expect(findEdge(edges, 0u, exit), 40u);
+        expect(findEdge(edges, 1u, exit), 60u);
+    }
+
+    // The kernel starts with a loop, whose header is block 0 and has a
+    // predecessor : while (c) { ... } with 10 iterations per thread
+    {
+        std::vector<hip::BasicBlock> blocks;
+        blocks.emplace_back(0u, 0u, 0u, "", "");
+        blocks.emplace_back(1u, 1u, 0u, "", "");
+        blocks[0].successors = {1u, exit};
+        blocks[1].successors = {0u};
+
+        auto edges = hip::inferEdgeCounts(blocks, {110u, 100u});
+
+        expect(findEdge(edges, 1u, 0u), 100u);
+        expect(findEdge(edges, 0u, 1u), 100u);
+        expect(findEdge(edges, 0u, exit), 10u);
+    }
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+/** \file equivalence.cpp
+ * \brief Thread equivalence class report of a trace
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/equivalence.hpp"
+#include "hip_instrumentation/hip_instrumentation.hpp"
+
+#include <iomanip>
+#include <iostream>
+
+#include "llvm/Support/CommandLine.h"
+
+static llvm::cl::opt<std::string>
+    kernel_geometry("k", llvm::cl::desc("Kernel launch geometry"),
+                    llvm::cl::value_desc("kernel_info"), llvm::cl::Required);
+
+static llvm::cl::opt<std::string> hiptrace("t", llvm::cl::desc("Hiptrace file"),
+                                           llvm::cl::value_desc("hiptrace"),
+                                           llvm::cl::Required);
+
+static llvm::cl::opt<std::string>
+    database("d", llvm::cl::desc("Hip-analyzer database"),
+             llvm::cl::value_desc("database"),
+             llvm::cl::init(hip::default_database));
+
+static llvm::cl::opt<unsigned int>
+    top("n", llvm::cl::desc("Number of basic blocks and workgroups to report"),
+        llvm::cl::value_desc("count"), llvm::cl::init(10u));
+
+static llvm::cl::opt<unsigned int>
+    jobs("j", llvm::cl::desc("Analysis threads (0 : all hardware threads)"),
+         llvm::cl::value_desc("threads"), llvm::cl::init(0u));
+
+void printStats(const std::string& name, const hip::EquivalenceStats& stats) {
+    std::cout << name << " : " << stats.groups << ", classes per group "
+              << stats.meanClasses() << " (max " << stats.max_classes
+              << "), threads per class " << stats.meanClassSize()
+              << ", threads on the majority path " << stats.majorityFraction()
+              << ", uniform " << stats.uniformGroups() << '\n';
+
+    std::cout << "  groups by classes :";
+    for (auto i = 1u; i < stats.histogram.size(); ++i) {
+        if (stats.histogram[i]) {
+            std::cout << ' ' << i
+                      << (i + 1u == stats.histogram.size() ? "+" : "") << 'x'
+                      << stats.histogram[i];
+        }
+    }
+    std::cout << '\n';
+}
+
+int main(int argc, char** argv) {
+    llvm::cl::ParseCommandLineOptions(argc, argv);
+
+    auto kernel_info = hip::KernelInfo::fromJson(kernel_geometry.getValue());
+    kernel_info.dump();
+
+    hip::Instrumenter instrumenter(kernel_info);
+    instrumenter.loadBin(hiptrace.getValue());
+
+    const auto& blocks = instrumenter.loadDatabase(database.getValue());
+    auto normalized = hip::BasicBlock::normalized(blocks);
+
+    auto report = hip::analyzeEquivalence(
+        instrumenter.data().data(), kernel_info.total_blocks,
+        kernel_info.total_threads_per_blocks, kernel_info.basic_blocks,
+        kernel_info.wave_size, jobs.getValue());
+
+    std::cout << std::fixed << std::setprecision(3);
+    printStats("Wavefronts", report.waves);
+    printStats("Workgroups", report.workgroups);
+
+    std::cout << "\nBasic blocks splitting the most wavefronts :\n";
+
+    for (auto bb : report.distinguishingBlocks(top.getValue())) {
+        auto waves = report.waves.distinguishing[bb];
+        if (waves == 0u) {
+            break;
+        }
+
+        std::cout << "  " << bb << " : " << waves << " wavefronts, "
+                  << report.workgroups.distinguishing[bb] << " workgroups\n";
+
+        if (bb < normalized.size()) {
+            std::cout << "      " << *normalized[bb].begin_loc << " -> "
+                      << *normalized[bb].end_loc << '\n';
+        }
+    }
+
+    std::cout << "\nWorkgroups with the most classes :\n";
+
+    for (auto workgroup : report.worstWorkgroups(top.getValue())) {
+        std::cout << "  " << workgroup << " : "
+                  << report.workgroup_classes[workgroup] << " classes\n";
+    }
+}
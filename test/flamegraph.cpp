@@ -0,0 +1,83 @@
+/** \file flamegraph.cpp
+ * \brief Folded stacks of a trace, for the flamegraph scripts
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/flamegraph.hpp"
+#include "hip_instrumentation/hip_instrumentation.hpp"
+
+#include <fstream>
+#include <iostream>
+
+#include "llvm/Support/CommandLine.h"
+
+static llvm::cl::opt<std::string>
+    kernel_geometry("k", llvm::cl::desc("Kernel launch geometry"),
+                    llvm::cl::value_desc("kernel_info"), llvm::cl::Required);
+
+static llvm::cl::opt<std::string> hiptrace("t", llvm::cl::desc("Hiptrace file"),
+                                           llvm::cl::value_desc("hiptrace"),
+                                           llvm::cl::Required);
+
+static llvm::cl::opt<std::string>
+    database("d", llvm::cl::desc("Hip-analyzer database"),
+             llvm::cl::value_desc("database"),
+             llvm::cl::init(hip::default_database));
+
+static llvm::cl::opt<std::string>
+    output("o", llvm::cl::desc("Output file (default : standard output)"),
+           llvm::cl::value_desc("folded"), llvm::cl::init(""));
+
+static llvm::cl::opt<bool>
+    append("append", llvm::cl::desc("Append to the output file, e.g. to "
+                                     "gather several kernels"));
+
+static llvm::cl::opt<hip::FlameWeight> weight(
+    "w", llvm::cl::desc("Weight of the basic blocks"),
+    llvm::cl::values(
+        clEnumValN(hip::FlameWeight::Executions, "executions",
+                   "Execution count"),
+        clEnumValN(hip::FlameWeight::Flops, "flops",
+                   "Floating point operations"),
+        clEnumValN(hip::FlameWeight::Bytes, "bytes",
+                   "Floating point bytes loaded and stored")),
+    llvm::cl::init(hip::FlameWeight::Executions));
+
+static llvm::cl::opt<bool>
+    loops("loops", llvm::cl::desc("Add the enclosing loops to the stacks"));
+
+static llvm::cl::opt<unsigned int>
+    jobs("j", llvm::cl::desc("Analysis threads (0 : all hardware threads)"),
+         llvm::cl::value_desc("threads"), llvm::cl::init(0u));
+
+int main(int argc, char** argv) {
+    llvm::cl::ParseCommandLineOptions(argc, argv);
+
+    auto kernel_info = hip::KernelInfo::fromJson(kernel_geometry.getValue());
+
+    hip::Instrumenter instrumenter(kernel_info);
+    instrumenter.loadBin(hiptrace.getValue());
+
+    const auto& blocks = instrumenter.loadDatabase(database.getValue());
+    const auto& counters = instrumenter.data();
+
+    auto stacks = hip::foldStacks(kernel_info.name, counters.data(),
+                                  counters.size(), kernel_info.basic_blocks,
+                                  blocks, weight.getValue(), loops.getValue(),
+                                  jobs.getValue());
+
+    if (output.getValue().empty()) {
+        hip::writeFoldedStacks(std::cout, stacks);
+        return 0;
+    }
+
+    std::ofstream out(output.getValue(),
+                      append ? std::ios::app : std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not open output file " +
+                                 output.getValue());
+    }
+
+    hip::writeFoldedStacks(out, stacks);
+}
@@ -0,0 +1,88 @@
+/** \file heatmap.cpp
+ * \brief Renders a trace as a (workgroup or thread) x basic block heatmap
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/heatmap.hpp"
+#include "hip_instrumentation/hip_instrumentation.hpp"
+
+#include <iostream>
+
+#include "llvm/Support/CommandLine.h"
+
+static llvm::cl::opt<std::string>
+    kernel_geometry("k", llvm::cl::desc("Kernel launch geometry"),
+                    llvm::cl::value_desc("kernel_info"), llvm::cl::Required);
+
+static llvm::cl::opt<std::string> hiptrace("t", llvm::cl::desc("Hiptrace file"),
+                                           llvm::cl::value_desc("hiptrace"),
+                                           llvm::cl::Required);
+
+static llvm::cl::opt<std::string>
+    output("o", llvm::cl::desc("Output image (.png or .ppm)"),
+           llvm::cl::value_desc("image"), llvm::cl::init("heatmap.png"));
+
+static llvm::cl::opt<bool>
+    per_thread("threads",
+               llvm::cl::desc("One row per thread instead of per workgroup"));
+
+static llvm::cl::opt<bool>
+    linear("linear", llvm::cl::desc("Linear color scale (default : log)"));
+
+static llvm::cl::opt<unsigned int>
+    max_rows("rows", llvm::cl::desc("Maximum number of rows"),
+             llvm::cl::value_desc("rows"), llvm::cl::init(1024u));
+
+static llvm::cl::opt<unsigned int>
+    max_columns("columns", llvm::cl::desc("Maximum number of columns"),
+                llvm::cl::value_desc("columns"), llvm::cl::init(1024u));
+
+static llvm::cl::opt<unsigned int>
+    cell_width("cw", llvm::cl::desc("Width of a cell, in pixels"),
+               llvm::cl::value_desc("pixels"), llvm::cl::init(4u));
+
+static llvm::cl::opt<unsigned int>
+    cell_height("ch", llvm::cl::desc("Height of a cell, in pixels"),
+                llvm::cl::value_desc("pixels"), llvm::cl::init(1u));
+
+static llvm::cl::opt<unsigned int>
+    chunk_mb("chunk", llvm::cl::desc("Chunk size, in MiB"),
+             llvm::cl::value_desc("MiB"), llvm::cl::init(64u));
+
+static llvm::cl::opt<unsigned int>
+    jobs("j", llvm::cl::desc("Analysis threads (0 : all hardware threads)"),
+         llvm::cl::value_desc("threads"), llvm::cl::init(0u));
+
+int main(int argc, char** argv) {
+    llvm::cl::ParseCommandLineOptions(argc, argv);
+
+    auto kernel_info = hip::KernelInfo::fromJson(kernel_geometry.getValue());
+    kernel_info.dump();
+
+    auto threads = kernel_info.total_threads_per_blocks;
+    auto bb_count = kernel_info.basic_blocks;
+
+    // Streamed : the trace may not fit in memory
+    hip::TraceChunkReader reader(hiptrace.getValue());
+    if (reader.size() != kernel_info.instr_size) {
+        throw std::runtime_error("Trace incompatible with the kernel info");
+    }
+
+    hip::HeatmapReducer heatmap(
+        kernel_info.total_blocks, threads, bb_count,
+        per_thread ? hip::HeatmapReducer::Rows::Threads
+                   : hip::HeatmapReducer::Rows::Workgroups,
+        max_rows.getValue(), max_columns.getValue(), jobs.getValue());
+
+    hip::StreamingAnalysis analysis(
+        reader, threads, bb_count,
+        static_cast<size_t>(chunk_mb.getValue()) << 20);
+    analysis.add(heatmap).run();
+
+    heatmap.image(!linear, cell_width.getValue(), cell_height.getValue())
+        .write(output.getValue());
+
+    std::cout << "Wrote a " << heatmap.rows() << " x " << heatmap.columns()
+              << " heatmap to " << output.getValue() << '\n';
+}
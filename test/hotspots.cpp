@@ -0,0 +1,109 @@
+/** \file hotspots.cpp
+ * \brief Annotated source listing of a kernel, with the dynamic counts of its
+ * basic blocks in the margin
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/cpu_reductions.hpp"
+#include "hip_instrumentation/hip_instrumentation.hpp"
+#include "hip_instrumentation/source_map.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "llvm/Support/CommandLine.h"
+
+static llvm::cl::opt<std::string>
+    kernel_geometry("k", llvm::cl::desc("Kernel launch geometry"),
+                    llvm::cl::value_desc("kernel_info"), llvm::cl::Required);
+
+static llvm::cl::opt<std::string> hiptrace("t", llvm::cl::desc("Hiptrace file"),
+                                           llvm::cl::value_desc("hiptrace"),
+                                           llvm::cl::Required);
+
+static llvm::cl::opt<std::string>
+    database("d", llvm::cl::desc("Hip-analyzer database"),
+             llvm::cl::value_desc("database"),
+             llvm::cl::init(hip::default_database));
+
+static llvm::cl::opt<std::string> source(
+    "s",
+    llvm::cl::desc("Source file to annotate, if the path in the database is "
+                   "not valid from the working directory"),
+    llvm::cl::value_desc("source"), llvm::cl::init(""));
+
+static llvm::cl::opt<bool>
+    whole_file("all", llvm::cl::desc("Print the whole file, not only the "
+                                     "instrumented lines"),
+               llvm::cl::init(false));
+
+int main(int argc, char** argv) {
+    llvm::cl::ParseCommandLineOptions(argc, argv);
+
+    auto kernel_info = hip::KernelInfo::fromJson(kernel_geometry.getValue());
+    hip::Instrumenter instrumenter(kernel_info);
+    instrumenter.loadBin(hiptrace.getValue());
+
+    const auto& blocks = instrumenter.loadDatabase(database.getValue());
+    hip::SourceMap source_map(blocks);
+
+    const auto& counters = instrumenter.data();
+    auto counts = hip::cpu::reduceCounts(counters.data(), counters.size(),
+                                         kernel_info.basic_blocks);
+
+    for (const auto& file : source_map.files()) {
+        auto path = source.getValue().empty() ? file : source.getValue();
+
+        std::ifstream in(path);
+        if (!in.is_open()) {
+            std::cerr << "Could not open " << path << ", skipping\n";
+            continue;
+        }
+
+        auto stats = source_map.lineStats(file, counts);
+
+        uint64_t total_flops = 0u, total_executions = 0u;
+        for (const auto& line : stats) {
+            total_flops += line.flops;
+            total_executions += line.executions;
+        }
+
+        // Percentages of the flops if there are any, of the executions
+        // otherwise
+        auto use_flops = total_flops != 0u;
+        auto total = static_cast<double>(use_flops ? total_flops
+                                                   : total_executions);
+
+        std::cout << "----- " << file << " ("
+                  << (use_flops ? "% flops" : "% executions") << ") -----\n";
+
+        std::string text;
+        for (auto line = 1u; std::getline(in, text); ++line) {
+            auto covered = line < stats.size() &&
+                           source_map.blockAt(file, line) !=
+                               hip::SourceMap::no_block;
+
+            if (!covered && !whole_file.getValue()) {
+                continue;
+            }
+
+            std::cout << std::setw(14);
+            if (covered) {
+                const auto& line_stats = stats[line];
+                auto value =
+                    use_flops ? line_stats.flops : line_stats.executions;
+
+                std::cout << line_stats.executions << ' ' << std::setw(6)
+                          << std::fixed << std::setprecision(2)
+                          << (total > 0. ? value / total * 100. : 0.);
+            } else {
+                std::cout << "" << ' ' << std::setw(6) << "";
+            }
+
+            std::cout << " | " << std::setw(5) << line << " | " << text
+                      << '\n';
+        }
+    }
+}
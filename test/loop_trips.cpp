@@ -0,0 +1,93 @@
+/** \file loop_trips.cpp
+ * \brief Loop trip count distributions of a trace
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/hip_instrumentation.hpp"
+#include "hip_instrumentation/loops.hpp"
+
+#include <iomanip>
+#include <iostream>
+
+#include "llvm/Support/CommandLine.h"
+
+static llvm::cl::opt<std::string>
+    kernel_geometry("k", llvm::cl::desc("Kernel launch geometry"),
+                    llvm::cl::value_desc("kernel_info"), llvm::cl::Required);
+
+static llvm::cl::opt<std::string> hiptrace("t", llvm::cl::desc("Hiptrace file"),
+                                           llvm::cl::value_desc("hiptrace"),
+                                           llvm::cl::Required);
+
+static llvm::cl::opt<std::string>
+    database("d", llvm::cl::desc("Hip-analyzer database"),
+             llvm::cl::value_desc("database"),
+             llvm::cl::init(hip::default_database));
+
+static llvm::cl::opt<unsigned int>
+    top("n", llvm::cl::desc("Number of loops and wavefronts to report"),
+        llvm::cl::value_desc("count"), llvm::cl::init(10u));
+
+static llvm::cl::opt<unsigned int>
+    jobs("j", llvm::cl::desc("Analysis threads (0 : all hardware threads)"),
+         llvm::cl::value_desc("threads"), llvm::cl::init(0u));
+
+int main(int argc, char** argv) {
+    llvm::cl::ParseCommandLineOptions(argc, argv);
+
+    auto kernel_info = hip::KernelInfo::fromJson(kernel_geometry.getValue());
+    kernel_info.dump();
+
+    hip::Instrumenter instrumenter(kernel_info);
+    instrumenter.loadBin(hiptrace.getValue());
+
+    const auto& blocks = instrumenter.loadDatabase(database.getValue());
+    auto normalized = hip::BasicBlock::normalized(blocks);
+
+    auto report = hip::analyzeLoops(
+        instrumenter.data().data(), kernel_info.total_blocks,
+        kernel_info.total_threads_per_blocks, kernel_info.basic_blocks,
+        normalized, kernel_info.wave_size, top.getValue(), jobs.getValue());
+
+    if (report.loops.empty()) {
+        std::cout << "No loop found, the database may predate the CFG "
+                     "information\n";
+        return 0;
+    }
+
+    std::cout << std::fixed << std::setprecision(3) << report.loops.size()
+              << " loops\n\nWorst loops :\n";
+
+    for (auto l : report.worstLoops(top.getValue())) {
+        const auto& loop = report.loops[l];
+        const auto& trips = report.trips[l];
+
+        std::cout << "  header " << loop.header << " (depth " << loop.depth
+                  << ", " << loop.body.size() << " blocks) : " << trips.threads
+                  << " threads, mean trips " << trips.meanTrips() << ", max "
+                  << trips.maxTrips() << ", imbalanced waves "
+                  << trips.imbalanced_waves << " / " << trips.waves
+                  << ", efficiency " << trips.efficiency() << ", wasted "
+                  << trips.wastedSlots() << '\n';
+
+        std::cout << "      " << *normalized[loop.header].begin_loc << " -> "
+                  << *normalized[loop.header].end_loc << "\n      trips :";
+
+        for (auto i = 0u; i < trips.histogram.size(); ++i) {
+            if (trips.histogram[i]) {
+                std::cout << ' ' << i << 'x' << trips.histogram[i];
+            }
+        }
+        std::cout << '\n';
+    }
+
+    std::cout << "\nWorst wavefronts :\n";
+
+    for (const auto& wave : report.worst_waves) {
+        std::cout << "  header " << report.loops[wave.loop].header
+                  << ", block " << wave.workgroup << ", wave " << wave.wave
+                  << " : trips " << wave.min_trips << " - " << wave.max_trips
+                  << ", wasted " << wave.wastedSlots() << '\n';
+    }
+}
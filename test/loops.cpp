@@ -0,0 +1,116 @@
+/** \file loops.cpp
+ * \brief Loop detection and trip counts test case, on a synthetic CFG of two
+ * nested loops
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/loops.hpp"
+
+#include <array>
+#include <iostream>
+#include <stdexcept>
+
+int main() {
+    // for (outer) {        // 1 : outer header, 5 : outer latch
+    //     if (c) {         // 2
+    //         for (inner)  // 3 : inner header
+    //             ...      // 4 : inner latch
+    //     }
+    // }                    // 6 : exit
+    std::vector<std::vector<uint32_t>> successors = {
+        {1}, {2, 6}, {3, 5}, {4, 5}, {3}, {1}, {}};
+
+    std::vector<hip::BasicBlock> blocks;
+    for (auto bb = 0u; bb < successors.size(); ++bb) {
+        blocks.emplace_back(bb, bb, 0u, "", "");
+        blocks.back().successors = successors[bb];
+    }
+
+    auto loops = hip::findLoops(blocks);
+
+    if (loops.size() != 2u) {
+        throw std::runtime_error("Expected two loops");
+    }
+
+    const auto& outer = loops[0];
+    const auto& inner = loops[1];
+
+    if (outer.header != 1u || outer.depth != 1u ||
+        outer.body != std::vector<uint32_t>{1, 2, 3, 4, 5} ||
+        outer.latches != std::vector<uint32_t>{5} ||
+        outer.entries != std::vector<uint32_t>{0}) {
+        throw std::runtime_error("Unexpected outer loop");
+    }
+
+    if (inner.header != 3u || inner.depth != 2u ||
+        inner.body != std::vector<uint32_t>{3, 4} ||
+        inner.latches != std::vector<uint32_t>{4} ||
+        inner.entries != std::vector<uint32_t>{2}) {
+        throw std::runtime_error("Unexpected inner loop");
+    }
+
+    // Thread t : 10 outer iterations, entering the inner loop in t % 3 of
+    // them for (t % 5) + 1 iterations
+    constexpr auto total_blocks = 2u;
+    constexpr auto threads_per_block = 8u;
+    constexpr auto wave_size = 4u;
+    constexpr auto bb_count = 7u;
+    constexpr auto outer_iterations = 10u;
+
+    std::vector<uint8_t> counters(total_blocks * threads_per_block * bb_count);
+    std::array<uint64_t, 256> inner_histogram{};
+    uint64_t inner_threads = 0u;
+
+    for (auto t = 0u; t < total_blocks * threads_per_block; ++t) {
+        auto c = &counters[t * bb_count];
+        auto entered = t % 3u, iterations = t % 5u + 1u;
+
+        c[0] = 1u;
+        c[1] = outer_iterations + 1u;
+        c[2] = outer_iterations;
+        c[3] = entered * (iterations + 1u);
+        c[4] = entered * iterations;
+        c[5] = outer_iterations;
+        c[6] = 1u;
+
+        if (entered) {
+            ++inner_histogram[iterations + 1u];
+            ++inner_threads;
+        }
+    }
+
+    auto report = hip::analyzeLoops(counters.data(), total_blocks,
+                                    threads_per_block, bb_count, blocks,
+                                    wave_size, 8u, 2u);
+
+    const auto& outer_trips = report.trips[0];
+    const auto& inner_trips = report.trips[1];
+
+    std::cout << "Outer : " << outer_trips.threads << " threads, "
+              << outer_trips.meanTrips() << " trips\n"
+              << "Inner : " << inner_trips.threads << " threads, "
+              << inner_trips.meanTrips() << " trips, efficiency "
+              << inner_trips.efficiency() << '\n';
+
+    // The header runs once more than the iterations, to exit
+    if (outer_trips.threads != total_blocks * threads_per_block ||
+        outer_trips.histogram[outer_iterations + 1u] != outer_trips.threads ||
+        outer_trips.imbalanced_waves != 0u) {
+        throw std::runtime_error("Unexpected outer trip counts");
+    }
+
+    // Counted per entry, although the entry block does not always branch to
+    // the header
+    if (inner_trips.threads != inner_threads ||
+        inner_trips.histogram != inner_histogram) {
+        throw std::runtime_error("Unexpected inner trip counts");
+    }
+
+    if (inner_trips.imbalanced_waves == 0u || report.worst_waves.empty() ||
+        report.worst_waves.front().loop != 1u) {
+        throw std::runtime_error("Expected imbalanced wavefronts");
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+/** \file online_stats.cpp
+ * \brief Online statistics test case, compared to a two-pass computation
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/online_stats.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+int main() {
+    std::mt19937_64 gen(42);
+    std::uniform_int_distribution<uint64_t> dist(1000000u, 1001000u);
+
+    constexpr auto bb_count = 5u;
+    constexpr auto launches = 10000u;
+
+    std::vector<std::vector<uint64_t>> totals(launches);
+    hip::StatsRegistry registry;
+
+    // The second half is accumulated separately, then merged
+    std::vector<hip::RunningStats> second_half(bb_count);
+
+    for (auto i = 0u; i < launches; ++i) {
+        for (auto bb = 0u; bb < bb_count; ++bb) {
+            totals[i].emplace_back(dist(gen) * (bb + 1));
+        }
+
+        registry.add("kernel", totals[i].data(), bb_count);
+
+        if (i >= launches / 2) {
+            for (auto bb = 0u; bb < bb_count; ++bb) {
+                second_half[bb].add(totals[i][bb]);
+            }
+        }
+    }
+
+    auto stats = registry.kernels().at("kernel");
+    if (stats.launches() != launches) {
+        throw std::runtime_error("Wrong number of launches");
+    }
+
+    auto close = [](double lhs, double rhs) {
+        return std::abs(lhs - rhs) <= 1e-9 * std::max(std::abs(rhs), 1.);
+    };
+
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        double mean = 0.;
+        uint64_t min = UINT64_MAX, max = 0u;
+        for (const auto& launch : totals) {
+            mean += launch[bb];
+            min = std::min(min, launch[bb]);
+            max = std::max(max, launch[bb]);
+        }
+        mean /= launches;
+
+        double variance = 0.;
+        for (const auto& launch : totals) {
+            variance += (launch[bb] - mean) * (launch[bb] - mean);
+        }
+        variance /= launches - 1;
+
+        const auto& block = stats.blocks[bb];
+        if (!close(block.mean, mean) || !close(block.variance(), variance) ||
+            block.min != min || block.max != max) {
+            throw std::runtime_error("Mismatch for basic block " +
+                                     std::to_string(bb));
+        }
+
+        hip::RunningStats first_half;
+        for (auto i = 0u; i < launches / 2; ++i) {
+            first_half.add(totals[i][bb]);
+        }
+        first_half.merge(second_half[bb]);
+
+        if (!close(first_half.mean, mean) ||
+            !close(first_half.variance(), variance) ||
+            first_half.n != launches) {
+            throw std::runtime_error("Merge mismatch for basic block " +
+                                     std::to_string(bb));
+        }
+    }
+
+    std::cout << registry.json().substr(0, 200) << "...\nOk\n";
+}
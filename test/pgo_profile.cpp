@@ -0,0 +1,137 @@
+/** \file pgo_profile.cpp
+ * \brief Profile-guided optimization feedback from a trace : LLVM sample
+ * profile and branch weights
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/cpu_reductions.hpp"
+#include "hip_instrumentation/hip_instrumentation.hpp"
+#include "hip_instrumentation/pgo.hpp"
+#include "hip_instrumentation/source_map.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "llvm/Support/CommandLine.h"
+
+static llvm::cl::opt<std::string>
+    kernel_geometry("k", llvm::cl::desc("Kernel launch geometry"),
+                    llvm::cl::value_desc("kernel_info"), llvm::cl::Required);
+
+static llvm::cl::opt<std::string> hiptrace("t", llvm::cl::desc("Hiptrace file"),
+                                           llvm::cl::value_desc("hiptrace"),
+                                           llvm::cl::Required);
+
+static llvm::cl::opt<std::string>
+    database("d", llvm::cl::desc("Hip-analyzer database"),
+             llvm::cl::value_desc("database"),
+             llvm::cl::init(hip::default_database));
+
+static llvm::cl::opt<std::string> function(
+    "f",
+    llvm::cl::desc("Function name in the profile, mangled as in the IR "
+                   "(default : the kernel name)"),
+    llvm::cl::value_desc("function"), llvm::cl::init(""));
+
+static llvm::cl::opt<unsigned int> function_line(
+    "l",
+    llvm::cl::desc("Line of the kernel declaration (default : the line "
+                   "preceding the first basic block)"),
+    llvm::cl::value_desc("line"), llvm::cl::init(0u));
+
+static llvm::cl::opt<std::string>
+    profile("o", llvm::cl::desc("Output sample profile (text format)"),
+            llvm::cl::value_desc("profile"), llvm::cl::init("kernel.prof"));
+
+static llvm::cl::opt<std::string>
+    branches("b", llvm::cl::desc("Output branch weights (JSON)"),
+             llvm::cl::value_desc("branches"), llvm::cl::init(""));
+
+static llvm::cl::opt<unsigned int>
+    jobs("j", llvm::cl::desc("Analysis threads (0 : all hardware threads)"),
+         llvm::cl::value_desc("threads"), llvm::cl::init(0u));
+
+std::ofstream openOutput(const std::string& filename) {
+    std::ofstream out(filename, std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not open output file " + filename);
+    }
+
+    return out;
+}
+
+int main(int argc, char** argv) {
+    llvm::cl::ParseCommandLineOptions(argc, argv);
+
+    auto kernel_info = hip::KernelInfo::fromJson(kernel_geometry.getValue());
+
+    hip::Instrumenter instrumenter(kernel_info);
+    instrumenter.loadBin(hiptrace.getValue());
+
+    const auto& blocks = instrumenter.loadDatabase(database.getValue());
+    const auto& counters = instrumenter.data();
+    auto counts =
+        hip::cpu::reduceCounts(counters.data(), counters.size(),
+                               kernel_info.basic_blocks, jobs.getValue());
+
+    // ----- Sample profile ----- //
+
+    // The kernel lives in the file of its entry block
+    auto normalized = hip::BasicBlock::normalized(blocks);
+    auto entry = hip::SourceLocation::parse(*normalized[0].begin_loc);
+    if (!entry) {
+        throw std::runtime_error("Could not locate the kernel from " +
+                                 *normalized[0].begin_loc);
+    }
+
+    auto line = function_line.getValue();
+    if (line == 0u) {
+        line = entry->line;
+        for (const auto& block : blocks) {
+            auto begin = hip::SourceLocation::parse(*block.begin_loc);
+            if (begin && begin->file == entry->file) {
+                line = std::min(line, begin->line);
+            }
+        }
+        line = line > 1u ? line - 1u : 1u;
+    }
+
+    auto name =
+        function.getValue().empty() ? kernel_info.name : function.getValue();
+    auto threads = static_cast<uint64_t>(kernel_info.total_blocks) *
+                   kernel_info.total_threads_per_blocks;
+
+    auto out = openOutput(profile.getValue());
+    hip::writeSampleProfile(out, name, entry->file, line, blocks, counts,
+                            threads);
+
+    std::cout << "Wrote the sample profile of " << name << " to "
+              << profile.getValue() << ", use it with -fprofile-sample-use\n";
+
+    // ----- Branch weights ----- //
+
+    auto edges = hip::inferEdgeCounts(normalized, counts);
+    if (edges.empty()) {
+        std::cout << "No CFG information in the database, no branch weights\n";
+        return 0;
+    }
+
+    auto weights = hip::branchWeights(edges);
+    auto exact = std::count_if(edges.begin(), edges.end(),
+                               [](const auto& edge) { return edge.exact; });
+
+    std::cout << weights.size() << " branches, " << exact << " / "
+              << edges.size() << " edge counts derived exactly\n";
+
+    if (!branches.getValue().empty()) {
+        openOutput(branches.getValue())
+            << hip::branchWeightsJson(weights, normalized, counts) << '\n';
+    } else {
+        for (const auto& branch : weights) {
+            std::cout << "  " << *normalized[branch.block].begin_loc << " : "
+                      << branch.metadata() << '\n';
+        }
+    }
+}
@@ -0,0 +1,98 @@
+/** \file query_server.cpp
+ * \brief Local trace query server, see query_server.hpp for the protocol
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/query_server.hpp"
+
+#include <csignal>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "llvm/Support/CommandLine.h"
+
+static llvm::cl::opt<std::string>
+    socket_path("s", llvm::cl::desc("UNIX socket path"),
+                llvm::cl::value_desc("socket"),
+                llvm::cl::init("/tmp/hip_analyzer.sock"));
+
+static llvm::cl::opt<unsigned int>
+    jobs("j", llvm::cl::desc("Worker threads (0 : all hardware threads)"),
+         llvm::cl::value_desc("threads"), llvm::cl::init(0u));
+
+static llvm::cl::opt<std::string>
+    data_root("root",
+              llvm::cl::desc("Directory of the traces which can be loaded "
+                             "over the socket (disabled if empty)"),
+              llvm::cl::value_desc("directory"), llvm::cl::init(""));
+
+static llvm::cl::opt<std::string>
+    socket_mode("mode",
+                llvm::cl::desc("Permissions of the socket, in octal (0660 "
+                               "lets the group of the server connect)"),
+                llvm::cl::value_desc("mode"), llvm::cl::init("0600"));
+
+static llvm::cl::list<std::string>
+    preload("l",
+            llvm::cl::desc("Trace to load at startup, as "
+                           "name:kernel_info:hiptrace[:database]"),
+            llvm::cl::value_desc("trace"));
+
+int main(int argc, char** argv) {
+    llvm::cl::ParseCommandLineOptions(argc, argv);
+
+    // Handle the termination signals in a dedicated thread, blocked in all the
+    // others
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    const auto& mode_string = socket_mode.getValue();
+    if (mode_string.empty() || mode_string.size() > 4u ||
+        mode_string.find_first_not_of("01234567") != std::string::npos) {
+        std::cerr << "Invalid socket mode " << mode_string << '\n';
+        return 1;
+    }
+    auto mode = static_cast<unsigned int>(std::stoul(mode_string, nullptr, 8));
+
+    hip::QueryServer server(socket_path.getValue(), jobs.getValue(),
+                            data_root.getValue(), mode);
+
+    // Preloaded traces are trusted, they are not restricted to the data root
+    for (const auto& trace : preload) {
+        std::vector<std::string> fields;
+        std::istringstream ss(trace);
+        for (std::string field; std::getline(ss, field, ':');) {
+            fields.emplace_back(field);
+        }
+
+        if (fields.size() < 3u || fields.size() > 4u) {
+            std::cerr << "Invalid trace " << trace << '\n';
+            continue;
+        }
+
+        try {
+            server.load(fields[0], fields[1], fields[2],
+                        fields.size() > 3u ? fields[3] : "");
+            std::cout << "Loaded " << fields[0] << '\n';
+        } catch (const std::exception& e) {
+            std::cerr << "Could not load " << trace << " : " << e.what()
+                      << '\n';
+        }
+    }
+
+    std::thread([&]() {
+        int signal;
+        sigwait(&signals, &signal);
+        server.stop();
+    }).detach();
+
+    std::cout << "Listening on " << socket_path.getValue() << '\n';
+    server.serve();
+}
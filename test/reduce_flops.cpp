@@ -0,0 +1,79 @@
+/** \file reduce_flops.cpp
+ * \brief On-device per basic block reduction test case, compared to the host
+ * reference
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/hip_instrumentation.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <random>
+
+int main() {
+    hip::init();
+
+    constexpr auto bb_count = 13u;
+    constexpr auto database = "reduce_flops.json";
+
+    // Odd number of basic blocks and unaligned geometry, to exercise the grid
+    // rounding and the partial chunks
+    hip::KernelInfo ki("reduce_flops", bb_count, dim3(97), dim3(127));
+    hip::Instrumenter instrumenter(ki);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<unsigned int> dist(0u, 255u);
+
+    std::vector<hip::BasicBlock> blocks;
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        blocks.emplace_back(bb, bb, dist(gen), "", "");
+    }
+
+    {
+        std::ofstream db(database);
+        db << hip::BasicBlock::jsonArray(blocks);
+    }
+
+    instrumenter.loadDatabase(database);
+
+    std::vector<uint8_t> counters(ki.instr_size);
+    for (auto& c : counters) {
+        c = static_cast<uint8_t>(dist(gen));
+    }
+
+    uint8_t* device_counters;
+    hip::check(hipMalloc(&device_counters, counters.size()));
+    hip::check(hipMemcpy(device_counters, counters.data(), counters.size(),
+                         hipMemcpyHostToDevice));
+
+    auto usage = instrumenter.reduceBlockUsage(device_counters);
+    auto flops = instrumenter.reduceFlops(device_counters);
+
+    hip::check(hipFree(device_counters));
+
+    // Compare with the host reference
+
+    auto reference = hip::cpu::reduceBlockUsage(
+        counters.data(), counters.size(), hip::BasicBlock::normalized(blocks),
+        bb_count);
+
+    uint64_t reference_flops = 0u;
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        std::cout << bb << " : " << usage[bb].count << " / "
+                  << reference[bb].count << '\n';
+        reference_flops += reference[bb].flops;
+    }
+
+    if (usage != reference) {
+        throw std::runtime_error("Block usage differs from the reference");
+    }
+
+    if (flops != reference_flops) {
+        throw std::runtime_error("Flops differ from the reference");
+    }
+
+    std::cout << "Total flops : " << flops << '\n';
+
+    return 0;
+}
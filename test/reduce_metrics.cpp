@@ -0,0 +1,106 @@
+/** \file reduce_metrics.cpp
+ * \brief On-device multi-metric reduction test case (every metric at once),
+ * compared to the host reference
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/hip_instrumentation.hpp"
+#include "hip_instrumentation/metrics.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <random>
+
+int main() {
+    hip::init();
+
+    constexpr auto bb_count = 13u;
+    constexpr auto database = "reduce_metrics.json";
+
+    // Same geometry as reduce_flops : the grid stride is not a multiple of
+    // the number of threads, and the last chunk is partial
+    hip::KernelInfo ki("reduce_metrics", bb_count, dim3(97), dim3(127));
+    hip::Instrumenter instrumenter(ki);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<unsigned int> dist(0u, 255u);
+
+    std::vector<hip::BasicBlock> blocks;
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        blocks.emplace_back(bb, bb, dist(gen), "", "");
+    }
+
+    {
+        std::ofstream db(database);
+        db << hip::BasicBlock::jsonArray(blocks);
+    }
+
+    instrumenter.loadDatabase(database);
+
+    // Leave one block at a constant count, so Min == Max
+    std::vector<uint8_t> counters(ki.instr_size);
+    for (auto i = 0u; i < counters.size(); ++i) {
+        counters[i] = i % bb_count == 0u ? 7u : static_cast<uint8_t>(dist(gen));
+    }
+
+    uint8_t* device_counters;
+    hip::check(hipMalloc(&device_counters, counters.size()));
+    hip::check(hipMemcpy(device_counters, counters.data(), counters.size(),
+                         hipMemcpyHostToDevice));
+
+    auto results =
+        instrumenter.reduce<hip::metrics::Count, hip::metrics::Flops,
+                            hip::metrics::FloatingLoads,
+                            hip::metrics::FloatingStores,
+                            hip::metrics::SumOfSquares, hip::metrics::Min,
+                            hip::metrics::Max>(device_counters);
+
+    hip::check(hipFree(device_counters));
+
+    // Host reference, with the same policies
+
+    auto table = hip::DeviceBlockInfo::table(
+        hip::BasicBlock::normalized(blocks), bb_count);
+
+    std::vector<hip::AllMetrics> reference(bb_count,
+                                           hip::AllMetrics::identity());
+    for (auto i = 0u; i < counters.size(); ++i) {
+        reference[i % bb_count].accumulate(counters[i], table[i % bb_count]);
+    }
+
+    auto compare = [&]<typename Metric>(const char* name) {
+        for (auto bb = 0u; bb < bb_count; ++bb) {
+            auto value = results[bb].get<Metric>();
+            auto expected = reference[bb].get<Metric>();
+
+            if (value != expected) {
+                std::cout << name << ", bb " << bb << " : " << value << " / "
+                          << expected << '\n';
+                throw std::runtime_error(
+                    std::string(name) + " differs from the reference");
+            }
+        }
+    };
+
+    compare.operator()<hip::metrics::Count>("Count");
+    compare.operator()<hip::metrics::Flops>("Flops");
+    compare.operator()<hip::metrics::FloatingLoads>("FloatingLoads");
+    compare.operator()<hip::metrics::FloatingStores>("FloatingStores");
+    compare.operator()<hip::metrics::SumOfSquares>("SumOfSquares");
+    compare.operator()<hip::metrics::Min>("Min");
+    compare.operator()<hip::metrics::Max>("Max");
+
+    if (results[0].get<hip::metrics::Min>() != 7u ||
+        results[0].get<hip::metrics::Max>() != 7u) {
+        throw std::runtime_error("Unexpected extrema of a constant block");
+    }
+
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        std::cout << bb << " : count " << results[bb].get<hip::metrics::Count>()
+                  << ", min " << results[bb].get<hip::metrics::Min>()
+                  << ", max " << results[bb].get<hip::metrics::Max>() << '\n';
+    }
+
+    return 0;
+}
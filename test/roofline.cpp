@@ -0,0 +1,117 @@
+/** \file roofline.cpp
+ * \brief Roofline report of a kernel execution, from its trace and the GPU
+ * benchmark (see gpu_benchmark)
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/hip_instrumentation.hpp"
+#include "hip_instrumentation/roofline.hpp"
+
+#include <fstream>
+#include <iostream>
+
+#include "llvm/Support/CommandLine.h"
+
+static llvm::cl::opt<std::string>
+    gpu_info_file("g", llvm::cl::desc("GPU info (see gpu_benchmark)"),
+                  llvm::cl::value_desc("gpu_info"),
+                  llvm::cl::init("gpu_info.json"));
+
+static llvm::cl::opt<std::string>
+    kernel_geometry("k", llvm::cl::desc("Kernel launch geometry"),
+                    llvm::cl::value_desc("kernel_info"), llvm::cl::Required);
+
+static llvm::cl::opt<std::string> hiptrace("t", llvm::cl::desc("Hiptrace file"),
+                                           llvm::cl::value_desc("hiptrace"),
+                                           llvm::cl::Required);
+
+static llvm::cl::opt<std::string>
+    database("d", llvm::cl::desc("Hip-analyzer database"),
+             llvm::cl::value_desc("database"),
+             llvm::cl::init(hip::default_database));
+
+static llvm::cl::opt<std::string> output("o", llvm::cl::desc("JSON report"),
+                                         llvm::cl::value_desc("output"),
+                                         llvm::cl::init("roofline.json"));
+
+static llvm::cl::opt<std::string> plot("s", llvm::cl::desc("SVG plot"),
+                                       llvm::cl::value_desc("svg"),
+                                       llvm::cl::init("roofline.svg"));
+
+static llvm::cl::opt<unsigned int>
+    top("b", llvm::cl::desc("Number of basic blocks to print"),
+        llvm::cl::value_desc("count"), llvm::cl::init(10u));
+
+static llvm::cl::opt<hip::BlockOrder> order(
+    "sort", llvm::cl::desc("Basic blocks order"),
+    llvm::cl::values(
+        clEnumValN(hip::BlockOrder::TimeSaved, "time-saved",
+                   "Kernel time saved if the block reached its nearest roof"),
+        clEnumValN(hip::BlockOrder::Speedup, "speedup",
+                   "Speedup of the block at its nearest roof"),
+        clEnumValN(hip::BlockOrder::TimeShare, "time-share",
+                   "Estimated share of the kernel duration")),
+    llvm::cl::init(hip::BlockOrder::TimeSaved));
+
+void writeFile(const std::string& filename, const std::string& contents) {
+    std::ofstream out(filename, std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not open output file " + filename);
+    }
+
+    out << contents;
+}
+
+int main(int argc, char** argv) {
+    llvm::cl::ParseCommandLineOptions(argc, argv);
+
+    auto gpu_info = hip::GpuInfo::fromJson(gpu_info_file.getValue());
+
+    auto kernel_info = hip::KernelInfo::fromJson(kernel_geometry.getValue());
+    hip::Instrumenter instrumenter(kernel_info);
+    instrumenter.loadBin(hiptrace.getValue());
+
+    const auto& blocks = instrumenter.loadDatabase(database.getValue());
+
+    const auto& counters = instrumenter.data();
+    auto ai = hip::arithmeticIntensity(counters.data(), counters.size(), blocks,
+                                       kernel_info.basic_blocks);
+
+    // Roctracer stamps are in ns
+    auto [begin, end] = instrumenter.kernelStamps();
+    if (end <= begin) {
+        throw std::runtime_error("The trace has no valid kernel timestamps");
+    }
+    auto duration = static_cast<double>(end - begin) * 1e-9;
+
+    auto model = hip::roofline(gpu_info, kernel_info.name, ai, duration);
+
+    std::cout << "Kernel " << model.kernel << " : " << model.intensity
+              << " FLOPs/byte, " << model.flops_s << " FLOP/s ("
+              << model.duration << " s), "
+              << (model.memory_bound ? "memory" : "compute") << " bound\n";
+
+    for (const auto& roof : model.roofs) {
+        std::cout << "  " << roof.name << " : " << roof.fraction * 100.
+                  << " % of " << roof.bound << " FLOP/s\n";
+    }
+
+    auto sorted = model.sortedBlocks(order.getValue());
+    sorted.resize(std::min<size_t>(sorted.size(), top.getValue()));
+
+    std::cout << "\nBasic blocks :\n";
+    for (auto i : sorted) {
+        const auto& block = model.blocks[i];
+        std::cout << "  " << block.id << " : " << block.intensity
+                  << " FLOPs/byte, " << block.time_share * 100.
+                  << " % of the time, "
+                  << (block.memory_bound ? "memory" : "compute")
+                  << " bound, x" << block.speedup << " to "
+                  << (block.nearest_roof.empty() ? "-" : block.nearest_roof)
+                  << " (saves " << block.time_saved << " s)\n";
+    }
+
+    writeFile(output.getValue(), model.json() + '\n');
+    writeFile(plot.getValue(), model.svg());
+}
@@ -0,0 +1,57 @@
+/** \file signatures.cpp
+ * \brief Control-path signatures deduplication & reconstruction test case
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/signatures.hpp"
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+int main() {
+    constexpr auto total_blocks = 32u;
+    constexpr auto threads = 64u;
+    constexpr auto bb_count = 9u;
+
+    // Every thread follows one of a handful of control paths
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<unsigned int> dist(0u, 255u);
+
+    std::vector<std::vector<uint8_t>> paths(4, std::vector<uint8_t>(bb_count));
+    for (auto& path : paths) {
+        for (auto& c : path) {
+            c = static_cast<uint8_t>(dist(gen));
+        }
+    }
+
+    std::vector<uint8_t> counters;
+    counters.reserve(total_blocks * threads * bb_count);
+
+    for (auto i = 0u; i < total_blocks * threads; ++i) {
+        const auto& path = paths[dist(gen) % paths.size()];
+        counters.insert(counters.end(), path.begin(), path.end());
+    }
+
+    auto trace = hip::deduplicateSignatures(counters.data(), total_blocks,
+                                            threads, bb_count);
+
+    std::cout << "Signatures : " << trace.offsets.back() << " for "
+              << total_blocks * threads << " threads\n";
+
+    for (auto block = 0u; block < total_blocks; ++block) {
+        if (trace.signatureCount(block) > paths.size()) {
+            throw std::runtime_error("Duplicate signatures in workgroup");
+        }
+    }
+
+    std::vector<uint8_t> expanded(counters.size());
+    hip::expandSignatures(trace, threads, bb_count, expanded.data());
+
+    if (expanded != counters) {
+        throw std::runtime_error("Reconstructed counters differ");
+    }
+
+    return 0;
+}
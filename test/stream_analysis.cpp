@@ -0,0 +1,121 @@
+/** \file stream_analysis.cpp
+ * \brief Out-of-core analysis of a dense trace, for traces larger than memory
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/hip_instrumentation.hpp"
+#include "hip_instrumentation/streaming.hpp"
+
+#include <iomanip>
+#include <iostream>
+
+#include "llvm/Support/CommandLine.h"
+
+static llvm::cl::opt<std::string>
+    kernel_geometry("k", llvm::cl::desc("Kernel launch geometry"),
+                    llvm::cl::value_desc("kernel_info"), llvm::cl::Required);
+
+static llvm::cl::opt<std::string> hiptrace("t", llvm::cl::desc("Hiptrace file"),
+                                           llvm::cl::value_desc("hiptrace"),
+                                           llvm::cl::Required);
+
+static llvm::cl::opt<std::string>
+    database("d", llvm::cl::desc("Hip-analyzer database"),
+             llvm::cl::value_desc("database"),
+             llvm::cl::init(hip::default_database));
+
+static llvm::cl::opt<unsigned int>
+    chunk_mb("chunk", llvm::cl::desc("Chunk size, in MiB"),
+             llvm::cl::value_desc("MiB"), llvm::cl::init(64u));
+
+static llvm::cl::opt<unsigned int>
+    jobs("j", llvm::cl::desc("Analysis threads (0 : all hardware threads)"),
+         llvm::cl::value_desc("threads"), llvm::cl::init(0u));
+
+static llvm::cl::opt<unsigned int>
+    top("n", llvm::cl::desc("Number of wavefronts to report"),
+        llvm::cl::value_desc("count"), llvm::cl::init(10u));
+
+int main(int argc, char** argv) {
+    llvm::cl::ParseCommandLineOptions(argc, argv);
+
+    auto kernel_info = hip::KernelInfo::fromJson(kernel_geometry.getValue());
+    kernel_info.dump();
+
+    // No Instrumenter : it would allocate the whole trace
+    auto blocks = hip::BasicBlock::fromJsonArray(database.getValue());
+    auto normalized = hip::BasicBlock::normalized(blocks);
+
+    auto threads = kernel_info.total_threads_per_blocks;
+    auto bb_count = kernel_info.basic_blocks;
+
+    hip::TraceChunkReader reader(hiptrace.getValue());
+    if (reader.size() != kernel_info.instr_size) {
+        throw std::runtime_error("Trace incompatible with the kernel info");
+    }
+
+    hip::CountReducer counts(bb_count, jobs.getValue());
+    hip::HistogramReducer histograms(bb_count);
+    hip::DivergenceReducer divergence(threads, bb_count, kernel_info.wave_size,
+                                      top.getValue(), jobs.getValue());
+
+    hip::StreamingAnalysis analysis(
+        reader, threads, bb_count,
+        static_cast<size_t>(chunk_mb.getValue()) << 20);
+    analysis.add(counts).add(histograms).add(divergence).run();
+
+    // ----- Basic blocks ----- //
+
+    std::cout << "\nBasic blocks (count, flops, threads by count : 0 / 1 / "
+                 "2+, max) :\n";
+
+    uint64_t total_flops = 0u;
+
+    for (auto bb = 0u; bb < bb_count; ++bb) {
+        const auto& histogram = histograms.histogram(bb);
+
+        uint64_t flops = 0u;
+        if (bb < normalized.size()) {
+            flops = counts.counts()[bb] * normalized[bb].flops;
+        }
+        total_flops += flops;
+
+        uint64_t more = 0u;
+        for (auto value = 2u; value < histogram.size(); ++value) {
+            more += histogram[value];
+        }
+
+        auto max = histogram.size() - 1;
+        while (max > 0u && histogram[max] == 0u) {
+            --max;
+        }
+
+        std::cout << "  " << bb << " : " << counts.counts()[bb] << ", "
+                  << flops << ", " << histogram[0] << " / " << histogram[1]
+                  << " / " << more << ", " << max << '\n';
+    }
+
+    std::cout << "Total flops : " << total_flops << '\n';
+
+    // ----- Divergence ----- //
+
+    const auto& report = divergence.report();
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "\nKernel SIMD efficiency : " << report.total.efficiency()
+              << ", active lanes : " << report.total.activeFraction()
+              << ", wasted lane slots : " << report.total.wastedSlots()
+              << "\n\nWorst wavefronts :\n";
+
+    for (const auto& wave : report.waves) {
+        if (wave.wastedSlots() == 0u) {
+            break;
+        }
+
+        std::cout << "  block " << wave.workgroup << ", wave " << wave.wave
+                  << " : efficiency " << wave.efficiency() << ", paths "
+                  << wave.distinct_vectors << " / " << wave.lanes
+                  << ", wasted " << wave.wastedSlots() << '\n';
+    }
+}
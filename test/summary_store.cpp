@@ -0,0 +1,110 @@
+/** \file summary_store.cpp
+ * \brief Appends traces to a summary store, or queries it
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/hip_instrumentation.hpp"
+#include "hip_instrumentation/streaming.hpp"
+#include "hip_instrumentation/summary_store.hpp"
+
+#include <iomanip>
+#include <iostream>
+
+#include "llvm/Support/CommandLine.h"
+
+static llvm::cl::opt<std::string> store_path("s",
+                                             llvm::cl::desc("Summary store"),
+                                             llvm::cl::value_desc("store"),
+                                             llvm::cl::Required);
+
+static llvm::cl::opt<std::string>
+    kernel_geometry("k", llvm::cl::desc("Kernel launch geometry, to append"),
+                    llvm::cl::value_desc("kernel_info"));
+
+static llvm::cl::list<std::string>
+    hiptraces(llvm::cl::Positional, llvm::cl::desc("<hiptrace files>"));
+
+static llvm::cl::opt<uint64_t>
+    from("from", llvm::cl::desc("Beginning of the queried range (ns)"),
+         llvm::cl::value_desc("stamp"), llvm::cl::init(0u));
+
+static llvm::cl::opt<uint64_t>
+    to("to", llvm::cl::desc("End of the queried range (ns)"),
+       llvm::cl::value_desc("stamp"), llvm::cl::init(0u));
+
+static llvm::cl::opt<unsigned int>
+    buckets("n", llvm::cl::desc("Number of buckets"),
+            llvm::cl::value_desc("count"), llvm::cl::init(20u));
+
+void append() {
+    auto kernel_info = hip::KernelInfo::fromJson(kernel_geometry.getValue());
+    auto bb_count = kernel_info.basic_blocks;
+
+    hip::SummaryWriter store(store_path.getValue(), bb_count);
+    auto kernel_id = hip::summary::kernelId(kernel_info.name);
+
+    for (const auto& hiptrace : hiptraces) {
+        hip::TraceChunkReader reader(hiptrace);
+        if (reader.size() != kernel_info.instr_size) {
+            throw std::runtime_error("Trace " + hiptrace +
+                                     " incompatible with the kernel info");
+        }
+
+        hip::CountReducer counts(bb_count);
+        hip::StreamingAnalysis(reader, kernel_info.total_threads_per_blocks,
+                               bb_count)
+            .add(counts)
+            .run();
+
+        const auto& header = reader.header();
+        store.append(kernel_id, header.stamp_begin, header.stamp_end,
+                     counts.counts().data());
+    }
+
+    std::cout << "Appended " << hiptraces.size() << " launches, "
+              << store.size() << " in the store\n";
+}
+
+void query() {
+    hip::SummaryReader store(store_path.getValue());
+
+    auto [first, last] = store.stampRange();
+    auto begin = from.getValue() ? from.getValue() : first;
+    auto end = to.getValue() ? to.getValue() : last + 1;
+
+    std::cout << store.size() << " launches, " << store.basicBlocks()
+              << " basic blocks, stamps [" << first << ", " << last << "]\n";
+
+    if (store.size() == 0u) {
+        return;
+    }
+
+    std::cout << "\nBegin, launches, mean duration (ns), executions\n";
+
+    for (const auto& bucket : store.downsample(begin, end, buckets)) {
+        uint64_t executions = 0u;
+        for (auto total : bucket.totals) {
+            executions += total;
+        }
+
+        std::cout << bucket.begin << ", " << bucket.launches << ", "
+                  << (bucket.launches ? bucket.duration / bucket.launches : 0u)
+                  << ", " << executions << '\n';
+    }
+}
+
+int main(int argc, char** argv) {
+    llvm::cl::ParseCommandLineOptions(argc, argv);
+
+    if (!hiptraces.empty()) {
+        if (kernel_geometry.getValue().empty()) {
+            throw std::runtime_error("The kernel info (-k) is required to "
+                                     "append traces");
+        }
+
+        append();
+    } else {
+        query();
+    }
+}
@@ -0,0 +1,51 @@
+/** \file timeline.cpp
+ * \brief Builds a Chrome trace event timeline from the headers of saved
+ * traces, to be opened in chrome://tracing or Perfetto
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/timeline.hpp"
+#include "hip_instrumentation/trace_reader.hpp"
+
+#include <iostream>
+
+#include "llvm/Support/CommandLine.h"
+
+static llvm::cl::list<std::string>
+    hiptraces(llvm::cl::Positional, llvm::cl::desc("<hiptrace files>"),
+              llvm::cl::OneOrMore);
+
+static llvm::cl::opt<std::string>
+    output("o", llvm::cl::desc("Output file"), llvm::cl::value_desc("json"),
+           llvm::cl::init("timeline.json"));
+
+int main(int argc, char** argv) {
+    llvm::cl::ParseCommandLineOptions(argc, argv);
+
+    hip::TimelineWriter timeline(output.getValue());
+    timeline.threadName(0u, "Kernels");
+
+    for (const auto& hiptrace : hiptraces) {
+        // Only the header is read, the traces might be large
+        std::ifstream in(hiptrace, std::ios::binary);
+
+        std::string line;
+        if (!std::getline(in, line)) {
+            std::cerr << "Could not read header of " << hiptrace << '\n';
+            continue;
+        }
+
+        auto header = hip::TraceHeader::parse(line);
+
+        timeline.async(header.kernel, "kernel", header.stamp_begin,
+                       header.stamp_end, timeline.nextId(),
+                       {{"trace", hip::TimelineWriter::quoted(hiptrace)},
+                        {"format", hip::TimelineWriter::quoted(header.type)},
+                        {"counters", std::to_string(header.instr_size)}});
+    }
+
+    timeline.close();
+    std::cout << "Timeline of " << hiptraces.size() << " launches written to "
+              << output.getValue() << '\n';
+}
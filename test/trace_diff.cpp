@@ -0,0 +1,124 @@
+/** \file trace_diff.cpp
+ * \brief Compares two traces of the same kernel, streamed side by side
+ *
+ * \author Sébastien Darche <sebastien.darche@polymtl.ca>
+ */
+
+#include "hip_instrumentation/hip_instrumentation.hpp"
+#include "hip_instrumentation/trace_diff.hpp"
+#include "hip_instrumentation/trace_reader.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "llvm/Support/CommandLine.h"
+
+static llvm::cl::opt<std::string>
+    kernel_geometry("k", llvm::cl::desc("Kernel launch geometry"),
+                    llvm::cl::value_desc("kernel_info"), llvm::cl::Required);
+
+static llvm::cl::opt<std::string> trace_a("a", llvm::cl::desc("Base trace"),
+                                          llvm::cl::value_desc("hiptrace"),
+                                          llvm::cl::Required);
+
+static llvm::cl::opt<std::string> trace_b("b", llvm::cl::desc("New trace"),
+                                          llvm::cl::value_desc("hiptrace"),
+                                          llvm::cl::Required);
+
+static llvm::cl::opt<std::string>
+    database("d", llvm::cl::desc("Hip-analyzer database"),
+             llvm::cl::value_desc("database"),
+             llvm::cl::init(hip::default_database));
+
+static llvm::cl::opt<double>
+    z_threshold("z", llvm::cl::desc("Significance threshold (z-score)"),
+                llvm::cl::value_desc("z"), llvm::cl::init(3.));
+
+static llvm::cl::opt<unsigned int>
+    top("n", llvm::cl::desc("Number of blocks and workgroups to report"),
+        llvm::cl::value_desc("count"), llvm::cl::init(20u));
+
+static llvm::cl::opt<unsigned int>
+    chunk_mb("chunk", llvm::cl::desc("Chunk size per trace, in MiB"),
+             llvm::cl::value_desc("MiB"), llvm::cl::init(64u));
+
+int main(int argc, char** argv) {
+    llvm::cl::ParseCommandLineOptions(argc, argv);
+
+    auto kernel_info = hip::KernelInfo::fromJson(kernel_geometry.getValue());
+
+    // No Instrumenter : it would allocate the whole trace
+    auto blocks = hip::BasicBlock::fromJsonArray(database.getValue());
+
+    hip::TraceChunkReader reader_a(trace_a.getValue());
+    hip::TraceChunkReader reader_b(trace_b.getValue());
+
+    if (reader_a.size() != kernel_info.instr_size ||
+        reader_b.size() != kernel_info.instr_size) {
+        throw std::runtime_error("Traces incompatible with the kernel info");
+    }
+
+    // Chunks of whole workgroups
+    auto workgroup_size =
+        static_cast<size_t>(kernel_info.total_threads_per_blocks) *
+        kernel_info.basic_blocks;
+    auto chunk_workgroups = std::max<size_t>(
+        (static_cast<size_t>(chunk_mb.getValue()) << 20) / workgroup_size, 1u);
+
+    std::vector<uint8_t> chunk_a(chunk_workgroups * workgroup_size);
+    std::vector<uint8_t> chunk_b(chunk_workgroups * workgroup_size);
+
+    hip::TraceDiff diff(kernel_info.basic_blocks,
+                        kernel_info.total_threads_per_blocks, blocks);
+
+    while (true) {
+        auto read_a = reader_a.read(chunk_a.data(), chunk_a.size());
+        auto read_b = reader_b.read(chunk_b.data(), chunk_b.size());
+
+        if (read_a != read_b) {
+            throw std::runtime_error("Traces of different sizes");
+        } else if (read_a == 0u) {
+            break;
+        }
+
+        diff.addWorkgroups(chunk_a.data(), chunk_b.data(),
+                           read_a / workgroup_size);
+    }
+
+    // Basic blocks
+
+    auto significant = diff.significantBlocks(z_threshold.getValue());
+    std::cout << significant.size()
+              << " basic blocks changed significantly (|z| >= "
+              << z_threshold.getValue() << ")\n";
+
+    for (auto i = 0u; i < std::min<size_t>(significant.size(), top); ++i) {
+        const auto& block = significant[i];
+        std::cout << "  " << block.id << " : " << block.count_a << " -> "
+                  << block.count_b << " (" << (block.delta() > 0 ? "+" : "")
+                  << block.delta() << "), flops "
+                  << (block.flops_delta > 0 ? "+" : "") << block.flops_delta
+                  << ", z = " << block.z << '\n';
+    }
+
+    // Workgroups
+
+    auto workgroups = diff.workgroups();
+    std::stable_sort(workgroups.begin(), workgroups.end(),
+                     [](const auto& l, const auto& r) {
+                         return std::abs(l.flops_delta) >
+                                std::abs(r.flops_delta);
+                     });
+
+    std::cout << "\nWorkgroups with the largest flop changes :\n";
+    for (auto i = 0u; i < std::min<size_t>(workgroups.size(), top); ++i) {
+        const auto& wg = workgroups[i];
+        if (wg.flops_delta == 0) {
+            break;
+        }
+
+        std::cout << "  " << wg.workgroup << " : "
+                  << (wg.flops_delta > 0 ? "+" : "") << wg.flops_delta
+                  << " flops, z = " << wg.z << '\n';
+    }
+}